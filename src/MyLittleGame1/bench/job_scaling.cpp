@@ -0,0 +1,198 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Measures how the shared job system scales from 1 to N threads on a
+// few workloads shaped like the engine's: a wide particle style loop,
+// many tiny chunks (scheduling overhead), a fan-out/fan-in graph built
+// from dependency counters and continuations, and ParticleGenerator
+// itself, whose output is also checked to be identical for every
+// thread count.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#include "job_system.h"
+#include "particle_generator.h"
+
+
+// Number of timed repetitions per measurement (the best one is reported)
+const GLuint REPETITIONS = 5;
+
+// Structure of arrays resembling a large particle pool
+struct ParticleArrays {
+	std::vector<GLfloat> PosX, PosY, VelX, VelY, Alpha, Life;
+
+	ParticleArrays(GLuint count)
+		: PosX(count, 0.0f), PosY(count, 0.0f), VelX(count, 1.0f), VelY(count, -2.0f), Alpha(count, 1.0f), Life(count, 0.0f)
+	{
+		for (GLuint i = 0; i < count; ++i)
+			this->Life[i] = (i % 100) / 50.0f;
+	}
+};
+
+double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Integrates every particle a number of times using a parallel loop
+double particleLoop(ParticleArrays &p, GLuint iterations)
+{
+	const GLfloat dt = 0.016f;
+	GLuint count = static_cast<GLuint>(p.Life.size());
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (GLuint it = 0; it < iterations; ++it)
+	{
+		JobSystem::ParallelFor(count, 16384, [&](GLuint begin, GLuint end) {
+			for (GLuint i = begin; i < end; ++i)
+			{
+				p.Life[i] -= dt;
+				if (p.Life[i] <= 0.0f)
+					p.Life[i] += 2.0f;
+				p.PosX[i] -= p.VelX[i] * dt;
+				p.PosY[i] -= p.VelY[i] * dt;
+				p.Alpha[i] = std::max(0.0f, p.Alpha[i] - dt * 2.5f) + std::sqrt(p.Life[i]) * 0.001f;
+			}
+		});
+	}
+	return elapsedMs(start);
+}
+
+// Many small chunks; dominated by scheduling and stealing overhead
+double tinyChunks(std::vector<GLuint> &values, GLuint iterations)
+{
+	GLuint count = static_cast<GLuint>(values.size());
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (GLuint it = 0; it < iterations; ++it)
+	{
+		JobSystem::ParallelFor(count, 64, [&](GLuint begin, GLuint end) {
+			for (GLuint i = begin; i < end; ++i)
+				values[i] = values[i] * 1664525u + 1013904223u;
+		});
+	}
+	return elapsedMs(start);
+}
+
+// Stage A fans out into independent jobs, stage B runs as continuations of A
+double fanOutFanIn(GLuint width, GLuint iterations)
+{
+	std::vector<double> partial(width, 0.0);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (GLuint it = 0; it < iterations; ++it)
+	{
+		JobCounter stageA, stageB;
+		for (GLuint i = 0; i < width; ++i)
+		{
+			JobSystem::Run([&partial, i]() {
+				double sum = 0.0;
+				for (GLuint k = 1; k < 20000; ++k)
+					sum += std::sin(static_cast<double>(k * (i + 1)));
+				partial[i] = sum;
+			}, &stageA);
+		}
+		for (GLuint i = 0; i < width; ++i)
+			JobSystem::RunAfter(stageA, [&partial, i]() { partial[i] = std::sqrt(std::fabs(partial[i])); }, &stageB);
+		JobSystem::Wait(stageB);
+	}
+	return elapsedMs(start);
+}
+
+// Runs a large ParticleGenerator with a brick-shatter sized emission every update
+double particleGenerator(GLuint amount, GLuint iterations, GLuint64 &checksum)
+{
+	Shader shader; // never used, updates need no GL context
+	ParticleGenerator generator(shader, TextureView(), amount, 42);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (GLuint it = 0; it < iterations; ++it)
+	{
+		generator.Emit(glm::vec2(400.0f, 300.0f), glm::vec2(100.0f, -350.0f), amount / 40, glm::vec2(6.25f));
+		generator.Update(0.016f);
+	}
+	double ms = elapsedMs(start);
+	// FNV-1a over the raw particle state
+	checksum = 14695981039346656037ull;
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(generator.Particles().data());
+	for (size_t i = 0; i < generator.Particles().size() * sizeof(Particle); ++i)
+		checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+	return ms;
+}
+
+// Emits growing bursts that outnumber the dead particles, so live ones get recycled while part of the pool
+// is dead, and checks every spawn happens
+GLboolean saturatedSpawns(GLuint amount, GLuint iterations)
+{
+	Shader shader;
+	ParticleGenerator generator(shader, TextureView(), amount, 7);
+	const GLfloat dt = 0.016f;
+	for (GLuint it = 0; it < iterations; ++it)
+	{
+		// A burst every 40 updates, so earlier bursts are partly dead by then (particles live ~62 updates)
+		GLuint requested = it % 40 == 0 ? amount / 2 + it / 40 * (amount / 8) : 0;
+		generator.Emit(glm::vec2(400.0f, 300.0f), glm::vec2(100.0f, -350.0f), requested / 2);
+		generator.Emit(glm::vec2(200.0f, 100.0f), glm::vec2(-100.0f, 350.0f), requested - requested / 2);
+		generator.Update(dt);
+		// Particles spawned by this update are the only ones left with a full life minus one step
+		GLuint fresh = 0;
+		for (const Particle &particle : generator.Particles())
+			fresh += particle.Life == 1.0f - dt;
+		if (fresh != std::min(requested, amount))
+			return GL_FALSE;
+	}
+	return GL_TRUE;
+}
+
+template <typename Fn>
+double best(Fn fn)
+{
+	double result = fn();
+	for (GLuint i = 1; i < REPETITIONS; ++i)
+		result = std::min(result, fn());
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	GLuint maxThreads = argc > 1 ? static_cast<GLuint>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+	ParticleArrays particles(1 << 21);
+	std::vector<GLuint> values(1 << 18, 1u);
+
+	std::cout << "threads  particles(ms) speedup  tiny(ms) speedup  graph(ms) speedup  generator(ms) speedup" << std::endl;
+	double base[4] = { 0.0, 0.0, 0.0, 0.0 };
+	GLuint64 baseChecksum = 0, checksum = 0;
+	GLboolean deterministic = GL_TRUE, saturated = GL_TRUE;
+	for (GLuint threads = 1; threads <= maxThreads; ++threads)
+	{
+		JobSystem::Init(threads);
+		double times[4] = {
+			best([&]() { return particleLoop(particles, 20); }),
+			best([&]() { return tinyChunks(values, 20); }),
+			best([&]() { return fanOutFanIn(256, 4); }),
+			best([&]() { return particleGenerator(1 << 20, 20, checksum); })
+		};
+		saturated = saturated && saturatedSpawns(3 * 4096 + 1000, 240);
+		JobSystem::Shutdown();
+		if (threads == 1)
+		{
+			std::copy(times, times + 4, base);
+			baseChecksum = checksum;
+		}
+		deterministic = deterministic && checksum == baseChecksum;
+		std::cout << std::setw(7) << threads << std::fixed << std::setprecision(2);
+		for (GLuint i = 0; i < 4; ++i)
+			std::cout << std::setw(12) << times[i] << std::setw(8) << base[i] / times[i] << "x";
+		std::cout << std::endl;
+	}
+	std::cout << "particle state identical across thread counts: " << (deterministic ? "yes" : "NO") << std::endl;
+	std::cout << "every spawn placed with the pool exhausted: " << (saturated ? "yes" : "NO") << std::endl;
+	return deterministic && saturated ? 0 : 1;
+}
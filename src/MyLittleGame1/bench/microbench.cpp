@@ -0,0 +1,504 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Microbenchmarks for the engine's hot functions. Every benchmark is
+// warmed up, then timed over a number of repetitions; each repetition
+// runs enough iterations to last at least MIN_SAMPLE_MS. The summary
+// (min, median, mean, standard deviation, p90, max in nanoseconds per
+// operation) is printed as a table and can be written as JSON to
+// compare results between commits:
+//
+//   littleGame_bench [filter] [--json <file>] [--label <text>] [--repetitions N] [--threads N]
+//
+// Only benchmarks whose name contains filter are run.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "root_directory.h"
+#include "collision.h"
+#include "autopilot.h"
+#include "game.h"
+#include "frame_arena.h"
+#include "game_level.h"
+#include "game_systems.h"
+#include "job_system.h"
+#include "level_generator.h"
+#include "metrics.h"
+#include "particle_generator.h"
+#include "rewind_buffer.h"
+#include "sim_state.h"
+#include "random.h"
+
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Time spent warming up each benchmark before measuring
+const double WARMUP_MS = 100.0;
+// Minimum duration of one timed repetition
+const double MIN_SAMPLE_MS = 10.0;
+
+// Results are folded into this so the compiler cannot drop the benchmarked work
+volatile GLuint64 Sink = 0;
+
+// Summary of one benchmark, times in nanoseconds per operation
+struct BenchResult {
+	std::string         Name;
+	GLuint              ItemsPerOp;   // e.g. particles per Update, for per-item throughput
+	GLuint64            Iterations;   // operations per repetition
+	std::vector<double> Samples;
+	double Min, Median, Mean, StdDev, P90, Max;
+};
+
+struct BenchSettings {
+	std::string Filter;
+	GLuint      Repetitions;
+};
+
+std::vector<BenchResult> Results;
+
+double elapsedMs(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void summarize(BenchResult &result)
+{
+	std::vector<double> sorted(result.Samples);
+	std::sort(sorted.begin(), sorted.end());
+	size_t count = sorted.size();
+	result.Min = sorted.front();
+	result.Max = sorted.back();
+	result.Median = count % 2 ? sorted[count / 2] : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+	result.P90 = sorted[std::min(count - 1, static_cast<size_t>(std::ceil(0.9 * count)) - 1)];
+	double sum = 0.0;
+	for (double sample : sorted)
+		sum += sample;
+	result.Mean = sum / count;
+	double variance = 0.0;
+	for (double sample : sorted)
+		variance += (sample - result.Mean) * (sample - result.Mean);
+	result.StdDev = count > 1 ? std::sqrt(variance / (count - 1)) : 0.0;
+}
+
+// Runs fn(iterations) under the harness; fn performs `iterations` operations
+template <typename Fn>
+void bench(const BenchSettings &settings, const std::string &name, GLuint itemsPerOp, Fn fn)
+{
+	if (name.find(settings.Filter) == std::string::npos)
+		return;
+	// Warm up while finding an iteration count that fills MIN_SAMPLE_MS
+	GLuint64 iterations = 1;
+	Clock::time_point warmupStart = Clock::now();
+	while (true)
+	{
+		Clock::time_point start = Clock::now();
+		fn(iterations);
+		double ms = elapsedMs(start);
+		if (ms >= MIN_SAMPLE_MS && elapsedMs(warmupStart) >= WARMUP_MS)
+			break;
+		if (ms < MIN_SAMPLE_MS)
+			iterations = ms > 0.0 ? std::max(iterations + 1, static_cast<GLuint64>(iterations * MIN_SAMPLE_MS * 1.2 / ms)) : iterations * 10;
+	}
+	BenchResult result;
+	result.Name = name;
+	result.ItemsPerOp = itemsPerOp;
+	result.Iterations = iterations;
+	for (GLuint i = 0; i < settings.Repetitions; ++i)
+	{
+		Clock::time_point start = Clock::now();
+		fn(iterations);
+		result.Samples.push_back(elapsedMs(start) * 1.0e6 / iterations);
+	}
+	summarize(result);
+	std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(14) << result.Min << std::setw(14) << result.Median << std::setw(14) << result.Mean
+		<< std::setw(10) << (result.Mean > 0.0 ? 100.0 * result.StdDev / result.Mean : 0.0) << "%"
+		<< std::setw(14) << result.P90 << std::setw(12) << iterations << std::endl;
+	Results.push_back(result);
+}
+
+GLboolean writeJson(const char *file, const std::string &label)
+{
+	std::ofstream out(file);
+	if (!out)
+	{
+		std::cout << "ERROR::BENCH: Failed to open " << file << " for writing" << std::endl;
+		return GL_FALSE;
+	}
+	out << std::setprecision(6) << std::fixed;
+	out << "{\n  \"label\": \"" << label << "\",\n  \"threads\": " << JobSystem::ThreadCount()
+		<< ",\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n";
+	for (size_t i = 0; i < Results.size(); ++i)
+	{
+		const BenchResult &r = Results[i];
+		out << "    {\"name\": \"" << r.Name << "\", \"items_per_op\": " << r.ItemsPerOp
+			<< ", \"iterations\": " << r.Iterations << ", \"repetitions\": " << r.Samples.size()
+			<< ", \"min\": " << r.Min << ", \"median\": " << r.Median << ", \"mean\": " << r.Mean
+			<< ", \"stddev\": " << r.StdDev << ", \"p90\": " << r.P90 << ", \"max\": " << r.Max
+			<< ", \"samples\": [";
+		for (size_t s = 0; s < r.Samples.size(); ++s)
+			out << (s ? ", " : "") << r.Samples[s];
+		out << "]}" << (i + 1 < Results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+	return out.good() ? GL_TRUE : GL_FALSE;
+}
+
+
+// Random boxes and balls in an 800x600 field, sized like bricks and balls so roughly a third of the pairs overlap
+struct CollisionInputs {
+	static const GLuint COUNT = 1024;
+	std::vector<Transform> Boxes, Balls;
+	std::vector<glm::vec2> Directions;
+
+	CollisionInputs()
+	{
+		Random random(7);
+		for (GLuint i = 0; i < COUNT; ++i)
+		{
+			this->Boxes.push_back(Transform(glm::vec2(random.Range(0.0f, 100.0f), random.Range(0.0f, 100.0f)), glm::vec2(53.0f, 25.0f)));
+			this->Balls.push_back(Transform(glm::vec2(random.Range(0.0f, 100.0f), random.Range(0.0f, 100.0f)), glm::vec2(BALL_RADIUS * 2)));
+			this->Directions.push_back(glm::vec2(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f)));
+		}
+	}
+};
+
+void collisionBenchmarks(const BenchSettings &settings)
+{
+	CollisionInputs inputs;
+	const GLuint mask = CollisionInputs::COUNT - 1;
+	bench(settings, "CheckCollision/aabb-aabb", 1, [&](GLuint64 iterations) {
+		GLuint64 hits = 0;
+		for (GLuint64 i = 0; i < iterations; ++i)
+			hits += CheckCollision(inputs.Boxes[i & mask], inputs.Boxes[(i * 7 + 3) & mask]);
+		Sink += hits;
+	});
+	bench(settings, "CheckCollision/circle-aabb", 1, [&](GLuint64 iterations) {
+		GLuint64 hits = 0;
+		for (GLuint64 i = 0; i < iterations; ++i)
+			hits += std::get<0>(CheckCollision(inputs.Balls[i & mask], BALL_RADIUS, inputs.Boxes[(i * 7 + 3) & mask]));
+		Sink += hits;
+	});
+	bench(settings, "CheckCollision/circle-circle", 1, [&](GLuint64 iterations) {
+		GLuint64 hits = 0;
+		for (GLuint64 i = 0; i < iterations; ++i)
+			hits += std::get<0>(CheckCollision(inputs.Balls[i & mask], BALL_RADIUS, inputs.Balls[(i * 7 + 3) & mask], BALL_RADIUS));
+		Sink += hits;
+	});
+	bench(settings, "VectorDirection", 1, [&](GLuint64 iterations) {
+		GLuint64 sum = 0;
+		for (GLuint64 i = 0; i < iterations; ++i)
+			sum += VectorDirection(inputs.Directions[i & mask]);
+		Sink += sum;
+	});
+}
+
+void levelBenchmarks(const BenchSettings &settings)
+{
+	std::string small = std::string(logl_root) + "/src/MyLittleGame1/levels/one.lvl";
+	GameLevel level;
+	bench(settings, "GameLevel::Load/small", 1, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			level.Load(small.c_str(), 800, 300);
+		Sink += level.Tiles.size();
+	});
+	Registry registry;
+	bench(settings, "GameLevel::Spawn/small", 1, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+		{
+			registry.DestroyAll(COMPONENT_BRICK);
+			level.Spawn(registry);
+		}
+		Sink += registry.Count(COMPONENT_BRICK);
+	});
+	if (level.Tiles.empty())
+		std::cout << "  (" << small << " not found, small level benchmarks measured an empty level)" << std::endl;
+	// The 512x512 noise level of the benchmark dataset, written out so Load parses a real file
+	std::string huge = "bench_generated.lvl";
+	for (const DatasetLevel &dataset : LevelGenerator::Dataset())
+		if (dataset.Name == "noise-512x512")
+			LevelGenerator::Generate(dataset.Spec, level, 800, 300);
+	level.Save(huge.c_str());
+	bench(settings, "GameLevel::Load/huge-512x512", 512 * 512, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			level.Load(huge.c_str(), 800, 300);
+		Sink += level.Tiles.size();
+	});
+	bench(settings, "GameLevel::Spawn/huge-512x512", 512 * 512, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+		{
+			registry.DestroyAll(COMPONENT_BRICK);
+			level.Spawn(registry);
+		}
+		Sink += registry.Count(COMPONENT_BRICK);
+	});
+	std::remove(huge.c_str());
+	// Generation of every dataset level, per tile
+	std::vector<GLuint> tiles;
+	for (const DatasetLevel &dataset : LevelGenerator::Dataset())
+	{
+		bench(settings, "LevelGenerator::Generate/" + dataset.Name, static_cast<GLuint>(dataset.Spec.Tiles()), [&](GLuint64 iterations) {
+			for (GLuint64 i = 0; i < iterations; ++i)
+				LevelGenerator::Generate(dataset.Spec, tiles);
+			Sink += tiles.size();
+		});
+	}
+}
+
+void particleBenchmarks(const BenchSettings &settings)
+{
+	const GLuint pools[] = { 500, 10000, 100000, 1000000 };
+	for (GLuint amount : pools)
+	{
+		Shader shader; // never used, updates need no GL context
+		ParticleGenerator generator(shader, TextureView(), amount, 42);
+		bench(settings, "ParticleGenerator::Update/" + std::to_string(amount), amount, [&](GLuint64 iterations) {
+			for (GLuint64 i = 0; i < iterations; ++i)
+			{
+				// Emission rate of a few dozen balls, scaled with the pool
+				generator.Emit(glm::vec2(400.0f, 300.0f), glm::vec2(100.0f, -350.0f), std::max(2u, amount / 100), glm::vec2(6.25f));
+				generator.Update(TICK_DURATION);
+			}
+			Sink += static_cast<GLuint64>(generator.Particles()[0].Life * 1000.0f);
+		});
+	}
+}
+
+void ballBenchmarks(const BenchSettings &settings)
+{
+	// A single ball bouncing around; the stand-in for the former BallObject::Move
+	Transform transform(glm::vec2(400.0f, 300.0f), glm::vec2(BALL_RADIUS * 2));
+	Velocity velocity(INITIAL_BALL_VELOCITY);
+	Ball ball;
+	ball.Stuck = GL_FALSE;
+	bench(settings, "MoveBall", 1, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			MoveBall(transform, velocity, ball, TICK_DURATION, 800);
+		Sink += static_cast<GLuint64>(transform.Position.x);
+	});
+	// Every ball of a stress test at once
+	const GLuint count = 10000;
+	Registry registry;
+	Random random(3);
+	for (GLuint i = 0; i < count; ++i)
+	{
+		Entity entity = registry.Create(BALL_ARCHETYPE);
+		registry.Get<Transform>(entity) = Transform(glm::vec2(random.Range(0.0f, 775.0f), random.Range(0.0f, 575.0f)), glm::vec2(BALL_RADIUS * 2));
+		registry.Get<Velocity>(entity) = Velocity(glm::vec2(random.Range(-300.0f, 300.0f), random.Range(-300.0f, 300.0f)));
+		registry.Get<Ball>(entity).Stuck = GL_FALSE;
+	}
+	bench(settings, "MoveSystem/" + std::to_string(count), count, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			MoveSystem(registry, TICK_DURATION, 800);
+		Sink += registry.Count(COMPONENT_BALL);
+	});
+}
+
+// A frame's worth of short-lived vectors, from the heap and from a frame arena
+void arenaBenchmarks(const BenchSettings &settings)
+{
+	const GLuint VECTORS = 64, ITEMS = 32;
+	bench(settings, "TransientVectors/heap", VECTORS, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			for (GLuint v = 0; v < VECTORS; ++v)
+			{
+				std::vector<Entity> entities;
+				for (GLuint e = 0; e < ITEMS; ++e)
+					entities.push_back(Entity(e, v));
+				Sink += entities.back().Index;
+			}
+	});
+	FrameArena frames;
+	bench(settings, "TransientVectors/frame-arena", VECTORS, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+		{
+			frames.BeginFrame();
+			for (GLuint v = 0; v < VECTORS; ++v)
+			{
+				ArenaVector<Entity> entities((ArenaAllocator<Entity>(frames.Current())));
+				for (GLuint e = 0; e < ITEMS; ++e)
+					entities.push_back(Entity(e, v));
+				Sink += entities.back().Index;
+			}
+		}
+	});
+}
+
+// Recording ticks into a rewind buffer and seeking back to them, with the state of a game in play
+void rewindBenchmarks(const BenchSettings &settings)
+{
+	Game game(800, 600);
+	game.Seed = 42;
+	game.Init(GL_TRUE);
+	GameLevel level;
+	level.Load((std::string(logl_root) + "/src/MyLittleGame1/levels/one.lvl").c_str(), 800, 300);
+	game.Levels.assign(1, level);
+	game.ResetLevel();
+	game.SpawnBalls(8);
+	// A second's worth of consecutive ticks, recorded over and over
+	const GLuint TICKS = 60;
+	std::vector<StateImage> images(TICKS);
+	for (StateImage &image : images)
+	{
+		game.Update(TICK_DURATION);
+		StateWriter writer(image);
+		game.SaveState(writer);
+	}
+	RewindBuffer buffer(64 << 20);
+	GLuint64 tick = 0;
+	bench(settings, "RewindBuffer::Record", 1, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i, ++tick)
+			buffer.Record(tick, images[tick % TICKS]);
+		Sink += buffer.Bytes();
+	});
+	if (!buffer.Empty())
+		std::cout << "  (" << images[0].size() << " byte images, " << buffer.Bytes() / (buffer.LastTick() - buffer.FirstTick() + 1)
+			<< " bytes per buffered tick)" << std::endl;
+	StateImage image;
+	Random random(7);
+	bench(settings, "RewindBuffer::Seek", 1, [&](GLuint64 iterations) {
+		GLuint64 span = buffer.LastTick() - buffer.FirstTick() + 1;
+		for (GLuint64 i = 0; i < iterations; ++i)
+			buffer.Seek(buffer.FirstTick() + random.Next() % span, image);
+		Sink += image.size();
+	});
+	// Restoring the whole game, as a player scrubbing backwards does
+	game.History.SetBudget(64 << 20);
+	for (GLuint i = 0; i < TICKS * 10; ++i)
+		game.Update(TICK_DURATION);
+	bench(settings, "Game::Rewind", 1, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			game.Rewind(game.History.LastTick() - i % (TICKS * 10));
+		Sink += game.Ticks;
+	});
+}
+
+// Forking the simulation state and running each fork 30 ticks ahead, on a shipped level and on a huge one
+void lookaheadBenchmarks(const BenchSettings &settings)
+{
+	const GLuint AHEAD = 30;
+	GameLevel small, huge;
+	small.Load((std::string(logl_root) + "/src/MyLittleGame1/levels/one.lvl").c_str(), 800, 300);
+	for (const DatasetLevel &dataset : LevelGenerator::Dataset())
+		if (dataset.Name == "noise-512x512")
+			LevelGenerator::Generate(dataset.Spec, huge, 800, 300);
+	std::vector<std::pair<std::string, GameLevel *>> levels = { { "small", &small }, { "huge-512x512", &huge } };
+	for (const std::pair<std::string, GameLevel *> &level : levels)
+	{
+		Game game(800, 600);
+		game.Init(GL_TRUE);
+		game.PlayLevel(*level.second);
+		game.SpawnBalls(3);
+		SimState root;
+		root.Capture(game);
+		bench(settings, "SimState::Fork/" + level.first, 1, [&](GLuint64 iterations) {
+			for (GLuint64 i = 0; i < iterations; ++i)
+			{
+				SimState fork = root;
+				Sink += fork.BallCount;
+			}
+		});
+		bench(settings, "SimState::Lookahead/" + level.first, 1, [&](GLuint64 iterations) {
+			for (GLuint64 i = 0; i < iterations; ++i)
+			{
+				SimState fork = root;
+				for (GLuint tick = 0; tick < AHEAD; ++tick)
+					fork.Step(i & 1, i & 2, GL_TRUE);
+				Sink += fork.BricksLeft;
+			}
+		});
+	}
+}
+
+// Per-tick cost of the autopilot deciding on the keys, on a small and a huge level with four balls in flight
+void autopilotBenchmarks(const BenchSettings &settings)
+{
+	GameLevel small, huge;
+	small.Load((std::string(logl_root) + "/src/MyLittleGame1/levels/one.lvl").c_str(), 800, 300);
+	for (const DatasetLevel &dataset : LevelGenerator::Dataset())
+		if (dataset.Name == "noise-512x512")
+			LevelGenerator::Generate(dataset.Spec, huge, 800, 300);
+	std::vector<std::pair<std::string, GameLevel *>> levels = { { "small", &small }, { "huge-512x512", &huge } };
+	for (const std::pair<std::string, GameLevel *> &level : levels)
+	{
+		Game game(800, 600);
+		game.Init(GL_TRUE);
+		game.PlayLevel(*level.second);
+		game.SpawnBalls(3);
+		Autopilot autopilot;
+		bench(settings, "Autopilot::Apply/" + level.first, 1, [&](GLuint64 iterations) {
+			for (GLuint64 i = 0; i < iterations; ++i)
+			{
+				autopilot.Apply(game);
+				Sink += game.Keys[GLFW_KEY_A];
+			}
+		});
+	}
+}
+
+// Cost of recording into the per-thread metric shards
+void metricsBenchmarks(const BenchSettings &settings)
+{
+	MetricId counter = Metrics::RegisterCounter("bench_counter");
+	MetricId histogram = Metrics::RegisterHistogram("bench_histogram");
+	bench(settings, "Metrics::Add", 1, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			Metrics::Add(counter);
+	});
+	bench(settings, "Metrics::Record", 1, [&](GLuint64 iterations) {
+		for (GLuint64 i = 0; i < iterations; ++i)
+			Metrics::Record(histogram, i & 0xFFFF);
+	});
+	Metrics::Collect();
+}
+
+int main(int argc, char *argv[])
+{
+	BenchSettings settings;
+	settings.Repetitions = 20;
+	const char *jsonFile = nullptr;
+	std::string label = "";
+	GLuint threads = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonFile = argv[++i];
+		else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc)
+			label = argv[++i];
+		else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+			settings.Repetitions = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = static_cast<GLuint>(std::atoi(argv[++i]));
+		else
+			settings.Filter = argv[i];
+	}
+	JobSystem::Init(threads);
+	std::cout << std::left << std::setw(40) << "benchmark (ns/op)" << std::right << std::setw(14) << "min" << std::setw(14) << "median"
+		<< std::setw(14) << "mean" << std::setw(11) << "rsd" << std::setw(14) << "p90" << std::setw(12) << "iterations" << std::endl;
+	collisionBenchmarks(settings);
+	levelBenchmarks(settings);
+	particleBenchmarks(settings);
+	ballBenchmarks(settings);
+	arenaBenchmarks(settings);
+	rewindBenchmarks(settings);
+	lookaheadBenchmarks(settings);
+	autopilotBenchmarks(settings);
+	metricsBenchmarks(settings);
+	GLboolean ok = !jsonFile || writeJson(jsonFile, label);
+	JobSystem::Shutdown();
+	return ok ? 0 : 1;
+}
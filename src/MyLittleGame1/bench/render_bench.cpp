@@ -0,0 +1,306 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Offscreen rendering benchmark. Creates a context that needs no display
+// (surfaceless EGL, e.g. Mesa llvmpipe, or a hidden GLFW window), renders
+// synthetic scenes into a RenderTarget through SpriteRenderer and
+// ParticleGenerator, and reports milliseconds and draw calls per frame:
+//
+//   littleGame_render_bench [filter] [--frames N] [--scale F] [--json <file>]
+//
+// Scenes: 1k/10k/100k sprites, 10k/100k particles and every shipped level
+// drawn by Game::Render, once with its cached layers (background and
+// bricks) and once drawing everything every frame (uncached/level/*).
+// level/endless is the endless mode, ticked once per frame so its rows
+// scroll and the brick layer is redrawn every frame. level/camera/* play
+// dataset levels far larger than the screen at a fixed tile size, the
+// camera panning across them every frame; culling keeps their cost at
+// what fits on the screen.
+// With --scale the levels are also drawn at that fraction of the
+// resolution through ResolutionScaler and stretched back up (the
+// scaled/level/* scenes). Each frame ends with glFinish, so the time covers
+// the GPU (or software rasterizer) work, not just command submission.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "root_directory.h"
+#include "game.h"
+#include "level_generator.h"
+#include "offscreen_context.h"
+#include "particle_generator.h"
+#include "random.h"
+#include "render_stats.h"
+#include "render_target.h"
+#include "resolution_scaler.h"
+#include "resource_manager.h"
+#include "sprite_renderer.h"
+
+
+const GLuint WIDTH = 800, HEIGHT = 600;
+// Untimed frames rendered before measuring each scene
+const GLuint WARMUP_FRAMES = 3;
+
+struct SceneResult {
+	std::string Name;
+	double      MeanMs, P50Ms, P95Ms, MaxMs;
+	GLuint      DrawCalls, Vertices;
+};
+
+std::string gamePath(const std::string &file)
+{
+	return std::string(logl_root) + "/src/MyLittleGame1/" + file;
+}
+
+// Renders frames of a scene into target and summarizes their timings
+SceneResult measure(const std::string &name, GLuint frames, RenderTarget &target, const std::function<void()> &draw)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	std::vector<double> times;
+	SceneResult result;
+	result.Name = name;
+	for (GLuint frame = 0; frame < WARMUP_FRAMES + frames; ++frame)
+	{
+		Clock::time_point start = Clock::now();
+		target.Bind();
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		RenderStats::Reset();
+		draw();
+		glFinish();
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		if (frame >= WARMUP_FRAMES)
+			times.push_back(ms);
+		result.DrawCalls = RenderStats::DrawCalls;
+		result.Vertices = RenderStats::Vertices;
+	}
+	double sum = 0.0;
+	for (double ms : times)
+		sum += ms;
+	std::sort(times.begin(), times.end());
+	result.MeanMs = sum / times.size();
+	result.P50Ms = times[times.size() / 2];
+	result.P95Ms = times[std::min(times.size() - 1, static_cast<size_t>(times.size() * 0.95))];
+	result.MaxMs = times.back();
+	std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(11) << result.MeanMs << std::setw(11) << result.P50Ms << std::setw(11) << result.P95Ms
+		<< std::setw(11) << result.MaxMs << std::setw(12) << result.DrawCalls << std::setw(12) << result.Vertices << std::endl;
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	GLuint frames = 30;
+	std::string filter = "";
+	GLfloat scale = 0.0f;
+	const char *jsonFile = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+			scale = static_cast<GLfloat>(std::atof(argv[++i]));
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonFile = argv[++i];
+		else
+			filter = argv[i];
+	}
+
+	OffscreenContext context;
+	if (!context.Create(WIDTH, HEIGHT))
+		return 2;
+	RenderTarget target;
+	if (!target.Generate(WIDTH, HEIGHT))
+		return 2;
+	// OpenGL configuration, as in the game
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// Resources, configured the same way Game::Init does
+	ResourceManager::LoadShader(gamePath("shaders/sprite.vs").c_str(), gamePath("shaders/sprite.frag").c_str(), nullptr, "sprite");
+	ResourceManager::LoadShader(gamePath("shaders/particle.vs").c_str(), gamePath("shaders/particle.frag").c_str(), nullptr, "particle");
+	glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(WIDTH), static_cast<GLfloat>(HEIGHT), 0.0f, -1.0f, 1.0f);
+	Shader &spriteShader = ResourceManager::GetShader("sprite");
+	Shader &particleShader = ResourceManager::GetShader("particle");
+	spriteShader.Use().SetInteger("image", 0);
+	spriteShader.SetMatrix4("projection", projection);
+	particleShader.Use().SetInteger("sprite", 0);
+	particleShader.SetMatrix4("projection", projection);
+	std::vector<std::string> files = { "textures/background.jpg", "textures/awesomeface.png", "textures/block.png",
+		"textures/block_solid.png", "textures/paddle.png", "textures/particle.png" };
+	std::vector<TextureRequest> textures = {
+		{ files[0].c_str(), GL_FALSE, "background" },
+		{ files[1].c_str(), GL_TRUE, "face" },
+		{ files[2].c_str(), GL_FALSE, "block" },
+		{ files[3].c_str(), GL_FALSE, "block_solid" },
+		{ files[4].c_str(), GL_TRUE, "paddle" },
+		{ files[5].c_str(), GL_TRUE, "particle" }
+	};
+	for (GLuint i = 0; i < files.size(); ++i)
+	{
+		files[i] = gamePath(files[i]);
+		textures[i].File = files[i].c_str();
+	}
+	ResourceManager::LoadTextures(textures);
+	SpriteRenderer renderer(spriteShader);
+
+	std::cout << "renderer: " << context.Renderer() << ", " << WIDTH << "x" << HEIGHT << ", " << frames << " frames per scene" << std::endl;
+	std::cout << std::left << std::setw(24) << "scene" << std::right << std::setw(11) << "mean(ms)" << std::setw(11) << "p50(ms)"
+		<< std::setw(11) << "p95(ms)" << std::setw(11) << "max(ms)" << std::setw(12) << "draws" << std::setw(12) << "vertices" << std::endl;
+	std::vector<SceneResult> results;
+
+	// Sprites: random bricks, balls and paddles all over the screen
+	const GLuint spriteCounts[] = { 1000, 10000, 100000 };
+	const char *spriteTextures[] = { "block", "block_solid", "face", "paddle" };
+	for (GLuint count : spriteCounts)
+	{
+		std::string name = "sprites/" + std::to_string(count);
+		if (name.find(filter) == std::string::npos)
+			continue;
+		struct SpriteInstance { TextureView Texture; glm::vec2 Position, Size; GLfloat Rotation; glm::vec3 Color; };
+		std::vector<SpriteInstance> sprites(count);
+		Random random(count);
+		for (SpriteInstance &sprite : sprites)
+		{
+			sprite.Texture = ResourceManager::GetTexture(HashedName(spriteTextures[random.Next() % 4]));
+			sprite.Position = glm::vec2(random.Range(-20.0f, WIDTH), random.Range(-20.0f, HEIGHT));
+			sprite.Size = glm::vec2(random.Range(10.0f, 60.0f), random.Range(10.0f, 30.0f));
+			sprite.Rotation = random.Range(0.0f, 6.28f);
+			sprite.Color = glm::vec3(random.NextFloat(), random.NextFloat(), random.NextFloat());
+		}
+		results.push_back(measure(name, frames, target, [&]() {
+			for (SpriteInstance &sprite : sprites)
+				renderer.DrawSprite(sprite.Texture, sprite.Position, sprite.Size, sprite.Rotation, sprite.Color);
+		}));
+	}
+
+	// Particles: a full pool, all alive
+	const GLuint particleCounts[] = { 10000, 100000 };
+	for (GLuint count : particleCounts)
+	{
+		std::string name = "particles/" + std::to_string(count);
+		if (name.find(filter) == std::string::npos)
+			continue;
+		ParticleGenerator particles(ResourceManager::GetShader("particle"), ResourceManager::GetTexture("particle"), count, 1);
+		particles.Emit(glm::vec2(WIDTH / 2, HEIGHT / 2), glm::vec2(0.0f), count, glm::vec2(0.0f));
+		particles.Update(0.0f);
+		results.push_back(measure(name, frames, target, [&]() { particles.Draw(); }));
+	}
+
+	// Levels: the real Game::Render path with a level, paddle, ball and particle trail
+	const char *levels[] = { "one", "two", "three", "four", "endless", "camera/noise-64x32", "camera/noise-512x512" };
+	for (const char *levelName : levels)
+	{
+		std::string name = std::string("level/") + levelName;
+		GLboolean native = name.find(filter) != std::string::npos;
+		GLboolean uncached = ("uncached/" + name).find(filter) != std::string::npos;
+		GLboolean scaled = scale > 0.0f && ("scaled/" + name).find(filter) != std::string::npos;
+		if (!native && !uncached && !scaled)
+			continue;
+		Game game(WIDTH, HEIGHT);
+		game.Renderer = new SpriteRenderer(spriteShader);
+		game.Particles = new ParticleGenerator(particleShader, ResourceManager::GetTexture("particle"), 500, 1);
+		GameLevel level;
+		GLboolean endless = std::strcmp(levelName, "endless") == 0;
+		GLboolean camera = std::strncmp(levelName, "camera/", 7) == 0;
+		if (camera)
+		{
+			for (const DatasetLevel &dataset : LevelGenerator::Dataset())
+				if (dataset.Name == levelName + 7)
+					LevelGenerator::Generate(dataset.Spec, level, WIDTH, HEIGHT / 2);
+		}
+		else if (!endless)
+			level.Load(gamePath(std::string("levels/") + levelName + ".lvl").c_str(), WIDTH, HEIGHT / 2);
+		game.Levels.push_back(level);
+		game.Level = 0;
+		game.BackgroundTexture = ResourceManager::FindTexture("background");
+		game.PaddleTexture = ResourceManager::FindTexture("paddle");
+		game.BallTexture = ResourceManager::FindTexture("face");
+		game.BlockTexture = ResourceManager::FindTexture("block");
+		game.SolidBlockTexture = ResourceManager::FindTexture("block_solid");
+		game.Player = game.Entities.Create(PADDLE_ARCHETYPE);
+		game.Entities.Get<Sprite>(game.Player) = Sprite(ResourceManager::GetTexture(game.PaddleTexture));
+		if (endless)
+		{
+			LevelSpec rows = ENDLESS_LEVEL;
+			rows.Seed = 1;
+			game.PlayEndless(rows);
+		}
+		else if (camera)
+			game.PlayLevel(level);
+		else
+			game.ResetLevel();
+		game.ResetPlayer();
+		// Launch the ball and let the trail build up
+		game.Keys[GLFW_KEY_SPACE] = GL_TRUE;
+		for (GLuint tick = 0; tick < 120; ++tick)
+		{
+			game.ProcessInput(TICK_DURATION);
+			game.Update(TICK_DURATION);
+		}
+		// The endless rows keep scrolling while they are drawn, the camera pans along the bricks
+		GLfloat pan = 0.0f;
+		std::function<void()> frame = [&]() {
+			if (endless)
+				game.Update(TICK_DURATION);
+			if (camera)
+			{
+				pan = std::fmod(pan + 37.0f, static_cast<GLfloat>(game.Width));
+				game.View.CenterOn(glm::vec2(pan, game.Height * 0.25f));
+			}
+			game.Render();
+		};
+		if (native)
+			results.push_back(measure(name, frames, target, frame));
+		if (uncached)
+		{
+			game.StaticLayer.Enabled = game.BrickLayer.Enabled = GL_FALSE;
+			results.push_back(measure("uncached/" + name, frames, target, frame));
+			game.StaticLayer.Enabled = game.BrickLayer.Enabled = GL_TRUE;
+		}
+		if (scaled)
+		{
+			// Pinned to the requested scale, the controller has no room to move
+			ResolutionScaler scaler(0.0f, scale, scale);
+			if (!scaler.Init(WIDTH, HEIGHT))
+				return 2;
+			results.push_back(measure("scaled/" + name, frames, target, [&]() {
+				scaler.Begin();
+				glClear(GL_COLOR_BUFFER_BIT);
+				frame();
+				scaler.End(0.0f, target.Framebuffer.ID());
+			}));
+		}
+	}
+
+	if (jsonFile)
+	{
+		std::ofstream out(jsonFile);
+		out << std::fixed << std::setprecision(4) << "{\n  \"renderer\": \"" << context.Renderer() << "\",\n  \"width\": " << WIDTH
+			<< ",\n  \"height\": " << HEIGHT << ",\n  \"frames\": " << frames << ",\n  \"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+			out << "    {\"name\": \"" << results[i].Name << "\", \"mean_ms\": " << results[i].MeanMs << ", \"p50_ms\": " << results[i].P50Ms
+				<< ", \"p95_ms\": " << results[i].P95Ms << ", \"max_ms\": " << results[i].MaxMs << ", \"draw_calls\": " << results[i].DrawCalls
+				<< ", \"vertices\": " << results[i].Vertices << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+		out << "  ]\n}\n";
+	}
+	target.Destroy();
+	ResourceManager::Clear();
+	return 0;
+}
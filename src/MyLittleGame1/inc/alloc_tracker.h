@@ -0,0 +1,58 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <GL/glew.h>
+
+
+// Heap traffic seen by the allocation hooks
+struct AllocationStats {
+	GLuint64 Allocations, Bytes, Frees;
+
+	AllocationStats() : Allocations(0), Bytes(0), Frees(0) { }
+};
+
+
+// A static view on every call to the global operator new and delete.
+// The hooks are only compiled into builds configured with
+// LITTLEGAME_ALLOC_HOOKS; otherwise Enabled returns false and all
+// counters stay at zero, so callers need no preprocessor checks.
+// Frames are delimited with BeginFrame and EndFrame, by each thread for
+// itself: a frame only sees the allocations of the thread that began it,
+// so other threads (job workers, the metrics exporter) neither count
+// towards it nor break it. While a thread expects zero allocations,
+// every allocation inside its frames counts as a violation and the
+// first few are printed with a stack trace. Every SampleRate-th
+// allocation, on any thread, records its call site for ReportCallSites.
+class AllocTracker
+{
+public:
+	// Whether this build counts allocations
+	static GLboolean       Enabled();
+	// Heap traffic since the program started
+	static AllocationStats Totals();
+	// Starts a frame of the calling thread
+	static void            BeginFrame();
+	// Ends the calling thread's frame and returns the thread's heap traffic during it
+	static AllocationStats EndFrame();
+	// Whether the calling thread's allocations between BeginFrame and EndFrame are violations; abort stops at the first one
+	static void            ExpectNoAllocations(GLboolean expect, GLboolean abort = GL_FALSE);
+	// Number of allocations made while none were expected
+	static GLuint64        Violations();
+	// Every rate-th allocation records its call site (0 turns sampling off)
+	static void            SetSampleRate(GLuint rate);
+	// Prints the count most frequently sampled call sites with their stacks
+	static void            ReportCallSites(GLuint count = 8);
+private:
+	// Private constructor, all functionality is static
+	AllocTracker() { }
+};
+
+#endif
@@ -0,0 +1,59 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "components.h"
+#include "entity_registry.h"
+
+class Game;
+
+
+// Autopilot plays the paddle. Every tick it predicts where the ball
+// that reaches the paddle first will land, folding its straight path
+// over the side walls MoveBall keeps it between (and over the lowest
+// bricks, for a ball still going up), and picks the point of the paddle
+// to catch it with so that BounceOffPaddle sends it towards a target
+// brick: the breakable brick of the lowest row nearest to the paddle.
+// It only sets the keys a player would hold (A, D and the space bar to
+// launch), so it plugs in right after the queued input is consumed and
+// whatever records or replays the keys sees a regular player. A tick
+// costs a few dozen flops per ball; the target is looked up again only
+// once the bricks changed (see Game::BrickRevision).
+class Autopilot
+{
+public:
+	// Set by the last Apply: where the ball it follows lands (its left edge) and the target it aims at
+	GLfloat   Landing;
+	glm::vec2 Target;
+	GLboolean HasTarget;
+	// Constructor
+	Autopilot();
+	// Sets the keys of game for the tick about to run
+	void Apply(Game &game);
+	// Left edge of a ball at the moment its bottom edge reaches y, reflected off the walls at 0 and width and,
+	// if it is still going up, off a ceiling at the given height (or at 0 once above it); returns false if it
+	// never gets there
+	static GLboolean PredictLanding(const Transform &ball, glm::vec2 velocity, GLfloat y, GLuint width, GLfloat &x, GLfloat &time, GLfloat ceiling = 0.0f);
+private:
+	// Bottom edge of the target brick, where balls going up are expected to turn
+	GLfloat targetBottom;
+	// Revisions the target was picked at, and its row; bricks only ever break until the level is respawned
+	// (or rewound, which bumps LevelRevision too), so the rows below it stay empty and are not looked at again
+	GLuint lastLevelRevision, lastBrickRevision;
+	GLuint targetRow;
+	// Looks up the target brick nearest to x; the endless mode's rows move every tick, so there it is looked up every time
+	void pickTarget(const Game &game, GLfloat x);
+	// Holds key down or lets go of it, if it is not already
+	static void setKey(Game &game, GLuint key, GLboolean down);
+};
+
+#endif
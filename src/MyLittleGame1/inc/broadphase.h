@@ -0,0 +1,99 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "entity_registry.h"
+
+
+// Bounds of one collider along with the entity it belongs to
+struct Proxy {
+	GLfloat       MinX, MaxX, MinY, MaxY;
+	Entity        Owner;
+	ComponentMask Mask;
+	GLuint        Stamp;
+};
+
+
+// Sort-and-sweep broadphase along the x axis. The proxy array keeps its
+// order between frames; since objects only move a little per frame it is
+// nearly sorted already and an insertion sort restores it in close to
+// linear time. Sweeping the sorted array only visits pairs whose x
+// intervals overlap, so the pair tests stay near O(n) as long as objects
+// are spread out horizontally. Pairs of two static proxies are skipped
+// without being visited, so dense brick fields cost next to nothing.
+class Broadphase
+{
+public:
+	// Proxies sorted by MinX
+	std::vector<Proxy> Proxies;
+	// Number of element moves the last insertion sort needed
+	GLuint             Shifts;
+	// Constructor
+	Broadphase() : Shifts(0), stamp(0) { }
+	// Refreshes the bounds of every entity having all components in mask (Transform and Collider at least) and re-sorts
+	void Update(Registry &registry, ComponentMask mask);
+	// Calls fn(const Proxy &, const Proxy &) for every overlapping pair involving at least one moving proxy (one with a Velocity)
+	template <typename Fn> void Sweep(Fn fn)
+	{
+		GLuint count = static_cast<GLuint>(this->Proxies.size());
+		this->active.clear();
+		for (GLuint i = 0; i < count; ++i)
+		{
+			const Proxy &a = this->Proxies[i];
+			// Static proxies (bricks, the paddle) never need to be paired with each other,
+			// they are only remembered while the sweep line is inside them
+			if (!(a.Mask & COMPONENT_VELOCITY))
+			{
+				this->active.push_back(i);
+				continue;
+			}
+			// Static proxies that started earlier and still cover a
+			for (GLuint k = 0; k < this->active.size(); )
+			{
+				const Proxy &b = this->Proxies[this->active[k]];
+				if (b.MaxX < a.MinX)
+				{
+					this->active[k] = this->active.back();
+					this->active.pop_back();
+					continue;
+				}
+				if (a.MinY <= b.MaxY && b.MinY <= a.MaxY)
+					fn(b, a);
+				++k;
+			}
+			// Everything that starts inside a
+			for (GLuint j = i + 1; j < count && this->Proxies[j].MinX <= a.MaxX; ++j)
+			{
+				const Proxy &b = this->Proxies[j];
+				if (a.MinY <= b.MaxY && b.MinY <= a.MaxY)
+					fn(a, b);
+			}
+		}
+	}
+	// Drops all proxies
+	void Clear();
+private:
+	// Position of each entity's proxy, indexed by entity index
+	std::vector<GLuint> slots;
+	// Tags proxies refreshed by the current Update
+	GLuint              stamp;
+	// Static proxies the sweep line may still be inside of
+	std::vector<GLuint> active;
+	// Merge target when new proxies are added, swapped with Proxies
+	std::vector<Proxy>  merged;
+	// Insertion sort of the first count proxies by MinX
+	void             sort(GLuint count);
+	static GLboolean lessMinX(const Proxy &a, const Proxy &b);
+};
+
+#endif
@@ -0,0 +1,47 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+// A 2D camera: the rectangle of the world shown on screen. For levels
+// that fit the window it never moves from the origin; in larger worlds
+// it follows a target (the ball) and is kept within the world's bounds.
+// Sees tells whether a box intersects the view, which is what culls
+// everything off screen before it is drawn.
+class Camera
+{
+public:
+	// Top left corner of the view and its size, in world units
+	glm::vec2 Position, ViewSize;
+	// Bounds the view is kept within
+	glm::vec2 WorldSize;
+	// How quickly Follow catches up: after one second exp(-Stiffness) of the distance is left
+	GLfloat   Stiffness;
+	// Constructor; the world starts out as large as the view
+	Camera(glm::vec2 viewSize = glm::vec2(0.0f));
+	// Whether the world is larger than the view, so there is anything to scroll
+	GLboolean Scrolls() const;
+	// Moves the view to center target (within the world)
+	void      CenterOn(glm::vec2 target);
+	// Moves the view dt seconds closer to centering target (within the world)
+	void      Follow(glm::vec2 target, GLfloat dt);
+	// Whether a box intersects the view
+	GLboolean Sees(glm::vec2 position, glm::vec2 size) const;
+	// Orthographic projection of a view of the given size at position (origin top left, y pointing down)
+	static glm::mat4 Projection(glm::vec2 position, glm::vec2 size);
+private:
+	// Keeps the view within the world
+	void clamp();
+};
+
+#endif
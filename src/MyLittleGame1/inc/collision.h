@@ -0,0 +1,38 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef COLLISION_H
+#define COLLISION_H
+#include <tuple>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "components.h"
+
+
+// Represents the four possible (collision) directions
+enum Direction {
+	UP,
+	RIGHT,
+	DOWN,
+	LEFT
+};
+// Defines a Collision typedef that represents collision data
+typedef std::tuple<GLboolean, Direction, glm::vec2> Collision; // <collision?, what direction?, difference vector center - closest point>
+
+// AABB - AABB collision
+GLboolean CheckCollision(const Transform &one, const Transform &two);
+// Circle (given by its bounding box and radius) - AABB collision
+Collision CheckCollision(const Transform &one, GLfloat radius, const Transform &two);
+// Circle - circle collision; the vector is the difference between both centers (two - one)
+Collision CheckCollision(const Transform &one, GLfloat radiusOne, const Transform &two, GLfloat radiusTwo);
+// Calculates which direction a vector is facing (N,E,S or W)
+Direction VectorDirection(glm::vec2 target);
+
+#endif
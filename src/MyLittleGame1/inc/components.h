@@ -0,0 +1,92 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+
+
+// Bit identifying each component type within an archetype mask
+enum Component {
+	COMPONENT_TRANSFORM = 1 << 0,
+	COMPONENT_VELOCITY  = 1 << 1,
+	COMPONENT_SPRITE    = 1 << 2,
+	COMPONENT_COLLIDER  = 1 << 3,
+	COMPONENT_BRICK     = 1 << 4,
+	COMPONENT_BALL      = 1 << 5
+};
+// Set of component bits
+typedef GLuint ComponentMask;
+
+// Component sets of the entities used by Breakout
+const ComponentMask BRICK_ARCHETYPE  = COMPONENT_TRANSFORM | COMPONENT_SPRITE | COMPONENT_COLLIDER | COMPONENT_BRICK;
+const ComponentMask PADDLE_ARCHETYPE = COMPONENT_TRANSFORM | COMPONENT_SPRITE | COMPONENT_COLLIDER;
+const ComponentMask BALL_ARCHETYPE   = COMPONENT_TRANSFORM | COMPONENT_VELOCITY | COMPONENT_SPRITE | COMPONENT_COLLIDER | COMPONENT_BALL;
+
+
+// Position, size and orientation of an entity
+struct Transform {
+	glm::vec2 Position, Size;
+	GLfloat   Rotation;
+
+	Transform() : Position(0.0f, 0.0f), Size(1.0f, 1.0f), Rotation(0.0f) { }
+	Transform(glm::vec2 pos, glm::vec2 size) : Position(pos), Size(size), Rotation(0.0f) { }
+};
+
+// Linear velocity in pixels per second
+struct Velocity {
+	glm::vec2 Value;
+
+	Velocity() : Value(0.0f, 0.0f) { }
+	Velocity(glm::vec2 value) : Value(value) { }
+};
+
+// Texture and tint the entity is drawn with
+struct Sprite {
+	TextureView Texture;
+	glm::vec3   Color;
+
+	Sprite() : Texture(), Color(1.0f) { }
+	Sprite(const TextureView &texture, glm::vec3 color = glm::vec3(1.0f)) : Texture(texture), Color(color) { }
+};
+
+// Shape used for collision detection; boxes use the Transform's extent
+enum ColliderShape {
+	COLLIDER_BOX,
+	COLLIDER_CIRCLE
+};
+
+struct Collider {
+	ColliderShape Shape;
+	GLfloat       Radius;
+
+	Collider() : Shape(COLLIDER_BOX), Radius(0.0f) { }
+	Collider(ColliderShape shape, GLfloat radius = 0.0f) : Shape(shape), Radius(radius) { }
+};
+
+// Level tile state
+struct Brick {
+	GLboolean IsSolid;
+	GLboolean Destroyed;
+
+	Brick() : IsSolid(GL_FALSE), Destroyed(GL_FALSE) { }
+	Brick(GLboolean solid) : IsSolid(solid), Destroyed(GL_FALSE) { }
+};
+
+// Ball specific state
+struct Ball {
+	GLboolean Stuck;
+
+	Ball() : Stuck(GL_TRUE) { }
+};
+
+#endif
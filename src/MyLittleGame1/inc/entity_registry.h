@@ -0,0 +1,180 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+#include <cassert>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "components.h"
+
+
+// Handle to an entity. The generation changes whenever an index is
+// reused, so stale handles of destroyed entities are detected.
+struct Entity {
+	GLuint Index, Generation;
+
+	Entity() : Index(0xFFFFFFFF), Generation(0) { }
+	Entity(GLuint index, GLuint generation) : Index(index), Generation(generation) { }
+	GLboolean IsValid() const { return this->Index != 0xFFFFFFFF; }
+	bool operator==(const Entity &other) const { return this->Index == other.Index && this->Generation == other.Generation; }
+	bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+
+// An Archetype stores all entities sharing exactly the same set of
+// components. Each component type lives in its own contiguous array and
+// row i of every array belongs to Entities[i]; arrays of components that
+// are not part of Mask stay empty. Systems loop over these arrays directly.
+class Archetype
+{
+public:
+	// Component set and storage
+	ComponentMask          Mask;
+	std::vector<Entity>    Entities;
+	std::vector<Transform> Transforms;
+	std::vector<Velocity>  Velocities;
+	std::vector<Sprite>    Sprites;
+	std::vector<Collider>  Colliders;
+	std::vector<Brick>     Bricks;
+	std::vector<Ball>      Balls;
+	// Constructor
+	Archetype(ComponentMask mask) : Mask(mask) { }
+	// Number of entities (rows)
+	GLuint    Size() const { return static_cast<GLuint>(this->Entities.size()); }
+	// Whether this archetype has every component in mask
+	GLboolean Has(ComponentMask mask) const { return (this->Mask & mask) == mask; }
+	// Typed access to a component array
+	template <typename T> std::vector<T>       &Column();
+	template <typename T> const std::vector<T> &Column() const;
+private:
+	friend class Registry;
+	// Appends a row of default constructed components and returns its index
+	GLuint push(Entity entity);
+	// Removes a row by moving the last row into its place
+	void   remove(GLuint row);
+	// Copies the components both archetypes have in common from a row of another archetype
+	void   copyRow(GLuint row, const Archetype &from, GLuint fromRow);
+};
+
+
+// Maps a component type to its bit and its array within an Archetype
+template <typename T> struct ComponentTraits;
+template <> struct ComponentTraits<Transform> {
+	static const ComponentMask Bit = COMPONENT_TRANSFORM;
+	static std::vector<Transform> &Column(Archetype &archetype) { return archetype.Transforms; }
+	static const std::vector<Transform> &Column(const Archetype &archetype) { return archetype.Transforms; }
+};
+template <> struct ComponentTraits<Velocity> {
+	static const ComponentMask Bit = COMPONENT_VELOCITY;
+	static std::vector<Velocity> &Column(Archetype &archetype) { return archetype.Velocities; }
+	static const std::vector<Velocity> &Column(const Archetype &archetype) { return archetype.Velocities; }
+};
+template <> struct ComponentTraits<Sprite> {
+	static const ComponentMask Bit = COMPONENT_SPRITE;
+	static std::vector<Sprite> &Column(Archetype &archetype) { return archetype.Sprites; }
+	static const std::vector<Sprite> &Column(const Archetype &archetype) { return archetype.Sprites; }
+};
+template <> struct ComponentTraits<Collider> {
+	static const ComponentMask Bit = COMPONENT_COLLIDER;
+	static std::vector<Collider> &Column(Archetype &archetype) { return archetype.Colliders; }
+	static const std::vector<Collider> &Column(const Archetype &archetype) { return archetype.Colliders; }
+};
+template <> struct ComponentTraits<Brick> {
+	static const ComponentMask Bit = COMPONENT_BRICK;
+	static std::vector<Brick> &Column(Archetype &archetype) { return archetype.Bricks; }
+	static const std::vector<Brick> &Column(const Archetype &archetype) { return archetype.Bricks; }
+};
+template <> struct ComponentTraits<Ball> {
+	static const ComponentMask Bit = COMPONENT_BALL;
+	static std::vector<Ball> &Column(Archetype &archetype) { return archetype.Balls; }
+	static const std::vector<Ball> &Column(const Archetype &archetype) { return archetype.Balls; }
+};
+
+template <typename T> std::vector<T> &Archetype::Column() { return ComponentTraits<T>::Column(*this); }
+template <typename T> const std::vector<T> &Archetype::Column() const { return ComponentTraits<T>::Column(*this); }
+
+
+// Registry owns all entities, grouped into archetypes. Entities are
+// created with a component mask, and adding or removing components
+// moves them to the matching archetype. Creating entities may add
+// archetypes, so do not create or destroy entities from inside Each.
+class Registry
+{
+public:
+	// Constructor
+	Registry() { }
+	// Creates an entity with default constructed components for every bit in mask
+	Entity        Create(ComponentMask mask);
+	// Destroys an entity; stale handles are ignored
+	void          Destroy(Entity entity);
+	// Destroys every entity that has all components in mask (array capacity is kept for reuse)
+	void          DestroyAll(ComponentMask mask);
+	// Destroys all entities
+	void          Clear();
+	// Whether the handle refers to a live entity
+	GLboolean     IsAlive(Entity entity) const;
+	// Component set of a live entity
+	ComponentMask MaskOf(Entity entity) const;
+	// Moves an entity to the archetype of the given component set, keeping shared components
+	void          SetMask(Entity entity, ComponentMask mask);
+	// Number of live entities having all components in mask
+	GLuint        Count(ComponentMask mask) const;
+	// Component access
+	template <typename T> T       &Get(Entity entity);
+	template <typename T> const T &Get(Entity entity) const;
+	template <typename T> GLboolean Has(Entity entity) const { return this->IsAlive(entity) && (this->MaskOf(entity) & ComponentTraits<T>::Bit); }
+	template <typename T> void      Add(Entity entity, const T &component) { this->SetMask(entity, this->MaskOf(entity) | ComponentTraits<T>::Bit); this->Get<T>(entity) = component; }
+	template <typename T> void      Remove(Entity entity) { this->SetMask(entity, this->MaskOf(entity) & ~ComponentTraits<T>::Bit); }
+	// Calls fn(Archetype &) for every non-empty archetype having all components in mask
+	template <typename Fn> void Each(ComponentMask mask, Fn fn)
+	{
+		for (Archetype &archetype : this->archetypes)
+			if (archetype.Has(mask) && archetype.Size() > 0)
+				fn(archetype);
+	}
+	template <typename Fn> void Each(ComponentMask mask, Fn fn) const
+	{
+		for (const Archetype &archetype : this->archetypes)
+			if (archetype.Has(mask) && archetype.Size() > 0)
+				fn(archetype);
+	}
+private:
+	// Where an entity lives
+	struct Record {
+		GLuint    ArchetypeIndex, Row, Generation;
+		GLboolean Alive;
+	};
+	std::vector<Record>    records;
+	std::vector<GLuint>    freeIndices;
+	std::vector<Archetype> archetypes;
+	// Returns the index of the archetype with exactly this mask, creating it if needed
+	GLuint archetypeFor(ComponentMask mask);
+	// Removes a row from an archetype and fixes the record of the entity moved into its place
+	void   removeRow(GLuint archetype, GLuint row);
+	// Marks a record dead and recycles its index
+	void   release(GLuint index);
+};
+
+template <typename T> T &Registry::Get(Entity entity)
+{
+	assert(this->IsAlive(entity) && (this->MaskOf(entity) & ComponentTraits<T>::Bit));
+	const Record &record = this->records[entity.Index];
+	return ComponentTraits<T>::Column(this->archetypes[record.ArchetypeIndex])[record.Row];
+}
+
+template <typename T> const T &Registry::Get(Entity entity) const
+{
+	assert(this->IsAlive(entity) && (this->MaskOf(entity) & ComponentTraits<T>::Bit));
+	const Record &record = this->records[entity.Index];
+	return ComponentTraits<T>::Column(this->archetypes[record.ArchetypeIndex])[record.Row];
+}
+
+#endif
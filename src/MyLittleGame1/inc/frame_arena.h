@@ -0,0 +1,109 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Debug builds overwrite released arena memory so stale pointers into
+// a previous frame show up as garbage (0xDD bytes) instead of working by accident
+#if !defined(NDEBUG) && !defined(LITTLEGAME_ARENA_POISON)
+#define LITTLEGAME_ARENA_POISON 1
+#endif
+
+
+// Linear (bump) allocator for short-lived data. Allocating moves a
+// pointer forward, individual frees do nothing, and Reset releases
+// everything at once. When a block runs out an overflow block is taken
+// from the heap; the next Reset merges them into one block big enough
+// for the peak usage, so steady-state frames never touch the heap.
+// Destructors are not run: store trivially destructible data, or
+// containers that are destroyed before the arena is reset.
+class LinearArena
+{
+public:
+	// Constructor, reserving the initial block
+	LinearArena(size_t capacity = 64 * 1024);
+	~LinearArena();
+	// Returns size bytes aligned to alignment (a power of two)
+	void  *Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// Typed convenience for arrays of trivially constructible data
+	template <typename T>
+	T     *AllocateArray(size_t count) { return static_cast<T *>(this->Allocate(count * sizeof(T), alignof(T))); }
+	// Releases all allocations (poisoning them in debug builds)
+	void   Reset();
+	// Bytes handed out since the last Reset, the most ever handed out between resets and the reserved size
+	size_t Used() const { return this->used; }
+	size_t Peak() const { return this->peak; }
+	size_t Capacity() const;
+private:
+	struct Block {
+		unsigned char *Memory;
+		size_t         Size;
+	};
+	std::vector<Block> blocks;  // the last block is the one being filled
+	size_t             offset;  // fill level of the last block
+	size_t             used, peak;
+	// Appends a block of at least size bytes
+	void addBlock(size_t size);
+	LinearArena(const LinearArena &);
+	LinearArena &operator=(const LinearArena &);
+};
+
+
+// Two LinearArenas used in turns, one per frame. Data allocated during
+// a frame stays valid through the following frame, long enough for a
+// renderer (or render thread) to consume what the simulation produced
+// while the simulation already works on the next frame.
+class FrameArena
+{
+public:
+	// Constructor; capacity is per arena
+	FrameArena(size_t capacity = 64 * 1024);
+	// Starts a new frame: the arena of two frames ago is reset and becomes the current one
+	void         BeginFrame();
+	// Arena of the running frame
+	LinearArena &Current() { return this->current ? this->odd : this->even; }
+	// Arena of the previous frame, still intact
+	LinearArena &Previous() { return this->current ? this->even : this->odd; }
+private:
+	LinearArena even, odd;
+	GLuint      current;
+};
+
+
+// std::allocator-compatible adapter, so standard containers can live in
+// an arena. deallocate does nothing: the memory comes back on Reset.
+// Reserve up front where possible, since every regrowth leaves the old
+// buffer behind until then.
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+	// Arena all copies and rebinds of this allocator draw from
+	LinearArena *Arena;
+	ArenaAllocator(LinearArena &arena) : Arena(&arena) { }
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : Arena(other.Arena) { }
+	T   *allocate(size_t count) { return this->Arena->AllocateArray<T>(count); }
+	void deallocate(T *, size_t) { }
+	template <typename U>
+	bool operator==(const ArenaAllocator<U> &other) const { return this->Arena == other.Arena; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U> &other) const { return this->Arena != other.Arena; }
+};
+
+// Vector drawing its storage from an arena
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,54 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+#include <chrono>
+#include <string>
+
+#include <GL/glew.h>
+
+
+// How the main loop is paced
+enum PacingMode {
+	PACING_OFF,            // render as fast as possible
+	PACING_VSYNC,          // block in SwapBuffers until the next vertical blank
+	PACING_ADAPTIVE_VSYNC, // vsync, but late frames are shown immediately (tears instead of stalling a whole refresh)
+	PACING_LIMIT           // no vsync, the loop sleeps to hold TargetFps
+};
+
+
+// Paces the main loop. Vsync modes only set the swap interval of the
+// current context; the limiter sleeps until shortly before the next
+// frame is due and spin-waits the rest, since sleeps overshoot by up
+// to a scheduler tick. Deadlines advance by a fixed period, so an
+// occasional late frame does not shift every following one.
+class FramePacer
+{
+public:
+	// Settings
+	PacingMode Mode;
+	GLfloat    TargetFps;
+	GLfloat    SpinSeconds;  // part of each wait spent spinning instead of sleeping
+	// Constructor
+	FramePacer(PacingMode mode = PACING_VSYNC, GLfloat targetFps = 60.0f);
+	// Sets the swap interval of the current context for the mode (call after creating the context and after mode changes)
+	void Apply();
+	// Waits until the next frame is due (limiter only, returns at once otherwise)
+	void Wait();
+	// Forgets the frame schedule, e.g. after the loop was idle
+	void Restart();
+	// Parses "off", "vsync", "adaptive" or "limit"; returns false for anything else
+	static GLboolean Parse(const std::string &name, PacingMode &mode);
+private:
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point deadline;
+	GLboolean         scheduled;
+};
+
+#endif
@@ -10,11 +10,28 @@
 #define GAME_H
 #include <vector>
 #include <tuple>
+#include <string>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
 #include "game_level.h"
+#include "entity_registry.h"
+#include "frame_arena.h"
+#include "input_queue.h"
+#include "layer_cache.h"
+#include "level_generator.h"
+#include "metrics.h"
+#include "render_snapshot.h"
+#include "rewind_buffer.h"
+#include "streaming_level.h"
+#include "broadphase.h"
+#include "camera.h"
+#include "collision.h"
+#include "resource_manager.h"
+
+class SpriteRenderer;
+class ParticleGenerator;
 
 // Represents the current state of the game
 enum GameState {
@@ -23,17 +40,7 @@ enum GameState {
 	GAME_WIN
 };
 
-// Represents the four possible (collision) directions
-enum Direction {
-	UP,
-	RIGHT,
-	DOWN,
-	LEFT
-};
-// Defines a Collision typedef that represents collision data
-typedef std::tuple<GLboolean, Direction, glm::vec2> Collision; // <collision?, what direction?, difference vector center - closest point>
-
-															   // Initial size of the player paddle
+// Initial size of the player paddle
 const glm::vec2 PLAYER_SIZE(100, 20);
 // Initial velocity of the player paddle
 const GLfloat PLAYER_VELOCITY(500.0f);
@@ -41,6 +48,26 @@ const GLfloat PLAYER_VELOCITY(500.0f);
 const glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
 // Radius of the ball object
 const GLfloat BALL_RADIUS = 12.5f;
+// Length of one fixed simulation tick in seconds
+const GLfloat TICK_DURATION = 1.0f / 60.0f;
+// Rewinding: while REWIND_KEY is held the buffered ticks play backwards, RETRY_KEY jumps back RETRY_TICKS at once
+const GLuint REWIND_KEY = GLFW_KEY_BACKSPACE;
+const GLuint RETRY_KEY = GLFW_KEY_R;
+const GLuint RETRY_TICKS = 180;
+// Size of a tile in levels played at their own size instead of squeezed into the window (see PlayLevel)
+const glm::vec2 TILE_SIZE(64.0f, 32.0f);
+// Rows of the endless mode: 16 columns of scattered bricks, a few of them solid (seeded by the caller)
+const LevelSpec ENDLESS_LEVEL(LEVEL_NOISE, 16, 32, 0.7f, 0.03f);
+// Speed the rows of the endless mode scroll down with, in pixels per second
+const GLfloat ENDLESS_SCROLL_SPEED = 12.0f;
+
+// Ids of the metrics recorded by the game loop, registered by Init
+struct GameMetrics {
+	MetricId Ticks, Collisions, UpdateTime, RenderTime, DrawCalls, LiveBricks, LiveParticles;
+
+	GameMetrics() : Ticks(INVALID_METRIC), Collisions(INVALID_METRIC), UpdateTime(INVALID_METRIC), RenderTime(INVALID_METRIC),
+		DrawCalls(INVALID_METRIC), LiveBricks(INVALID_METRIC), LiveParticles(INVALID_METRIC) { }
+};
 
 // Game holds all game-related state and functionality.
 // Combines all game-related data into a single class for
@@ -51,24 +78,115 @@ public:
 	// Game state
 	GameState              State;
 	GLboolean              Keys[1024];
-	GLuint                 Width, Height;
+	GLuint                 Width, Height;  // playfield; as large as the window unless PlayLevel needs more room
 	std::vector<GameLevel> Levels;
 	GLuint                 Level;	
 	GLboolean              KeyPress[1024];
 	GLuint                 KeyState[1024];
+	GLuint64               Seed;     // Seeds all randomness of a session; set before Init
+	GLuint64               Ticks;    // Fixed ticks simulated so far; rewinding sets it back
+	// The most recent ticks, for rewinding; stores nothing until given a budget (see ProcessRewind), and is
+	// turned off again if a tick's state image can never fit it
+	RewindBuffer           History;
+	// Entities (bricks of the current level, the paddle and the balls)
+	Registry               Entities;
+	Entity                 Player;
+	Broadphase             Overlaps;
+	// Brick entity of every tile of the current level (invalid for empty tiles), to find the bricks in view
+	std::vector<Entity>    BrickGrid;
+	// Part of the playfield shown on screen; follows the ball in playfields larger than the window
+	Camera                 View;
+	// Endless mode: the bricks stream in through Stream instead of being spawned from Levels (see PlayEndless)
+	GLboolean              Endless;
+	StreamingLevel         Stream;
+	// Transient memory; a new frame starts with every Update, so data lives through the following render
+	FrameArena             Frame;
+	// Render state
+	SpriteRenderer        *Renderer;
+	ParticleGenerator     *Particles;
+	// Cached layers: the background with the solid bricks, and the breakable bricks. Their
+	// revisions are bumped whenever the level is respawned, and whenever a brick is destroyed
+	LayerCache             StaticLayer, BrickLayer;
+	GLuint                 LevelRevision, BrickRevision;
+	// How far ahead of its simulated position the paddle (and any ball stuck to it) is drawn, see SamplePlayer
+	glm::vec2              PlayerLead;
+	// Snapshot Render() takes of the game's own state
+	RenderSnapshot         Latest;
+	// Textures resolved at Init (invalid in headless games)
+	TextureHandle          BackgroundTexture, PaddleTexture, BallTexture, BlockTexture, SolidBlockTexture;
+	// Metrics (ticks, collisions, update and render time, draw calls, live bricks and particles)
+	GameMetrics            Stats;
 	// Constructor/Destructor
 	Game(GLuint width, GLuint height);
 	~Game();
-	// Initialize game state (load all shaders/textures/levels)
-	void Init();
+	// Initialize game state (load all shaders/textures/levels); a headless game loads no GL resources and does not render
+	void Init(GLboolean headless = GL_FALSE);
+	// Loads shaders (from shaderDirectory, "" being the working directory) and textures and sets up the renderer; Init calls it unless headless
+	void LoadResources(const std::string &shaderDirectory = "");
+	// Input
+	// Applies a single key event to Keys and KeyState
+	void   ApplyKey(GLuint key, GLuint action);
+	// Applies the queued events stamped up to time to the tick about to run; a second event for the same key
+	// waits for the next tick, so a tap shorter than a tick still lasts one. Returns how many were applied
+	GLuint ConsumeInput(InputQueue &input, GLdouble time);
+	// Late input sampling: sets PlayerLead to where the paddle gets within ahead seconds after the last tick,
+	// given the newest key state (queued events included); changes nothing the simulation sees
+	void   SamplePlayer(const InputQueue &input, GLfloat ahead);
+	// Same for a game ticking on another thread: the paddle of snapshot, moved by the given key state
+	void   SamplePlayer(const RenderSnapshot &snapshot, GLboolean left, GLboolean right, GLfloat ahead);
+	// Handles the rewind keys in place of a tick: steps back one buffered tick while REWIND_KEY is held, or jumps
+	// back RETRY_TICKS on RETRY_KEY. Returns true if the tick went to rewinding, so ProcessInput and Update are skipped
+	GLboolean ProcessRewind();
 	// GameLoop
 	void ProcessInput(GLfloat dt);
 	void Update(GLfloat dt);
 	void Render();
-	void DoCollisions();
+	// Copies what Render draws out of the simulation state
+	void Snapshot(RenderSnapshot &snapshot) const;
+	// Draws a snapshot; touches nothing the simulation changes, so it may run while another thread ticks
+	void Render(const RenderSnapshot &snapshot);
+	// Resolves collisions and returns how many there were
+	GLuint DoCollisions();
+	// Plays a single level at a fixed tile size rather than squeezed into the window. The playfield grows
+	// to fit it, with as much room again below its bricks, and the camera follows the ball
+	GLboolean PlayLevel(const GameLevel &level, glm::vec2 tileSize = TILE_SIZE);
+	// Switches to the endless mode, rows of spec scrolling down at scrollSpeed until one with breakable bricks
+	// left reaches the paddle; returns false if the spec is out of range
+	GLboolean PlayEndless(const LevelSpec &spec, GLfloat scrollSpeed = ENDLESS_SCROLL_SPEED);
 	// Reset
 	void ResetLevel();
 	void ResetPlayer();
+	// Creates a ball entity
+	Entity SpawnBall(glm::vec2 position, glm::vec2 velocity);
+	// Releases count extra balls from the paddle, fanned out upwards (multi-ball power-up, stress modes)
+	void   SpawnBalls(GLuint count);
+	// Restores the state after a buffered tick; returns false if History does not hold it
+	GLboolean Rewind(GLuint64 tick);
+	// Writes the simulation state to a state image, and restores it from one: the level and which of its bricks
+	// stand, the paddle, the balls, the streamed rows and the random streams. Input (Keys, KeyState, KeyPress)
+	// is not part of it, and neither are the levels or the mode set by PlayLevel and PlayEndless. Restoring
+	// keeps the entities it can and creates the rest, so handles and broadphase order may differ afterwards
+	void      SaveState(StateWriter &writer) const;
+	GLboolean LoadState(StateReader &reader);
+	// Hash over the simulation state (render state excluded), for detecting desyncs between runs
+	GLuint64 Checksum() const;
+private:
+	// Sprite showing the given texture, or an empty one if it is not loaded
+	Sprite spriteOf(TextureHandle texture) const;
+	// Moves all balls still stuck to the paddle along with it
+	void moveStuckBalls(GLfloat dx);
+	// Sets PlayerLead for a paddle at position that moves as the given keys make it for ahead seconds
+	void sampleLead(glm::vec2 position, glm::vec2 size, GLboolean left, GLboolean right, GLfloat ahead);
+	// Draws a sprite instance, offset by offset
+	void drawSprite(const SpriteInstance &sprite, glm::vec2 offset = glm::vec2(0.0f));
+	// Scratch image for recording and restoring ticks
+	StateImage stateImage;
+	// Camera position of the last frame drawn; while the camera moves, the layers are drawn without their caches
+	glm::vec2 renderedView;
+	// One bit per tile of BrickGrid, set while its brick stands; what state images keep of the bricks
+	std::vector<GLuint> brickBits;
+	// Sets brickBits for bricks just spawned
+	void resetBrickBits();
 };
 
 #endif
\ No newline at end of file
@@ -14,29 +14,36 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
-#include "game_object.h"
-#include "sprite_renderer.h"
+#include "entity_registry.h"
+#include "frame_arena.h"
 #include "resource_manager.h"
 
 
 /// GameLevel holds all Tiles as part of a Breakout level and 
-/// hosts functionality to Load/render levels from the harddisk.
+/// hosts functionality to Load levels from the harddisk. The
+/// bricks themselves are entities, spawned from the tile codes.
 class GameLevel
 {
 public:
 	// Level state
-	std::vector<GameObject> Bricks;
+	std::vector<GLuint> Tiles;          // Tile codes, row by row
+	GLuint              Columns, Rows;
+	GLuint              Width, Height;  // Area the level is laid out in
 	// Constructor
-	GameLevel() { }
+	GameLevel() : Columns(0), Rows(0), Width(0), Height(0) { }
 	// Loads level from file
 	void      Load(const GLchar *file, GLuint levelWidth, GLuint levelHeight);
-	// Render level
-	void      Draw(SpriteRenderer &renderer);
+	// Writes the tile codes to file in the format Load reads
+	GLboolean Save(const GLchar *file) const;
+	// Creates a brick entity for every tile; grid, if given, receives the entity of every tile row by row (invalid for empty tiles)
+	void      Spawn(Registry &registry, std::vector<Entity> *grid = nullptr) const;
 	// Check if the level is completed (all non-solid tiles are destroyed)
-	GLboolean IsCompleted();
+	GLboolean IsCompleted(Registry &registry) const;
+	// Color bricks of a tile code are tinted with
+	static glm::vec3 TileColor(GLuint tile);
 private:
 	// Initialize level from tile data
-	void      init(std::vector<std::vector<GLuint>> tileData, GLuint levelWidth, GLuint levelHeight);
+	void      init(const ArenaVector<ArenaVector<GLuint>> &tileData, GLuint levelWidth, GLuint levelHeight);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GAME_SYSTEMS_H
+#define GAME_SYSTEMS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "entity_registry.h"
+#include "broadphase.h"
+#include "collision.h"
+#include "frame_arena.h"
+#include "streaming_level.h"
+#include "sprite_renderer.h"
+#include "particle_generator.h"
+
+
+// Systems are free functions that process whole component arrays of a
+// Registry at once instead of calling into every object separately.
+
+// Moves a ball, keeping it constrained within the window bounds (except bottom edge); returns new position
+glm::vec2 MoveBall(Transform &transform, Velocity &velocity, const Ball &ball, GLfloat dt, GLuint window_width);
+// Reflects a ball off a box it collided with and moves it out of the box
+void      BounceOffBox(Transform &ball, glm::vec2 &velocity, GLfloat radius, const Collision &collision);
+// Bounces a ball touching the paddle back up, steered by where it hit; returns whether they touched
+GLboolean BounceOffPaddle(Transform &ball, glm::vec2 &velocity, GLfloat radius, const Transform &paddle);
+// Pushes two touching balls apart and exchanges their momentum along the line through their centers; returns whether they touched
+GLboolean BounceBalls(Transform &one, glm::vec2 &velocityOne, GLfloat radiusOne, Transform &two, glm::vec2 &velocityTwo, GLfloat radiusTwo);
+// Moves every ball that is not stuck to the paddle
+void      MoveSystem(Registry &registry, GLfloat dt, GLuint window_width);
+// Resolves ball - brick, ball - paddle and ball - ball collisions found by the broadphase; returns the number of collisions handled,
+// adds the number of bricks destroyed to bricksDestroyed and appends the bricks themselves to destroyedBricks, if given
+GLuint    CollisionSystem(Registry &registry, Broadphase &broadphase, Entity paddle, GLuint *bricksDestroyed = nullptr, ArenaVector<Entity> *destroyedBricks = nullptr);
+// Resolves collisions of the balls with the tiles of a streaming level, looking only at the tiles under each ball;
+// returns and counts like CollisionSystem
+GLuint    StreamingCollisionSystem(Registry &registry, StreamingLevel &level, GLuint *bricksDestroyed = nullptr);
+// Draws every entity having all components of include and none of exclude (destroyed bricks are skipped)
+void      RenderSystem(Registry &registry, SpriteRenderer &renderer, ComponentMask include, ComponentMask exclude = 0);
+// Queues trail particles behind every ball
+void      ParticleEmitSystem(Registry &registry, ParticleGenerator &particles, GLuint newParticles);
+
+#endif
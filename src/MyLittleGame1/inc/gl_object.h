@@ -0,0 +1,108 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GL_OBJECT_H
+#define GL_OBJECT_H
+#include <atomic>
+
+#include <GL/glew.h>
+
+
+// How each kind of GL object is created and deleted
+struct TextureObject {
+	static GLuint Create() { GLuint id; glGenTextures(1, &id); return id; }
+	static void   Destroy(GLuint id) { glDeleteTextures(1, &id); }
+};
+struct BufferObject {
+	static GLuint Create() { GLuint id; glGenBuffers(1, &id); return id; }
+	static void   Destroy(GLuint id) { glDeleteBuffers(1, &id); }
+};
+struct VertexArrayObject {
+	static GLuint Create() { GLuint id; glGenVertexArrays(1, &id); return id; }
+	static void   Destroy(GLuint id) { glDeleteVertexArrays(1, &id); }
+};
+struct FramebufferObject {
+	static GLuint Create() { GLuint id; glGenFramebuffers(1, &id); return id; }
+	static void   Destroy(GLuint id) { glDeleteFramebuffers(1, &id); }
+};
+struct ProgramObject {
+	static GLuint Create() { return glCreateProgram(); }
+	static void   Destroy(GLuint id) { glDeleteProgram(id); }
+};
+struct QueryObject {
+	static GLuint Create() { GLuint id; glGenQueries(1, &id); return id; }
+	static void   Destroy(GLuint id) { glDeleteQueries(1, &id); }
+};
+
+
+// Sole owner of one GL object. Nothing is created until the name is
+// first needed (Get), so owners can be constructed, moved and destroyed
+// without a context as long as they were never used. The object is
+// deleted when the owner is destroyed or assigned to; owners can be
+// moved but not copied. Everything else refers to the object through
+// its plain name (see TextureView). Must be used on the thread owning
+// the GL context.
+template <typename Kind>
+class GLObject
+{
+public:
+	// Constructor (creates nothing)
+	GLObject() : id(0) { }
+	~GLObject() { this->Release(); }
+	GLObject(GLObject &&other) : id(other.id) { other.id = 0; }
+	GLObject &operator=(GLObject &&other)
+	{
+		if (this != &other)
+		{
+			this->Release();
+			this->id = other.id;
+			other.id = 0;
+		}
+		return *this;
+	}
+	// Name of the object, creating it on first use
+	GLuint Get()
+	{
+		if (!this->id)
+		{
+			this->id = Kind::Create();
+			++live;
+		}
+		return this->id;
+	}
+	// Name of the object, 0 if it has not been created
+	GLuint ID() const { return this->id; }
+	// Deletes the object now; the next Get creates a new one
+	void   Release()
+	{
+		if (this->id)
+		{
+			Kind::Destroy(this->id);
+			this->id = 0;
+			--live;
+		}
+	}
+	// Number of objects of this kind currently alive, for leak checks
+	static GLint Live() { return live.load(); }
+private:
+	GLuint id;
+	static std::atomic<GLint> live;
+	GLObject(const GLObject &);
+	GLObject &operator=(const GLObject &);
+};
+
+template <typename Kind> std::atomic<GLint> GLObject<Kind>::live(0);
+
+typedef GLObject<TextureObject>     GLTexture;
+typedef GLObject<BufferObject>      GLBuffer;
+typedef GLObject<VertexArrayObject> GLVertexArray;
+typedef GLObject<FramebufferObject> GLFramebuffer;
+typedef GLObject<ProgramObject>     GLProgram;
+typedef GLObject<QueryObject>       GLQuery;
+
+#endif
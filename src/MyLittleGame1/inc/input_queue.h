@@ -0,0 +1,63 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+#include <atomic>
+
+#include <GL/glew.h>
+
+
+// Key value of an event that releases every key (the window lost focus)
+const GLuint RELEASE_ALL_KEYS = 0xFFFFFFFF;
+
+// A key press, repeat or release as reported by the window system
+struct KeyEvent {
+	GLdouble Time;    // seconds, on the clock of glfwGetTime
+	GLuint   Key;     // GLFW key code or RELEASE_ALL_KEYS
+	GLuint   Action;  // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+
+	KeyEvent() : Time(0.0), Key(0), Action(0) { }
+	KeyEvent(GLdouble time, GLuint key, GLuint action) : Time(time), Key(key), Action(action) { }
+};
+
+
+// Lock-free single producer, single consumer ring of key events. The
+// window system's input callbacks push, the simulation pops each event
+// at the tick covering its timestamp, so presses and releases within
+// one frame keep their order and timing. Indices grow monotonically and
+// are wrapped on access (the capacity divides 2^32). Pushing never
+// blocks: when the ring is full the event is dropped and counted.
+class InputQueue
+{
+public:
+	// Number of events the ring holds (power of two)
+	static const GLuint CAPACITY = 256;
+	// Constructor
+	InputQueue();
+	// Producer: appends an event; returns false if the ring was full
+	GLboolean       Push(const KeyEvent &event);
+	// Consumer: copies the oldest event; returns false if there is none
+	GLboolean       Peek(KeyEvent &event) const;
+	// Consumer: removes the oldest event
+	void            Pop();
+	// Consumer: number of events waiting, and the index-th of them (0 is the oldest)
+	GLuint          Size() const;
+	const KeyEvent &Pending(GLuint index) const;
+	// Number of events lost to a full ring
+	GLuint          Dropped() const;
+private:
+	KeyEvent            events[CAPACITY];
+	// Next event to read (written by the consumer) and to write (written by the producer)
+	std::atomic<GLuint> head, tail;
+	std::atomic<GLuint> dropped;
+	InputQueue(const InputQueue &);
+	InputQueue &operator=(const InputQueue &);
+};
+
+#endif
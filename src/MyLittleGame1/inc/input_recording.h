@@ -0,0 +1,69 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef INPUT_RECORDING_H
+#define INPUT_RECORDING_H
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "game.h"
+
+
+// A single key change, applied right before the given tick runs
+struct InputEvent {
+	GLuint    Tick;
+	GLuint    Key;
+	GLboolean Down;    // Game::Keys value
+	GLuint    Action;  // Game::KeyState value (GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT)
+};
+
+
+// InputRecording captures everything that feeds a Game from outside
+// (the session seed and the keyboard state of every fixed tick) so a
+// session can be replayed exactly. Only key changes are stored; the
+// file encodes the gap since the previous change as a variable-length
+// integer, so long stretches without input cost next to nothing. A state
+// checksum is stored every CHECKSUM_INTERVAL ticks to detect desyncs.
+class InputRecording
+{
+public:
+	// Ticks between two stored state checksums
+	static const GLuint CHECKSUM_INTERVAL = 60;
+	// Recorded session
+	GLuint64                Seed;
+	GLuint                  Width, Height;
+	GLuint                  Ticks;
+	std::vector<InputEvent> Events;
+	std::vector<GLuint64>   Checksums;
+	// Constructor
+	InputRecording();
+	// Starts recording a game that was just initialized
+	void      Start(const Game &game);
+	// Records the input of the tick about to run; call right before ProcessInput
+	void      Capture(const Game &game);
+	// Records the state reached by the tick; call right after Update
+	void      Checkpoint(const Game &game);
+	// Restarts playback at the first tick
+	void      Rewind();
+	// Writes the input of the next tick into game; returns false once all ticks were played
+	GLboolean Apply(Game &game);
+	// Stored checksum for the state after the given number of ticks, or 0 if none was stored
+	GLuint64  ChecksumAt(GLuint ticks) const;
+	// Reads and writes recordings
+	GLboolean Save(const GLchar *file) const;
+	GLboolean Load(const GLchar *file);
+private:
+	// Keyboard state as of the last captured tick
+	GLboolean keys[1024];
+	GLuint    keyState[1024];
+	// Playback position
+	GLuint    tick, cursor;
+};
+
+#endif
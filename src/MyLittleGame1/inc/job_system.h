@@ -0,0 +1,104 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <GL/glew.h>
+
+
+class JobCounter;
+
+// Signature of a job entry point: user data plus the index range to process
+typedef void (*JobFunction)(void *data, GLuint begin, GLuint end);
+
+// A single unit of work as stored in the worker deques. Plain data so
+// that scheduling a job never touches the heap.
+struct Job {
+	JobFunction  Function;
+	void        *Data;
+	GLuint       Begin, End;
+	JobCounter  *Counter;
+
+	Job() : Function(nullptr), Data(nullptr), Begin(0), End(0), Counter(nullptr) { }
+};
+
+
+// Dependency counter for a group of jobs. Every job scheduled against a
+// counter increments it and decrements it once finished; continuations
+// registered through JobSystem::RunAfter are queued as soon as the
+// counter drops back to zero.
+class JobCounter
+{
+public:
+	JobCounter() : pending(0) { }
+	// Returns true once every job tied to this counter has finished
+	GLboolean IsDone() const { return this->pending.load(std::memory_order_acquire) == 0; }
+private:
+	friend class JobSystem;
+	std::atomic<GLint> pending;
+	std::mutex         lock;
+	std::vector<Job>   continuations;
+	JobCounter(const JobCounter &);
+	JobCounter &operator=(const JobCounter &);
+};
+
+
+// A static work-stealing thread pool shared by the whole engine. Each
+// worker owns a deque it pushes to and pops from at the back, idle
+// workers steal from the front of the others. The thread calling Wait
+// or ParallelFor helps out instead of blocking, so nested parallelism
+// does not dead-lock. Without Init (or with one thread) all work simply
+// runs inline on the calling thread.
+class JobSystem
+{
+public:
+	// Starts the pool; threadCount includes the main thread, 0 picks one per hardware thread
+	static void   Init(GLuint threadCount = 0);
+	// Drains outstanding work and joins all workers
+	static void   Shutdown();
+	// Number of threads executing jobs, including the main thread
+	static GLuint ThreadCount();
+	// Schedules a job that processes [begin, end) of data
+	static void   Run(JobFunction function, void *data, GLuint begin, GLuint end, JobCounter *counter = nullptr);
+	// Schedules an arbitrary task (allocates; meant for coarse work such as asset loading)
+	static void   Run(const std::function<void()> &task, JobCounter *counter = nullptr);
+	// Schedules a task to run once all jobs of dependency have finished
+	static void   RunAfter(JobCounter &dependency, const std::function<void()> &task, JobCounter *counter = nullptr);
+	// Executes pending jobs on the calling thread until counter reaches zero
+	static void   Wait(JobCounter &counter);
+	// Splits [0, count) into chunks of grainSize and runs body on each chunk in parallel; returns when all are done
+	static void   ParallelFor(GLuint count, GLuint grainSize, JobFunction body, void *data);
+	// Convenience overload for lambdas; body is only referenced until the call returns
+	template <typename Body>
+	static void   ParallelFor(GLuint count, GLuint grainSize, const Body &body)
+	{
+		ParallelFor(count, grainSize, &JobSystem::invokeBody<Body>, const_cast<Body *>(&body));
+	}
+private:
+	// Private constructor, all functionality is static
+	JobSystem() { }
+	// Pushes a job onto the calling thread's deque (or runs it inline if there is no room)
+	static void      schedule(const Job &job);
+	// Runs a job and signals its counter
+	static void      execute(const Job &job);
+	// Pops a job from the own deque or steals one from another worker
+	static GLboolean findJob(Job &job);
+	// Entry point of each worker thread
+	static void      workerLoop(GLuint index);
+	// Trampolines
+	template <typename Body>
+	static void      invokeBody(void *data, GLuint begin, GLuint end) { (*static_cast<Body *>(data))(begin, end); }
+	static void      invokeTask(void *data, GLuint begin, GLuint end);
+};
+
+#endif
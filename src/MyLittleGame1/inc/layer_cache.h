@@ -0,0 +1,61 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "render_target.h"
+#include "sprite_renderer.h"
+
+
+// LayerCache keeps content that rarely changes (the background, the
+// bricks) in an offscreen target, so a frame composites it with a
+// single quad instead of drawing it again. The content is identified by
+// a key, typically a revision counter bumped by whatever changes it;
+// it is only redrawn when the key or the size of the viewport (window
+// resize, dynamic resolution) differs from the cached copy.
+//
+//     if (layer.Begin(revision)) { /* draw the layer */ layer.End(); }
+//     layer.Draw(renderer, width, height);
+//
+// Layers are cleared to transparent, so anything not covered by their
+// content shows what was drawn before them.
+class LayerCache
+{
+public:
+	// Cached content
+	RenderTarget Target;
+	// When disabled, Begin always returns true without redirecting any
+	// draws and Draw does nothing: the content is drawn every frame
+	GLboolean    Enabled;
+	// Whether the content covers every pixel with opaque colors; such a
+	// layer is composited without blending
+	GLboolean    Opaque;
+	// Constructor (creates no GL objects)
+	LayerCache();
+	// Redirects all following draws into the layer if the content for key is not cached yet; returns whether the caller has to draw it
+	GLboolean Begin(GLuint64 key);
+	// Ends a Begin that returned true, going back to the previous framebuffer and viewport
+	void      End();
+	// Draws the cached content as one quad covering width x height (scene units) from origin
+	void      Draw(SpriteRenderer &renderer, GLfloat width, GLfloat height, glm::vec2 origin = glm::vec2(0.0f)) const;
+	// Makes the next Begin redraw the content
+	void      Invalidate();
+private:
+	// What the target currently holds
+	GLuint64  key;
+	GLboolean valid;
+	// Framebuffer and viewport Begin redirected from
+	GLint     framebuffer;
+	GLint     viewport[4];
+};
+
+#endif
@@ -0,0 +1,76 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "game_level.h"
+
+
+// Layouts the generator knows
+enum LevelPattern {
+	LEVEL_NOISE,  // bricks scattered at random
+	LEVEL_MAZE,   // walls of a maze with corridors one tile wide
+	LEVEL_WALLS   // rows of solid wall, each with one gap, and noise between them
+};
+
+// Parameters of a generated level; the same spec always yields the same tiles
+struct LevelSpec {
+	LevelPattern Pattern;
+	GLuint       Columns, Rows;
+	GLfloat      Density;     // share of noise tiles that hold a brick
+	GLfloat      SolidRatio;  // share of bricks (other than wall rows) that are solid
+	GLuint64     Seed;
+
+	LevelSpec(LevelPattern pattern = LEVEL_NOISE, GLuint columns = 64, GLuint rows = 32, GLfloat density = 0.9f, GLfloat solidRatio = 0.05f, GLuint64 seed = 1)
+		: Pattern(pattern), Columns(columns), Rows(rows), Density(density), SolidRatio(solidRatio), Seed(seed) { }
+	GLuint64 Tiles() const { return static_cast<GLuint64>(this->Columns) * this->Rows; }
+};
+
+// A level of the standard benchmark dataset
+struct DatasetLevel {
+	std::string Name;
+	LevelSpec   Spec;
+};
+
+
+// Seeded procedural levels from 16x16 up to 4096x4096 tiles, for
+// stress tests and benchmarks. Every tile is a function of the spec and
+// its position only, so levels are generated row-parallel on the job
+// system and come out the same on any number of threads. Tiles use the
+// codes of .lvl files: 0 empty, 1 solid, 2-5 breakable colors.
+class LevelGenerator
+{
+public:
+	// Accepted number of columns and rows
+	static const GLuint MIN_SIZE = 16, MAX_SIZE = 4096;
+	// Whether the spec is within range; reports it if not
+	static GLboolean Validate(const LevelSpec &spec);
+	// Fills tiles with the level of spec; returns false (leaving tiles alone) if the spec is out of range
+	static GLboolean Generate(const LevelSpec &spec, std::vector<GLuint> &tiles);
+	// Writes the spec.Columns tiles of one row of a valid spec to tiles, for levels streamed in row by row
+	static void      GenerateRow(const LevelSpec &spec, GLuint row, GLuint *tiles);
+	// Generates straight into a level laid out in levelWidth x levelHeight
+	static GLboolean Generate(const LevelSpec &spec, GameLevel &level, GLuint levelWidth, GLuint levelHeight);
+	// The standard benchmark dataset, smallest first; soak, microbench and render_bench draw their generated levels from it
+	static const std::vector<DatasetLevel> &Dataset();
+	// Pattern names as used on command lines (noise, maze, walls)
+	static GLboolean   ParsePattern(const std::string &name, LevelPattern &pattern);
+	static const char *PatternName(LevelPattern pattern);
+private:
+	// Private constructor, all functionality is static
+	LevelGenerator() { }
+	// Tile code at column x, row y
+	static GLuint tileAt(const LevelSpec &spec, GLuint x, GLuint y);
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef METRICS_H
+#define METRICS_H
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+
+// Index of a registered metric
+typedef GLuint MetricId;
+const MetricId INVALID_METRIC = 0xFFFFFFFF;
+
+
+// Log-linear (HDR style) histogram of non-negative integers. Values
+// below 2 * SUB_BUCKETS are counted exactly; above that every power of
+// two is split into SUB_BUCKETS buckets, so any value is known to within
+// 1/SUB_BUCKETS (about 1.6%) over the whole range. Values beyond
+// MAX_VALUE are clamped.
+class Histogram
+{
+public:
+	static const GLuint   SUB_BUCKET_BITS = 6;
+	static const GLuint   SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static const GLuint   MAX_BITS = 40;
+	static const GLuint64 MAX_VALUE = (1ull << MAX_BITS) - 1;
+	static const GLuint   BUCKETS = 2 * SUB_BUCKETS + (MAX_BITS - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+	// Number of values recorded per bucket, and their total
+	GLuint64 Counts[BUCKETS];
+	GLuint64 Count, Sum;
+	// Constructor
+	Histogram() { this->Reset(); }
+	// Adds a value
+	void      Record(GLuint64 value) { this->Add(BucketOf(value), 1, value); }
+	// Adds count values falling into a bucket, summing to sum
+	void      Add(GLuint bucket, GLuint64 count, GLuint64 sum);
+	// Adds all values of another histogram
+	void      Merge(const Histogram &other);
+	// Removes the values of an earlier state of this histogram, leaving what was recorded since
+	void      Subtract(const Histogram &earlier);
+	// Empties the histogram
+	void      Reset();
+	// Value below which the given fraction (0..1) of all values lies, within the bucket resolution
+	GLuint64  Percentile(GLdouble fraction) const;
+	GLuint64  Min() const;
+	GLuint64  Max() const;
+	GLdouble  Mean() const { return this->Count > 0 ? static_cast<GLdouble>(this->Sum) / this->Count : 0.0; }
+	// Bucket a value is counted in, and the range of values sharing it
+	static GLuint   BucketOf(GLuint64 value);
+	static GLuint64 LowestOf(GLuint bucket);
+	static GLuint64 HighestOf(GLuint bucket);
+};
+
+
+// Everything recorded between two calls of Metrics::Collect. Counters
+// and histograms cover the interval only, gauges hold their last value.
+struct MetricsSnapshot {
+	GLdouble                                      Time, Interval;  // seconds since the first Collect, and since the previous one
+	std::vector<std::pair<std::string, GLuint64>> Counters;
+	std::vector<std::pair<std::string, GLint64>>  Gauges;
+	std::vector<std::pair<std::string, Histogram>> Histograms;
+	// Writes the snapshot as a single line of JSON (without the newline)
+	void WriteJson(std::ostream &out) const;
+};
+
+
+// A static registry of counters, gauges and histograms. Metrics are
+// registered by name once (registering a name again returns the same
+// id) and can then be recorded from any thread. Counters and histograms
+// are written to a shard owned by the recording thread with plain loads
+// and stores, so recording never waits and never contends; Collect
+// merges the shards of all threads. Gauges are single values that the
+// last Set wins. StartExport appends a snapshot per interval to a
+// JSON-lines file from a background thread, rotating the file once it
+// grows too large.
+class Metrics
+{
+public:
+	// Maximum number of metrics of each kind
+	static const GLuint MAX_COUNTERS = 64, MAX_GAUGES = 64, MAX_HISTOGRAMS = 16;
+	// Registration; returns INVALID_METRIC once all slots of a kind are taken
+	static MetricId        RegisterCounter(const std::string &name);
+	static MetricId        RegisterGauge(const std::string &name);
+	static MetricId        RegisterHistogram(const std::string &name);
+	// Recording; invalid ids are ignored
+	static void            Add(MetricId counter, GLuint64 amount = 1);
+	static void            Set(MetricId gauge, GLint64 value);
+	static void            Record(MetricId histogram, GLuint64 value);
+	// Merges all shards and returns what was recorded since the previous Collect
+	static MetricsSnapshot Collect();
+	// Starts appending a snapshot every interval seconds to path; once the file exceeds maxFileBytes
+	// it is renamed to path.1 (path.1 to path.2 and so on, keeping maxFiles old files)
+	static GLboolean       StartExport(const std::string &path, GLfloat interval = 10.0f, GLuint64 maxFileBytes = 16 * 1024 * 1024, GLuint maxFiles = 4);
+	// Writes a last snapshot and stops the export thread
+	static void            StopExport();
+private:
+	// Private constructor, all functionality is static
+	Metrics() { }
+	// Body of the export thread
+	static void exportLoop(std::string path, GLfloat interval, GLuint64 maxFileBytes, GLuint maxFiles);
+};
+
+
+// Records the time from its construction to its destruction, in
+// microseconds, into a histogram
+class MetricTimer
+{
+public:
+	MetricTimer(MetricId histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) { }
+	~MetricTimer()
+	{
+		Metrics::Record(this->histogram, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start).count());
+	}
+private:
+	MetricId                              histogram;
+	std::chrono::steady_clock::time_point start;
+	MetricTimer(const MetricTimer &);
+	MetricTimer &operator=(const MetricTimer &);
+};
+
+#endif
@@ -0,0 +1,40 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+#include <string>
+
+#include <GL/glew.h>
+
+
+// OffscreenContext creates an OpenGL 3.3 core context that does not need
+// a display, so rendering can be measured on build machines. Built with
+// LITTLEGAME_EGL it uses a surfaceless EGL display (Mesa's llvmpipe works
+// without any GPU or X server), otherwise an invisible GLFW window. Draw
+// into a RenderTarget: a surfaceless context has no default framebuffer.
+class OffscreenContext
+{
+public:
+	// Constructor/Destructor
+	OffscreenContext();
+	~OffscreenContext();
+	// Creates the context, makes it current and loads the GL entry points
+	GLboolean   Create(GLuint width, GLuint height);
+	// Releases the context
+	void        Destroy();
+	// Name of the GL implementation in use, e.g. "llvmpipe (LLVM 15.0.7, 256 bits)"
+	std::string Renderer() const;
+private:
+	// Native handles, kept opaque so the platform headers stay out of this header
+	void *display, *surface, *context, *window;
+	OffscreenContext(const OffscreenContext &);
+	OffscreenContext &operator=(const OffscreenContext &);
+};
+
+#endif
@@ -16,7 +16,8 @@
 
 #include "shader.h"
 #include "texture.h"
-#include "game_object.h"
+#include "random.h"
+#include "state_image.h"
 
 
 // Represents a single particle and its state
@@ -28,33 +29,73 @@ struct Particle {
 	Particle() : Position(0.0f), Velocity(0.0f), Color(1.0f), Life(0.0f) { }
 };
 
+// Width and height particles are drawn with (the scale in particle.vs)
+const GLfloat PARTICLE_SIZE = 10.0f;
+
+// A batch of particles queued for spawning at the next Update
+struct ParticleEmission {
+	glm::vec2 Position, Velocity, Offset;
+	GLuint    Count;
+};
+
 
 // ParticleGenerator acts as a container for rendering a large number of 
 // particles by repeatedly spawning and updating particles and killing 
 // them after a given amount of time.
+// Updates run in fixed-size chunks on the job system. Respawns are
+// assigned to chunks up front and draw their random numbers from a
+// counter-based stream, so the result for a given seed is the same no
+// matter how many threads take part.
 class ParticleGenerator
 {
 public:
-	// Constructor
-	ParticleGenerator(Shader shader, Texture2D texture, GLuint amount);
-	// Update all particles
-	void Update(GLfloat dt, GameObject &object, GLuint newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+	// Constructor; the shader is referenced and has to outlive the generator
+	ParticleGenerator(Shader &shader, TextureView texture, GLuint amount, GLuint64 seed = 0);
+	// Queues newParticles to be spawned at position (moving along with velocity) by the next Update
+	void Emit(glm::vec2 position, glm::vec2 velocity, GLuint newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+	// Spawns queued emissions and advances all particles by dt
+	void Update(GLfloat dt);
 	// Render all particles
 	void Draw();
+	// Render the live particles of a copy of the pool (taken through Particles)
+	void Draw(const std::vector<Particle> &particles);
+	// Sets the projection particles are drawn with (the camera's view)
+	void SetProjection(const glm::mat4 &projection);
+	// Restarts the random stream used for respawns
+	void Seed(GLuint64 seed);
+	// Writes the position within the random stream to a state image, and restores it; the particles themselves are
+	// only for show and stay as they are, but the ones spawned after a restore are those spawned back then
+	void SaveState(StateWriter &writer) const;
+	GLboolean LoadState(StateReader &reader);
+	// Read access to the particle pool
+	const std::vector<Particle> &Particles() const { return this->particles; }
+	// Number of particles currently alive
+	GLuint LiveCount() const;
 private:
 	// State
 	std::vector<Particle> particles;
 	GLuint amount;
+	// Spawn state
+	GLuint64 seed;
+	GLuint64 spawned;       // total number of particles spawned so far; indexes the random stream
+	GLuint   recycleCursor; // next live particle to overwrite when the pool is exhausted
+	std::vector<ParticleEmission> emissions;
+	std::vector<GLuint> emissionEnds;  // running total of emission counts, for lookup by spawn index
+	std::vector<GLuint> chunkSpawns;   // per chunk: dead particles found, then the number to respawn
+	std::vector<GLuint> chunkFirst;    // per chunk: index of its first spawn within this update
 	// Render state
-	Shader shader;
-	Texture2D texture;
-	GLuint VAO;
-	// Initializes buffer and vertex attributes
+	Shader       *shader;
+	TextureView   texture;
+	GLVertexArray VAO;
+	GLBuffer      VBO;
+	// Initializes buffer and vertex attributes (deferred to the first Draw so updates work without a GL context)
 	void init();
-	// Returns the first Particle index that's currently unused e.g. Life <= 0.0f or 0 if no particle is currently inactive
-	GLuint firstUnusedParticle();
-	// Respawns particle
-	void respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+	// Counts dead particles of a chunk
+	void countDead(GLuint chunk);
+	// Respawns the chunk's share of new particles, then advances the chunk by dt
+	void updateChunk(GLuint chunk, GLfloat dt);
+	// Respawns particle as the spawnIndex-th spawn of this update
+	void respawnParticle(Particle &particle, GLuint spawnIndex);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef PNG_IMAGE_H
+#define PNG_IMAGE_H
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+
+// Minimal PNG support for the offscreen tools. Images are written with
+// a small built-in deflate encoder (LZ77 with the fixed Huffman codes,
+// no zlib needed) and read back through stb_image. Pixels are 8 bits
+// per channel, rows top to bottom, 1 to 4 channels (gray to RGBA).
+class PngImage
+{
+public:
+	// Encodes pixels as a PNG file
+	static GLboolean Write(const std::string &file, GLuint width, GLuint height, GLuint channels, const std::vector<unsigned char> &pixels);
+	// Decodes a PNG file, converting it to the requested number of channels
+	static GLboolean Read(const std::string &file, GLuint &width, GLuint &height, GLuint channels, std::vector<unsigned char> &pixels);
+private:
+	// Private constructor, all functionality is static
+	PngImage() { }
+	// Compresses data into a zlib stream
+	static void   deflate(const std::vector<unsigned char> &data, std::vector<unsigned char> &out);
+	// Appends a chunk with its length and CRC
+	static void   writeChunk(std::vector<unsigned char> &out, const char *type, const std::vector<unsigned char> &data);
+	// CRC-32 as used by PNG chunks
+	static GLuint crc(const unsigned char *data, size_t length, GLuint crc = 0);
+};
+
+#endif
@@ -0,0 +1,47 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <GL/glew.h>
+
+
+// Small deterministic random number generator (SplitMix64). Its whole
+// state is one integer that can be seeded, copied and stored, and any
+// position of a stream can be computed directly through At, which lets
+// parallel code draw numbers without sharing state between threads.
+class Random
+{
+public:
+	// Generator state
+	GLuint64 State;
+	// Constructor
+	Random(GLuint64 seed = 0) : State(seed) { }
+	// Restarts the stream from the given seed
+	void     Seed(GLuint64 seed) { this->State = seed; }
+	// Returns the next 64 random bits
+	GLuint64 Next() { this->State += GOLDEN_GAMMA; return mix(this->State); }
+	// Returns a float in [0, 1)
+	GLfloat  NextFloat() { return static_cast<GLfloat>(this->Next() >> 40) * (1.0f / 16777216.0f); }
+	// Returns a float in [min, max)
+	GLfloat  Range(GLfloat min, GLfloat max) { return min + (max - min) * this->NextFloat(); }
+	// Returns the index-th value of the stream seeded with seed (At(s, 0) equals the first Next() after Seed(s))
+	static GLuint64 At(GLuint64 seed, GLuint64 index) { return mix(seed + (index + 1) * GOLDEN_GAMMA); }
+private:
+	static const GLuint64 GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+	// SplitMix64 output function
+	static GLuint64 mix(GLuint64 z)
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_SNAPSHOT_H
+#define RENDER_SNAPSHOT_H
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "particle_generator.h"
+#include "texture.h"
+
+
+// A sprite as it is drawn
+struct SpriteInstance {
+	TextureView Texture;
+	glm::vec2   Position, Size;
+	GLfloat     Rotation;
+	glm::vec3   Color;
+
+	SpriteInstance() : Texture(), Position(0.0f), Size(0.0f), Rotation(0.0f), Color(1.0f) { }
+	SpriteInstance(const TextureView &texture, glm::vec2 position, glm::vec2 size, GLfloat rotation, glm::vec3 color)
+		: Texture(texture), Position(position), Size(size), Rotation(rotation), Color(color) { }
+};
+
+// Everything Game::Render needs of the simulation state, copied out by
+// Game::Snapshot so the simulation can go on while it is drawn. The
+// arrays keep their capacity, so refilling a snapshot does not allocate
+// once it has seen the largest scene.
+struct RenderSnapshot {
+	GLuint                      State;          // GameState
+	GLdouble                    Time;           // wall clock time the simulation had reached (glfwGetTime)
+	glm::vec2                   View;           // top left corner of the camera's view
+	GLuint                      LevelRevision, BrickRevision;
+	std::vector<SpriteInstance> SolidBricks;    // bricks left standing
+	std::vector<SpriteInstance> Bricks;
+	SpriteInstance              Player;
+	GLboolean                   HeldLeft, HeldRight;  // movement keys held for the last tick (by the autopilot, if it plays)
+	std::vector<SpriteInstance> Balls;
+	std::vector<GLboolean>      BallStuck;      // per ball: resting on the paddle
+	std::vector<Particle>       Particles;
+	GLuint                      LiveBricks, LiveParticles;  // in a scrolling playfield LiveBricks counts the bricks in view
+
+	RenderSnapshot() : State(0), Time(0.0), View(0.0f), LevelRevision(0), BrickRevision(0), HeldLeft(GL_FALSE), HeldRight(GL_FALSE), LiveBricks(0), LiveParticles(0) { }
+};
+
+#endif
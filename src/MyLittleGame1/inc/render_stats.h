@@ -0,0 +1,33 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <GL/glew.h>
+
+
+// A static counter of the GL work submitted by the renderers. Benchmarks
+// reset it before a frame and read it afterwards to compare renderer
+// changes by more than frame time alone.
+class RenderStats
+{
+public:
+	// Work submitted since the last Reset
+	static GLuint DrawCalls;
+	static GLuint Vertices;
+	// Records a single draw call of the given number of vertices
+	static void   Draw(GLuint vertices) { ++DrawCalls; Vertices += vertices; }
+	// Sets all counters back to zero
+	static void   Reset();
+private:
+	// Private constructor, all functionality is static
+	RenderStats() { }
+};
+
+#endif
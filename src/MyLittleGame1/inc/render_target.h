@@ -0,0 +1,44 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gl_object.h"
+#include "texture.h"
+
+
+// RenderTarget is a framebuffer object with a single color texture
+// (no depth buffer; the game draws back to front). Rendering into it
+// works the same with or without a window, and its pixels can be read
+// back or used as a texture. Owns both GL objects (move-only).
+class RenderTarget
+{
+public:
+	// Framebuffer object and its color attachment
+	GLFramebuffer Framebuffer;
+	Texture2D     Color;
+	GLuint        Width, Height;
+	// Constructor (does not create any GL objects)
+	RenderTarget();
+	// Creates the framebuffer and its color texture; returns false if the framebuffer is incomplete
+	GLboolean Generate(GLuint width, GLuint height);
+	// Makes this the target of all following draws and sets the viewport to cover it
+	void      Bind() const;
+	// Switches back to the default framebuffer of the given size
+	static void BindDefault(GLuint width, GLuint height);
+	// Reads back the color buffer as tightly packed RGBA rows, bottom row first
+	void      ReadPixels(std::vector<unsigned char> &pixels) const;
+	// Deletes the GL objects now rather than at destruction
+	void      Destroy();
+};
+
+#endif
@@ -0,0 +1,73 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+#include <GL/glew.h>
+
+#include "gl_object.h"
+#include "render_target.h"
+
+
+// Dynamic resolution. The scene is drawn into an offscreen target at a
+// fraction (Scale, per axis) of the output size and then stretched onto
+// the output framebuffer, so fill rate bound renderers (software
+// rasterizers above all) draw fewer pixels. Every few frames the scale
+// is adjusted towards holding TargetFrameTime, based on the GPU time of
+// recent frames (timer queries, read back a few frames late so nothing
+// stalls) or on the frame time where those are not available or not
+// meaningful. The
+// target is allocated at full size once and only a corner of it is
+// used, so changing the scale never reallocates. Anything drawn after
+// End (a HUD, text) goes straight to the output at native resolution.
+class ResolutionScaler
+{
+public:
+	// Settings
+	GLfloat      MinScale, MaxScale;
+	GLfloat      TargetFrameTime;  // seconds
+	// Current fraction of the output resolution
+	GLfloat      Scale;
+	// Smoothed GPU time of a frame in seconds (0 while no timer query has returned)
+	GLfloat      GpuTime;
+	// Whether timer queries are used; Init turns them off on software rasterizers, whose
+	// queries do not cover the deferred rasterization, leaving the controller to the frame time
+	GLboolean    UseGpuTimer;
+	// Offscreen target the scene is drawn into
+	RenderTarget Target;
+	// Constructor (creates no GL objects)
+	ResolutionScaler(GLfloat targetFrameTime = 1.0f / 60.0f, GLfloat minScale = 0.5f, GLfloat maxScale = 1.0f);
+	// Creates the offscreen target for an output of the given size
+	GLboolean Init(GLuint width, GLuint height);
+	// Redirects all following draws into the scaled target (the caller clears it)
+	void      Begin();
+	// Stretches the frame onto framebuffer (0 is the window) and adapts the scale; frameTime is the duration of the last frame in seconds
+	void      End(GLfloat frameTime, GLuint framebuffer = 0);
+	// Size of the part of the target in use
+	GLuint    ScaledWidth() const;
+	GLuint    ScaledHeight() const;
+private:
+	// Timer queries in flight; results are read once available
+	static const GLuint QUERIES = 4;
+	GLQuery   queries[QUERIES];
+	GLboolean pending[QUERIES];
+	GLuint    query;
+	GLboolean timing;
+	// Controller state
+	GLfloat   frameTime;
+	GLuint    framesSinceChange;
+	// Output size
+	GLuint    width, height;
+	// Folds finished timer queries into GpuTime
+	void collectQueries();
+	// Moves Scale towards the target frame time
+	void adapt();
+};
+
+#endif
@@ -9,8 +9,8 @@
 #ifndef RESOURCE_MANAGER_H
 #define RESOURCE_MANAGER_H
 
-#include <map>
 #include <string>
+#include <vector>
 
 #include <GL/glew.h>
 
@@ -18,36 +18,66 @@
 
 #include "texture.h"
 #include "shader.h"
+#include "resource_pool.h"
+
+
+// Handles to stored resources
+typedef ResourceHandle<Texture2D> TextureHandle;
+typedef ResourceHandle<Shader>    ShaderHandle;
+
+
+// Describes a single texture to load as part of a batch
+struct TextureRequest {
+	const GLchar *File;
+	GLboolean     Alpha;
+	HashedName    Name;
+};
 
 
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
-// and/or shader is also stored for future reference by string
-// handles. All functions and resources are static and no 
-// public constructor is defined.
+// and/or shader is also stored for future reference under its
+// hashed name. Names are meant to be resolved into handles once,
+// at load time; a handle then gives array-speed access from any
+// thread. Failed lookups are explicit: Find returns an invalid
+// handle and Get reports the missing resource instead of creating
+// one. All functions and resources are static and no public
+// constructor is defined.
 class ResourceManager
 {
 public:
-	// Resource storage
-	static std::map<std::string, Shader>    Shaders;
-	static std::map<std::string, Texture2D> Textures;
+	// Maximum number of resources of each type
+	static const GLuint MAX_SHADERS = 64, MAX_TEXTURES = 256;
 	// Loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-	static Shader   LoadShader(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile, std::string name);
-	// Retrieves a stored sader
-	static Shader   GetShader(std::string name);
+	static ShaderHandle  LoadShader(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile, HashedName name);
+	// Resolves a shader name; returns an invalid handle if no such shader is loaded
+	static ShaderHandle  FindShader(HashedName name);
+	// Retrieves a stored shader
+	static Shader       &GetShader(ShaderHandle handle);
+	static Shader       &GetShader(HashedName name);
 	// Loads (and generates) a texture from file
-	static Texture2D LoadTexture(const GLchar *file, GLboolean alpha, std::string name);
+	static TextureHandle LoadTexture(const GLchar *file, GLboolean alpha, HashedName name);
+	// Loads a batch of textures; images are decoded in parallel on the job system and uploaded on the calling thread
+	static void          LoadTextures(const std::vector<TextureRequest> &requests);
+	// Resolves a texture name; returns an invalid handle if no such texture is loaded
+	static TextureHandle FindTexture(HashedName name);
 	// Retrieves a stored texture
-	static Texture2D GetTexture(std::string name);
-	// Properly de-allocates all loaded resources
-	static void      Clear();
+	static const Texture2D &GetTexture(TextureHandle handle);
+	static const Texture2D &GetTexture(HashedName name);
+	// Properly de-allocates all loaded resources; handles resolved before become stale
+	static void          Clear();
 private:
+	// Resource storage
+	static ResourcePool<Shader, MAX_SHADERS>     shaders;
+	static ResourcePool<Texture2D, MAX_TEXTURES> textures;
 	// Private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
 	ResourceManager() { }
 	// Loads and generates a shader from file
 	static Shader    loadShaderFromFile(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile = nullptr);
 	// Loads a single texture from file
 	static Texture2D loadTextureFromFile(const GLchar *file, GLboolean alpha);
+	// Adds a texture to the storage
+	static TextureHandle storeTexture(HashedName name, Texture2D &&texture);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,158 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RESOURCE_POOL_H
+#define RESOURCE_POOL_H
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <GL/glew.h>
+
+
+// 64-bit FNV-1a hash of a resource name. String literals are hashed at
+// compile time; other strings have to be converted explicitly, which
+// keeps accidental per-call hashing of runtime strings visible.
+class HashedName
+{
+public:
+	GLuint64 Value;
+	// Hashes a literal, at compile time in constant expressions
+	template <size_t N>
+	constexpr HashedName(const char (&name)[N]) : Value(Hash(name)) { }
+	// Hashes a runtime string
+	explicit HashedName(const std::string &name) : Value(Hash(name.c_str())) { }
+	explicit HashedName(const char *name) : Value(Hash(name)) { }
+	bool operator==(const HashedName &other) const { return this->Value == other.Value; }
+	bool operator!=(const HashedName &other) const { return this->Value != other.Value; }
+	// The hash function itself (recursive to stay a C++11 constexpr)
+	static constexpr GLuint64 Hash(const char *name, GLuint64 hash = 14695981039346656037ull)
+	{
+		return *name ? Hash(name + 1, (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ull) : hash;
+	}
+};
+
+
+// Typed handle to a resource stored in a ResourcePool. The generation
+// changes whenever the pool is cleared, so handles resolved before are
+// detected as stale instead of silently referring to another resource.
+template <typename T>
+struct ResourceHandle {
+	GLuint Index, Generation;
+
+	ResourceHandle() : Index(0xFFFFFFFF), Generation(0) { }
+	ResourceHandle(GLuint index, GLuint generation) : Index(index), Generation(generation) { }
+	GLboolean IsValid() const { return this->Index != 0xFFFFFFFF; }
+	bool operator==(const ResourceHandle &other) const { return this->Index == other.Index && this->Generation == other.Generation; }
+	bool operator!=(const ResourceHandle &other) const { return !(*this == other); }
+};
+
+
+// Fixed-capacity storage of resources of one type, addressed by handle
+// (an array index) and found by hashed name through an open-addressing
+// table. Storage never moves, so reads (Find, IsAlive, Get) take no lock
+// and may run on any thread while resources are being added; adding
+// and clearing are serialized by a mutex. Replacing a resource that
+// another thread is reading at the same time is not supported.
+template <typename T, GLuint Capacity>
+class ResourcePool
+{
+public:
+	// Constructor (slots are constructed on demand)
+	ResourcePool() : count(0)
+	{
+		for (GLuint i = 0; i < Capacity; ++i)
+			this->generations[i].store(0, std::memory_order_relaxed);
+		for (GLuint i = 0; i < TABLE_SIZE; ++i)
+			this->names[i].store(0, std::memory_order_relaxed);
+	}
+	~ResourcePool() { this->Clear(); }
+	// Handle of the resource stored under name; an invalid handle if there is none
+	ResourceHandle<T> Find(HashedName name) const
+	{
+		GLuint start = static_cast<GLuint>(name.Value % TABLE_SIZE);
+		for (GLuint probe = 0; probe < TABLE_SIZE; ++probe)
+		{
+			GLuint entry = (start + probe) % TABLE_SIZE;
+			GLuint64 stored = this->names[entry].load(std::memory_order_acquire);
+			if (stored == 0)
+				break;
+			if (stored == name.Value)
+			{
+				GLuint slot = this->slots[entry];
+				return ResourceHandle<T>(slot, this->generations[slot].load(std::memory_order_acquire));
+			}
+		}
+		return ResourceHandle<T>();
+	}
+	// Whether the handle refers to a resource of the current generation
+	GLboolean IsAlive(ResourceHandle<T> handle) const
+	{
+		return handle.Index < Capacity && (handle.Generation & 1) && this->generations[handle.Index].load(std::memory_order_acquire) == handle.Generation;
+	}
+	// Resource of a live handle
+	T &Get(ResourceHandle<T> handle)
+	{
+		assert(this->IsAlive(handle));
+		return *reinterpret_cast<T *>(&this->items[handle.Index]);
+	}
+	// Stores a resource under name, replacing (and thereby releasing) one stored under the same name before
+	ResourceHandle<T> Store(HashedName name, T &&item)
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		ResourceHandle<T> existing = this->Find(name);
+		if (existing.IsValid())
+		{
+			this->Get(existing) = std::move(item);
+			return existing;
+		}
+		if (this->count == Capacity)
+			return ResourceHandle<T>();
+		GLuint slot = this->count++;
+		new (&this->items[slot]) T(std::move(item));
+		// An odd generation marks the slot as live; publishing it makes the item visible to readers
+		GLuint generation = this->generations[slot].load(std::memory_order_relaxed) + 1;
+		this->generations[slot].store(generation, std::memory_order_release);
+		GLuint entry = static_cast<GLuint>(name.Value % TABLE_SIZE);
+		while (this->names[entry].load(std::memory_order_relaxed) != 0)
+			entry = (entry + 1) % TABLE_SIZE;
+		this->slots[entry] = slot;
+		this->names[entry].store(name.Value, std::memory_order_release);
+		return ResourceHandle<T>(slot, generation);
+	}
+	// Destroys every resource; all handles become stale
+	void Clear()
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		for (GLuint slot = 0; slot < this->count; ++slot)
+		{
+			reinterpret_cast<T *>(&this->items[slot])->~T();
+			this->generations[slot].fetch_add(1, std::memory_order_release);
+		}
+		for (GLuint i = 0; i < TABLE_SIZE; ++i)
+			this->names[i].store(0, std::memory_order_release);
+		this->count = 0;
+	}
+private:
+	// Name table size; kept at most half full so probe sequences stay short
+	static const GLuint TABLE_SIZE = Capacity * 2;
+	typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type items[Capacity];
+	std::atomic<GLuint>   generations[Capacity];
+	std::atomic<GLuint64> names[TABLE_SIZE];
+	GLuint                slots[TABLE_SIZE];
+	GLuint                count;
+	std::mutex            lock;
+	ResourcePool(const ResourcePool &);
+	ResourcePool &operator=(const ResourcePool &);
+};
+
+#endif
@@ -0,0 +1,97 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "state_image.h"
+
+
+// RewindBuffer keeps the state images of the most recent ticks within a
+// fixed memory budget. Every KeyframeInterval ticks a keyframe is stored,
+// the ticks in between only store how they differ from their keyframe:
+// the XOR of both images, run-length encoded so the unchanged bytes (most
+// of them) cost next to nothing. Since a delta depends on its keyframe
+// alone, any buffered tick is restored by decoding at most two frames.
+// The encoded frames live in a ring of Budget bytes, and at most
+// MAX_FRAMES ticks are kept; when either is full the oldest keyframe is
+// dropped along with its deltas. Both are reserved when the budget is
+// set, so recording does not allocate once the first images went in.
+class RewindBuffer
+{
+public:
+	// Ticks from one keyframe to the next
+	static const GLuint DEFAULT_KEYFRAME_INTERVAL = 30;
+	GLuint KeyframeInterval;
+	// Most ticks buffered at once (ten minutes at 60 ticks a second), however small their images are
+	static const GLuint MAX_FRAMES = 36000;
+	// Constructor; a buffer without a budget stores nothing
+	RewindBuffer(size_t budget = 0, GLuint keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+	// Drops all frames and sets the number of bytes the encoded frames may take (reserved, the memory is only touched as frames come in)
+	void      SetBudget(size_t budget);
+	size_t    Budget() const { return this->budget; }
+	// Drops all frames
+	void      Clear();
+	// Stores the image of the given tick. Frames of that tick and later are replaced, as after seeking
+	// back; a tick not following the newest frame starts the buffer over. Returns false if it did not fit
+	GLboolean Record(GLuint64 tick, const StateImage &image);
+	// Decodes the image of a buffered tick into image; returns false if the tick is not buffered
+	GLboolean Seek(GLuint64 tick, StateImage &image);
+	// Buffered ticks, [FirstTick, LastTick] when not Empty
+	GLboolean Empty() const { return this->count == 0; }
+	GLuint64  FirstTick() const;
+	GLuint64  LastTick() const;
+	GLboolean Contains(GLuint64 tick) const { return this->count > 0 && tick >= this->FirstTick() && tick <= this->LastTick(); }
+	// Bytes taken by the encoded frames, and how many of the frames are keyframes
+	size_t    Bytes() const { return this->bytes; }
+	GLuint    Keyframes() const { return this->keyframes; }
+private:
+	// Where a tick's encoded image lives within the ring
+	struct Frame {
+		GLuint64 Tick, Keyframe;  // Keyframe == Tick for keyframes
+		size_t   Offset, Size;    // encoded bytes in the ring; an empty frame's offset may be the end of the ring
+		size_t   Length;          // size of the decoded image
+	};
+	// Encoded frames, in a ring of at most budget bytes
+	std::vector<GLubyte> ring;
+	size_t               budget;
+	// Frame records of consecutive ticks, oldest at frames[head]
+	std::vector<Frame>   frames;
+	GLuint               head, count;
+	size_t               bytes;
+	GLuint               keyframes;
+	// Decoded image of the keyframe deltas are currently taken against or restored from
+	StateImage           keyImage;
+	GLuint64             keyTick;
+	GLboolean            keyValid;
+	// Scratch space for encoding: the XOR of the images, and its encoding
+	std::vector<GLubyte> delta, encoded;
+	// Record of the index-th buffered frame (0 being the oldest)
+	Frame       &frame(GLuint index) { return this->frames[(this->head + index) % this->frames.size()]; }
+	const Frame &frame(GLuint index) const { return this->frames[(this->head + index) % this->frames.size()]; }
+	// Drops the oldest keyframe and its deltas, or the newest frame
+	void      dropOldest();
+	void      dropNewest();
+	// Finds room for size encoded bytes, dropping old frames as needed; returns false if they can never fit
+	GLboolean reserve(size_t size, size_t &offset);
+	// Makes the ring at least size bytes long (within its reserved budget)
+	void      grow(size_t size);
+	// Appends a frame record, growing the record ring (within its reserved MAX_FRAMES) when it is full
+	void      pushFrame(const Frame &frame);
+	// Makes keyImage hold the decoded keyframe of the given tick
+	void      loadKeyframe(GLuint64 tick);
+	// XORs image against base (zeros past its end) and run-length encodes the result into encoded
+	void      encode(const StateImage &image, const StateImage *base);
+	// Applies an encoded XOR to image
+	static void decode(const GLubyte *data, size_t size, StateImage &image);
+};
+
+#endif
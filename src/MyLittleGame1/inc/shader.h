@@ -15,16 +15,19 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_object.h"
+
 
 // General purpsoe shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
-// functions for easy management.
+// functions for easy management. Owns its program object (move-only);
+// renderers refer to the stored shader instead of keeping copies.
 class Shader
 {
 public:
 	// State
-	GLuint ID;
-	// Constructor
+	GLProgram Program;
+	// Constructor (the program is created by Compile)
 	Shader() { }
 	// Sets the current shader as active
 	Shader  &Use();
@@ -0,0 +1,122 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SIM_STATE_H
+#define SIM_STATE_H
+#include <atomic>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "components.h"
+#include "game.h"
+#include "random.h"
+
+
+// Tiles per page of a BrickPages grid
+const GLuint BRICK_PAGE_TILES = 1024;
+// Most balls a SimState follows; any further balls of a multi-ball game are left out
+const GLuint SIM_MAX_BALLS = 16;
+
+
+// Tile codes of a level, split into fixed-size pages that copies share.
+// Copying a grid only shares its page table; the first write to a shared
+// table or page copies that one alone, so copies of a huge level cost no
+// more than copies of a small one until they start breaking bricks.
+// References are counted atomically, so copies may be used (and
+// destroyed) on different threads.
+class BrickPages
+{
+public:
+	// Constructor/Destructor; copies share all pages
+	BrickPages() : table(nullptr) { }
+	BrickPages(const BrickPages &other);
+	BrickPages &operator=(const BrickPages &other);
+	~BrickPages();
+	// Replaces the grid with count tile codes (codes above 255 are clamped)
+	void    Assign(const GLuint *tiles, GLuint count);
+	// Number of tiles
+	GLuint  Size() const { return this->table ? this->table->Size : 0; }
+	// Tile code at index; index has to be below Size
+	GLubyte Get(GLuint index) const { return this->table->Pages[index / BRICK_PAGE_TILES]->Tiles[index % BRICK_PAGE_TILES]; }
+	// Changes the tile code at index, first copying the table and page if other grids share them
+	void    Set(GLuint index, GLubyte tile);
+private:
+	struct Page {
+		std::atomic<GLuint> References;
+		GLubyte             Tiles[BRICK_PAGE_TILES];
+	};
+	struct Table {
+		std::atomic<GLuint> References;
+		GLuint              Size;
+		std::vector<Page *> Pages;
+	};
+	Table *table;
+	// Drop a reference, deleting what is no longer referenced
+	static void release(Table *table);
+	static void release(Page *page);
+};
+
+
+// A ball as SimState keeps it: the components of a ball entity
+struct SimBall {
+	Transform Box;
+	Velocity  Motion;
+	Ball      State;
+	GLfloat   Radius;
+};
+
+
+// SimState is a small, flat copy of what a Game simulates (the paddle,
+// the balls and the bricks of the current level), stepped by the same
+// movement and collision rules (see game_systems.h). Copying a SimState
+// forks it: the balls and paddle are plain values and the bricks are
+// shared copy-on-write, so a fork costs about as much as copying a few
+// hundred bytes, and forks may be stepped on any thread. Collisions are
+// resolved ball by ball, tile by tile, rather than in broadphase order,
+// so a fork can drift from the game it was taken from when a ball hits
+// two things in the same tick; it is meant for looking ahead, not for
+// replaying a game.
+class SimState
+{
+public:
+	// Playfield
+	GLuint     Width, Height;
+	// Paddle and balls
+	Transform  Paddle;
+	SimBall    Balls[SIM_MAX_BALLS];
+	GLuint     BallCount;
+	// Tile codes of the level, row by row; broken bricks are empty tiles
+	BrickPages Bricks;
+	GLuint     Columns, Rows;
+	glm::vec2  TileSize;
+	// Breakable bricks left
+	GLuint     BricksLeft;
+	// Ticks run, counting from the game's
+	GLuint64   Ticks;
+	// Random stream for whatever steers a fork (such as rollout policies); forks continue it on their own
+	Random     Rng;
+	// Set once the last ball fell out, the fork stops there
+	GLboolean  Lost;
+	// Constructor (an empty state until Capture)
+	SimState();
+	// Takes the state of a game playing a level; returns false in the endless mode, which it does not cover
+	GLboolean Capture(const Game &game);
+	// Runs one tick with the given keys held (release being the space bar), as ProcessInput and Update do
+	void      Step(GLboolean left, GLboolean right, GLboolean release, GLfloat dt = TICK_DURATION);
+	// Tile code at column x of row y
+	GLubyte   Tile(GLuint x, GLuint y) const { return this->Bricks.Get(y * this->Columns + x); }
+private:
+	// Moves the balls still stuck to the paddle along with it
+	void moveStuckBalls(GLfloat dx);
+	// Resolves the collisions of a ball with the tiles under it
+	void collideBricks(SimBall &ball);
+};
+
+#endif
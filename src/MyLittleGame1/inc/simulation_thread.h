@@ -0,0 +1,67 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+#include <atomic>
+#include <thread>
+
+#include <GL/glew.h>
+
+#include "autopilot.h"
+#include "game.h"
+#include "input_queue.h"
+#include "input_recording.h"
+#include "render_snapshot.h"
+#include "triple_buffer.h"
+
+
+// Runs a Game's fixed ticks on a thread of its own. Input events are
+// taken from the queue at the tick covering their timestamp, and after
+// every batch of ticks a RenderSnapshot is published through a triple
+// buffer, so the render thread draws the newest state without ever
+// waiting and a slow frame does not hold up the simulation. While the
+// thread runs it owns the game's simulation state; the render thread
+// may only call Game::Render with a snapshot.
+class SimulationThread
+{
+public:
+	// Snapshots of the simulation; the render thread Acquires and reads Front
+	TripleBuffer<RenderSnapshot> Snapshots;
+	// Constructor/Destructor (stops the thread)
+	SimulationThread();
+	~SimulationThread();
+	// Publishes a first snapshot and starts ticking game; recording, if given, captures every tick, and
+	// autopilot, if given, steers the paddle in place of the player
+	void      Start(Game &game, InputQueue &input, InputRecording *recording = nullptr, Autopilot *autopilot = nullptr);
+	// Has the thread expect its ticks (and the snapshots after them) not to allocate once warmup ticks ran, see
+	// AllocTracker; allocation frames are per thread, so the render loop's frames do not cover the ticks. Call before Start
+	void      ExpectNoAllocations(GLuint warmup);
+	// Stops and joins the thread; the game belongs to the caller again
+	void      Stop();
+	// While paused no ticks run (input is still applied) and the paused time is not caught up afterwards
+	void      SetPaused(GLboolean paused);
+	// Number of ticks run so far
+	GLuint64  Ticks() const;
+private:
+	std::thread           thread;
+	std::atomic<bool>     running, paused;
+	std::atomic<GLuint64> ticks;
+	Game                 *game;
+	InputQueue           *input;
+	InputRecording       *recording;
+	Autopilot            *autopilot;
+	GLboolean             checkAllocations;
+	GLuint                allocationWarmup;
+	// Thread body
+	void run();
+	SimulationThread(const SimulationThread &);
+	SimulationThread &operator=(const SimulationThread &);
+};
+
+#endif
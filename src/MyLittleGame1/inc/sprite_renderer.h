@@ -21,16 +21,17 @@
 class SpriteRenderer
 {
 public:
-	// Constructor (inits shaders/shapes)
+	// Constructor (inits shaders/shapes); the shader is referenced, not copied, and has to outlive the renderer
 	SpriteRenderer(Shader &shader);
-	// Destructor
-	~SpriteRenderer();
 	// Renders a defined quad textured with given sprite
-	void DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10, 10), GLfloat rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+	void DrawSprite(TextureView texture, glm::vec2 position, glm::vec2 size = glm::vec2(10, 10), GLfloat rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+	// Sets the projection sprites are drawn with (the camera's view)
+	void SetProjection(const glm::mat4 &projection);
 private:
 	// Render state
-	Shader shader;
-	GLuint quadVAO;
+	Shader       *shader;
+	GLVertexArray quadVAO;
+	GLBuffer      quadVBO;
 	// Initializes and configures the quad's buffer and vertex attributes
 	void initRenderData();
 };
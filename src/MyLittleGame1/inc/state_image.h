@@ -0,0 +1,97 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STATE_IMAGE_H
+#define STATE_IMAGE_H
+#include <cstring>
+#include <vector>
+
+#include <GL/glew.h>
+
+
+// A state image is the raw bytes of some in-memory state, written field
+// by field and read back in the same order. Images are only meant to be
+// restored by the process that took them (they hold texture ids and
+// native floats), so values are copied as they are without any encoding.
+// Keeping the layout the same from one tick to the next lets images be
+// compared byte by byte, see RewindBuffer.
+typedef std::vector<GLubyte> StateImage;
+
+
+// Appends values to a state image
+class StateWriter
+{
+public:
+	// Constructor; the image is appended to, not cleared
+	StateWriter(StateImage &image) : image(image) { }
+	// Raw bytes
+	void Write(const void *data, size_t size)
+	{
+		size_t offset = this->image.size();
+		this->image.resize(offset + size);
+		if (size > 0)
+			std::memcpy(&this->image[offset], data, size);
+	}
+	// A trivially copyable value
+	template <typename T> void Write(const T &value) { this->Write(&value, sizeof(T)); }
+	// The length of a vector of trivially copyable values followed by its elements
+	template <typename T> void Write(const std::vector<T> &values)
+	{
+		GLuint64 count = values.size();
+		this->Write(count);
+		if (count > 0)
+			this->Write(values.data(), values.size() * sizeof(T));
+	}
+private:
+	StateImage &image;
+};
+
+
+// Reads values back from a state image. Reading past the end fails
+// without touching the target, and every later read fails as well.
+class StateReader
+{
+public:
+	// Constructor
+	StateReader(const StateImage &image) : data(image.empty() ? nullptr : &image[0]), size(image.size()), offset(0), failed(GL_FALSE) { }
+	// Whether a read went past the end of the image
+	GLboolean Failed() const { return this->failed; }
+	// Raw bytes
+	GLboolean Read(void *data, size_t size)
+	{
+		if (this->failed || size > this->size - this->offset)
+		{
+			this->failed = GL_TRUE;
+			return GL_FALSE;
+		}
+		if (size > 0)
+			std::memcpy(data, this->data + this->offset, size);
+		this->offset += size;
+		return GL_TRUE;
+	}
+	// A trivially copyable value
+	template <typename T> GLboolean Read(T &value) { return this->Read(&value, sizeof(T)); }
+	// A vector written by StateWriter::Write (keeps the vector's capacity)
+	template <typename T> GLboolean Read(std::vector<T> &values)
+	{
+		GLuint64 count = 0;
+		if (!this->Read(count) || count > (this->size - this->offset) / sizeof(T))
+		{
+			this->failed = GL_TRUE;
+			return GL_FALSE;
+		}
+		values.resize(static_cast<size_t>(count));
+		return count == 0 || this->Read(values.data(), values.size() * sizeof(T));
+	}
+private:
+	const GLubyte *data;
+	size_t         size, offset;
+	GLboolean      failed;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STREAMING_LEVEL_H
+#define STREAMING_LEVEL_H
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "components.h"
+#include "game_level.h"
+#include "level_generator.h"
+#include "state_image.h"
+
+
+// StreamingLevel is the brick field of the endless mode: rows keep
+// scrolling in at the top of the playfield and out at the bottom. Only
+// the rows overlapping the playfield, plus a few made ready above it,
+// are kept, in a ring of Capacity rows. Rows are numbered in the order
+// they stream in and row r lives in slot r % Capacity, so the origin of
+// the ring moves along as rows are recycled and a new row simply takes
+// over the slot of the one that just left. Tiles hold the codes of .lvl
+// files (0 empty, 1 solid, 2-5 breakable); collisions and rendering
+// index them directly instead of going through brick entities, so the
+// memory and per-tick cost stay bounded however long a game lasts.
+class StreamingLevel
+{
+public:
+	// Rows kept ready above the top edge of the playfield
+	static const GLuint AHEAD_ROWS = 2;
+	// Layout
+	GLuint  Columns, Capacity;
+	GLfloat Width, Height;          // playfield; rows are recycled once they are entirely below it
+	GLfloat TileWidth, TileHeight;
+	GLfloat StartHeight;            // how far down Reset fills the playfield
+	GLfloat ScrollSpeed;            // pixels per second
+	// Constructor (streams nothing until Init)
+	StreamingLevel();
+	// Streams generated rows: every spec.Rows rows the spec's level is generated anew with the next seed,
+	// and its rows stream in bottom row first. Returns false if the spec is out of range
+	GLboolean Init(const LevelSpec &spec, GLuint width, GLuint height, GLfloat startHeight, GLfloat scrollSpeed);
+	// Streams the rows of a loaded level over and over, with the level's tile size
+	GLboolean Init(const GameLevel &level, GLuint width, GLuint height, GLfloat startHeight, GLfloat scrollSpeed);
+	// Starts over from the first row
+	void      Reset();
+	// Scrolls dt seconds further, recycling the rows that left the playfield and streaming in new ones; returns whether the rows moved
+	GLboolean Advance(GLfloat dt);
+	// Resident rows are [FirstRow, EndRow); FirstRow is the lowest on screen
+	GLuint64  FirstRow() const { return this->first; }
+	GLuint64  EndRow() const { return this->end; }
+	// Top edge of a row
+	GLfloat   RowTop(GLuint64 row) const { return this->firstTop - static_cast<GLfloat>(row - this->first) * this->TileHeight; }
+	// Tile code at column x of a resident row
+	GLuint   &Tile(GLuint64 row, GLuint x) { return this->tiles[(row % this->Capacity) * this->Columns + x]; }
+	GLuint    Tile(GLuint64 row, GLuint x) const { return this->tiles[(row % this->Capacity) * this->Columns + x]; }
+	// Box covered by a tile
+	Transform TileBounds(GLuint64 row, GLuint x) const
+	{
+		return Transform(glm::vec2(x * this->TileWidth, this->RowTop(row)), glm::vec2(this->TileWidth, this->TileHeight));
+	}
+	// Resident rows overlapping the vertical span from top to bottom, as [begin, end)
+	void      RowsIn(GLfloat top, GLfloat bottom, GLuint64 &begin, GLuint64 &end) const;
+	// Whether a breakable brick reaches below y
+	GLboolean Overrun(GLfloat y) const;
+	// Tiles of every slot of the ring, for checksums
+	const std::vector<GLuint> &Tiles() const { return this->tiles; }
+	// Writes the resident rows and the scroll position to a state image, and restores them (the rows' source stays as Init set it)
+	void      SaveState(StateWriter &writer) const;
+	GLboolean LoadState(StateReader &reader);
+private:
+	// Where rows come from: the rows of a loaded level if source is not empty, the generator otherwise
+	LevelSpec           spec;
+	std::vector<GLuint> source;
+	GLuint              sourceRows;
+	// The ring, and the resident rows in it
+	std::vector<GLuint> tiles;
+	GLuint64            first, end;
+	// Top edge of row first (whether it is resident or not)
+	GLfloat             firstTop;
+	// Sizes the ring for the playfield and the tile size; the only place the ring allocates
+	void layout(GLuint columns, GLuint width, GLuint height, GLfloat tileHeight, GLfloat startHeight, GLfloat scrollSpeed);
+	// Fills the slot of row end and makes it resident
+	void streamIn();
+	// Streams in rows until AHEAD_ROWS rows are ready above the playfield (or the ring is full)
+	void fill();
+};
+
+#endif
@@ -11,13 +11,17 @@
 
 #include <GL/glew.h>
 
+#include "gl_object.h"
+
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
+// It owns its texture object: it can be moved but not copied, and
+// everything drawing with it holds a TextureView instead.
 class Texture2D
 {
 public:
-	// Holds the ID of the texture object, used for all texture operations to reference to this particlar texture
-	GLuint ID;
+	// Holds the texture object, used for all texture operations to reference to this particlar texture (created by Generate)
+	GLTexture Object;
 	// Texture image dimensions
 	GLuint Width, Height; // Width and height of loaded image in pixels
 						  // Texture Format
@@ -36,4 +40,14 @@ public:
 	void Bind() const;
 };
 
+// Non-owning reference to a Texture2D, cheap to copy into components
+// and renderers. Valid for as long as the texture it was taken from.
+struct TextureView {
+	GLuint ID, Width, Height;
+
+	TextureView() : ID(0), Width(0), Height(0) { }
+	TextureView(const Texture2D &texture) : ID(texture.Object.ID()), Width(texture.Width), Height(texture.Height) { }
+	void Bind() const { glBindTexture(GL_TEXTURE_2D, this->ID); }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+#include <atomic>
+
+#include <GL/glew.h>
+
+
+// Lock-free triple buffer handing values from one writer thread to one
+// reader thread. The writer fills Back and publishes it, the reader
+// switches to the newest published value with Acquire and reads Front.
+// Each side owns one slot and the third is swapped between them
+// through a single atomic, so neither ever waits for the other: the
+// writer overwrites values the reader skipped and the reader keeps
+// showing its current value until a newer one is published.
+template <typename T>
+class TripleBuffer
+{
+public:
+	// Constructor
+	TripleBuffer() : back(0), front(2), middle(1) { }
+	// Writer: the slot to fill next
+	T        &Back() { return this->slots[this->back]; }
+	// Writer: publishes Back, taking over the slot the reader left for the next write
+	void      Publish()
+	{
+		GLuint previous = this->middle.exchange(this->back | FRESH, std::memory_order_acq_rel);
+		this->back = previous & INDEX;
+	}
+	// Reader: switches Front to the newest published value; returns false if nothing new was published
+	GLboolean Acquire()
+	{
+		if (!(this->middle.load(std::memory_order_relaxed) & FRESH))
+			return GL_FALSE;
+		GLuint previous = this->middle.exchange(this->front, std::memory_order_acq_rel);
+		this->front = previous & INDEX;
+		return GL_TRUE;
+	}
+	// Reader: the value acquired last
+	const T  &Front() const { return this->slots[this->front]; }
+private:
+	// The middle slot's index, with FRESH set while it holds a value the reader has not taken yet
+	static const GLuint INDEX = 3, FRESH = 4;
+	T                   slots[3];
+	GLuint              back, front;
+	std::atomic<GLuint> middle;
+	TripleBuffer(const TripleBuffer &);
+	TripleBuffer &operator=(const TripleBuffer &);
+};
+
+#endif
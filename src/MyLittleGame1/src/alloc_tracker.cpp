@@ -0,0 +1,269 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "alloc_tracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#if defined(LITTLEGAME_ALLOC_HOOKS) && (defined(__GLIBC__) || defined(__APPLE__))
+#include <execinfo.h>
+#include <unistd.h>
+#define LITTLEGAME_STACK_TRACES
+#endif
+
+#if defined(__GNUC__)
+#define LITTLEGAME_NOINLINE __attribute__((noinline))
+#else
+#define LITTLEGAME_NOINLINE
+#endif
+
+
+namespace
+{
+	// Frames kept per stack, frames belonging to the hooks themselves and the number of distinct call sites remembered
+	const GLuint STACK_DEPTH = 10, HOOK_FRAMES = 2, MAX_CALL_SITES = 64;
+	// Violations printed with a stack trace; later ones are only counted
+	const GLuint64 MAX_PRINTED_VIOLATIONS = 16;
+
+	struct CallSite {
+		void     *Stack[STACK_DEPTH];
+		GLuint    Depth;
+		GLuint64  Samples, Bytes;
+	};
+
+	// Counters are constant initialized, so the hooks work before main runs
+	std::atomic<GLuint64> Allocations(0), Bytes(0), Frees(0), ViolationCount(0);
+	std::atomic<GLuint>   SampleRate(0);
+	// Frame state belongs to the thread that delimits the frames, allocations of other threads do not touch it
+	thread_local bool     InFrame = false, Expecting = false, AbortOnViolation = false;
+	thread_local GLuint64 FrameAllocations = 0, FrameBytes = 0, FrameFrees = 0;
+	// Sampled call sites, behind a spin lock since a mutex may allocate itself
+	std::atomic_flag      SiteLock = ATOMIC_FLAG_INIT;
+	CallSite              Sites[MAX_CALL_SITES];
+	GLuint                SiteCount = 0;
+	// Set while a thread runs the tracker, so its own allocations pass through uncounted
+	thread_local bool     InHook = false;
+
+#ifdef LITTLEGAME_STACK_TRACES
+	// Captures the stack of the allocating code, skipping the hooks
+	LITTLEGAME_NOINLINE GLuint captureStack(void **stack)
+	{
+		void *frames[STACK_DEPTH + HOOK_FRAMES + 1];
+		GLint depth = backtrace(frames, STACK_DEPTH + HOOK_FRAMES + 1) - HOOK_FRAMES - 1;
+		depth = std::max(0, depth);
+		std::copy(frames + HOOK_FRAMES + 1, frames + HOOK_FRAMES + 1 + depth, stack);
+		return static_cast<GLuint>(depth);
+	}
+
+	// Writes symbolized frames straight to stdout (backtrace_symbols_fd does not allocate)
+	void printStack(void *const *stack, GLuint depth)
+	{
+		std::cout.flush();
+		backtrace_symbols_fd(stack, static_cast<int>(depth), STDOUT_FILENO);
+	}
+#else
+	GLuint captureStack(void **stack) { return 0; }
+	void printStack(void *const *stack, GLuint depth) { }
+#endif
+
+	// Adds a sampled stack to the call site table; sites beyond the table size are dropped
+	void sampleCallSite(void *const *stack, GLuint depth, std::size_t size)
+	{
+		while (SiteLock.test_and_set(std::memory_order_acquire))
+			;
+		GLuint site = 0;
+		while (site < SiteCount && !(Sites[site].Depth == depth && std::equal(stack, stack + depth, Sites[site].Stack)))
+			++site;
+		if (site == SiteCount && SiteCount < MAX_CALL_SITES)
+		{
+			std::copy(stack, stack + depth, Sites[site].Stack);
+			Sites[site].Depth = depth;
+			++SiteCount;
+		}
+		if (site < SiteCount)
+		{
+			++Sites[site].Samples;
+			Sites[site].Bytes += size;
+		}
+		SiteLock.clear(std::memory_order_release);
+	}
+
+	LITTLEGAME_NOINLINE void recordAllocation(std::size_t size)
+	{
+		if (InHook)
+			return;
+		InHook = true;
+		GLuint64 index = Allocations.fetch_add(1, std::memory_order_relaxed);
+		Bytes.fetch_add(size, std::memory_order_relaxed);
+		GLuint rate = SampleRate.load(std::memory_order_relaxed);
+		GLboolean sampled = rate > 0 && index % rate == 0;
+		if (InFrame)
+		{
+			++FrameAllocations;
+			FrameBytes += size;
+		}
+		GLboolean violation = InFrame && Expecting;
+		if (sampled || violation)
+		{
+			void *stack[STACK_DEPTH];
+			GLuint depth = captureStack(stack);
+			if (sampled)
+				sampleCallSite(stack, depth, size);
+			if (violation && ViolationCount.fetch_add(1, std::memory_order_relaxed) < MAX_PRINTED_VIOLATIONS)
+			{
+				std::cout << "ERROR::ALLOC: " << size << " bytes allocated in a frame that should not allocate" << std::endl;
+				printStack(stack, depth);
+			}
+			if (violation && AbortOnViolation)
+				std::abort();
+		}
+		InHook = false;
+	}
+
+	void recordFree()
+	{
+		if (InHook)
+			return;
+		Frees.fetch_add(1, std::memory_order_relaxed);
+		if (InFrame)
+			++FrameFrees;
+	}
+}
+
+
+GLboolean AllocTracker::Enabled()
+{
+#ifdef LITTLEGAME_ALLOC_HOOKS
+	return GL_TRUE;
+#else
+	return GL_FALSE;
+#endif
+}
+
+AllocationStats AllocTracker::Totals()
+{
+	AllocationStats totals;
+	totals.Allocations = Allocations.load(std::memory_order_relaxed);
+	totals.Bytes = Bytes.load(std::memory_order_relaxed);
+	totals.Frees = Frees.load(std::memory_order_relaxed);
+	return totals;
+}
+
+void AllocTracker::BeginFrame()
+{
+	FrameAllocations = FrameBytes = FrameFrees = 0;
+	InFrame = true;
+}
+
+AllocationStats AllocTracker::EndFrame()
+{
+	InFrame = false;
+	AllocationStats frame;
+	frame.Allocations = FrameAllocations;
+	frame.Bytes = FrameBytes;
+	frame.Frees = FrameFrees;
+	return frame;
+}
+
+void AllocTracker::ExpectNoAllocations(GLboolean expect, GLboolean abort)
+{
+	Expecting = expect != GL_FALSE;
+	AbortOnViolation = abort != GL_FALSE;
+}
+
+GLuint64 AllocTracker::Violations()
+{
+	return ViolationCount.load(std::memory_order_relaxed);
+}
+
+void AllocTracker::SetSampleRate(GLuint rate)
+{
+	SampleRate = rate;
+}
+
+void AllocTracker::ReportCallSites(GLuint count)
+{
+	// Copy the table so printing (which may allocate) runs without the lock
+	CallSite sites[MAX_CALL_SITES];
+	GLuint order[MAX_CALL_SITES];
+	while (SiteLock.test_and_set(std::memory_order_acquire))
+		;
+	GLuint siteCount = SiteCount;
+	std::copy(Sites, Sites + siteCount, sites);
+	SiteLock.clear(std::memory_order_release);
+	for (GLuint i = 0; i < siteCount; ++i)
+		order[i] = i;
+	std::sort(order, order + siteCount, [&](GLuint a, GLuint b) { return sites[a].Samples > sites[b].Samples; });
+	if (siteCount > 0)
+		std::cout << "sampled allocation call sites (1 in " << SampleRate.load() << " allocations):" << std::endl;
+	for (GLuint i = 0; i < std::min(count, siteCount); ++i)
+	{
+		const CallSite &site = sites[order[i]];
+		std::cout << "#" << i + 1 << ": " << site.Samples << " samples, " << site.Bytes << " bytes" << std::endl;
+		printStack(site.Stack, site.Depth);
+	}
+}
+
+
+#ifdef LITTLEGAME_ALLOC_HOOKS
+// Replacements of the global allocation functions; the array and nothrow
+// forms are routed through the same counters
+void *operator new(std::size_t size)
+{
+	void *memory = std::malloc(size > 0 ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	recordAllocation(size);
+	return memory;
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	void *memory = std::malloc(size > 0 ? size : 1);
+	if (memory)
+		recordAllocation(size);
+	return memory;
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void *memory) noexcept
+{
+	if (!memory)
+		return;
+	recordFree();
+	std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+	operator delete(memory);
+}
+#endif
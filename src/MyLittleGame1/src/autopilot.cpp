@@ -0,0 +1,209 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "autopilot.h"
+
+#include <cmath>
+#include <limits>
+
+#include "game.h"
+
+
+namespace
+{
+	// Farthest from the paddle's center (in half widths) a ball is caught at, so it cannot slip past the edge
+	const GLfloat MAX_OFFSET = 0.8f;
+	// Horizontal speed BounceOffPaddle gives a ball per half width off the paddle's center
+	const GLfloat DEFLECTION = 2.0f * INITIAL_BALL_VELOCITY.x;
+
+	// Folds a position on an unbounded line back between 0 and limit, as bouncing between walls there would
+	GLfloat fold(GLfloat x, GLfloat limit)
+	{
+		if (limit <= 0.0f)
+			return 0.0f;
+		GLfloat period = 2.0f * limit;
+		GLfloat offset = std::fmod(x, period);
+		if (offset < 0.0f)
+			offset += period;
+		return offset > limit ? period - offset : offset;
+	}
+}
+
+
+Autopilot::Autopilot()
+	: Landing(0.0f), Target(0.0f), HasTarget(GL_FALSE), targetBottom(0.0f), lastLevelRevision(~0u), lastBrickRevision(~0u), targetRow(0)
+{
+
+}
+
+GLboolean Autopilot::PredictLanding(const Transform &ball, glm::vec2 velocity, GLfloat y, GLuint width, GLfloat &x, GLfloat &time, GLfloat ceiling)
+{
+	if (velocity.y > 0.0f)
+	{
+		GLfloat distance = y - (ball.Position.y + ball.Size.y);
+		if (distance < 0.0f)
+			return GL_FALSE;
+		time = distance / velocity.y;
+	}
+	else if (velocity.y < 0.0f)
+	{
+		// Up to the ceiling and all the way down again; a ball already above it goes on to the top of the playfield
+		if (ball.Position.y < ceiling)
+			ceiling = 0.0f;
+		time = (ball.Position.y - ceiling + y - ball.Size.y - ceiling) / -velocity.y;
+	}
+	else
+		return GL_FALSE;
+	x = fold(ball.Position.x + velocity.x * time, width - ball.Size.x);
+	return GL_TRUE;
+}
+
+void Autopilot::Apply(Game &game)
+{
+	if (game.State != GAME_ACTIVE)
+	{
+		setKey(game, GLFW_KEY_A, GL_FALSE);
+		setKey(game, GLFW_KEY_D, GL_FALSE);
+		setKey(game, GLFW_KEY_SPACE, GL_FALSE);
+		return;
+	}
+	const Transform &paddle = game.Entities.Get<Transform>(game.Player);
+	GLfloat half = paddle.Size.x / 2, center = paddle.Position.x + half;
+	this->pickTarget(game, center);
+	// A ball going up most likely comes back down off the lowest row of bricks rather than the top of the playfield
+	GLfloat ceiling = this->HasTarget ? this->targetBottom : 0.0f;
+	// The ball to catch is the first to reach the paddle of those it can still get to in time,
+	// falling balls going before those still on their way up
+	GLboolean stuck = GL_FALSE, found = GL_FALSE;
+	GLuint rank = 0;
+	GLfloat landing = 0.0f, time = 0.0f, radius = 0.0f;
+	glm::vec2 velocity(0.0f);
+	game.Entities.Each(BALL_ARCHETYPE, [&](const Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+		{
+			if (balls.Balls[i].Stuck)
+			{
+				stuck = GL_TRUE;
+				continue;
+			}
+			GLfloat x, t;
+			const glm::vec2 &v = balls.Velocities[i].Value;
+			if (!PredictLanding(balls.Transforms[i], v, paddle.Position.y, game.Width, x, t, ceiling))
+				continue;
+			GLfloat distance = std::abs(x + balls.Colliders[i].Radius - center) - MAX_OFFSET * half;
+			GLuint order = (distance <= PLAYER_VELOCITY * t ? 2 : 0) + (v.y > 0.0f ? 1 : 0);
+			if (found && (order < rank || (order == rank && t >= time)))
+				continue;
+			found = GL_TRUE;
+			rank = order;
+			landing = x;
+			time = t;
+			radius = balls.Colliders[i].Radius;
+			velocity = v;
+		}
+	});
+	GLfloat goal = center;
+	if (found)
+	{
+		// BounceOffPaddle measures where the ball hit from the center of its bounds
+		GLfloat hit = landing + radius;
+		goal = hit;
+		this->Landing = landing;
+		GLfloat rise = paddle.Position.y - radius - this->Target.y;
+		if (this->HasTarget && rise > 0.0f)
+		{
+			// The ball leaves the paddle at DEFLECTION * offset across per |velocity.y| up; aim straight at the
+			// target or at its mirror image behind either wall, whichever takes the smallest offset
+			GLfloat images[3] = { this->Target.x, 2.0f * radius - this->Target.x, 2.0f * (game.Width - radius) - this->Target.x };
+			GLfloat offset = std::numeric_limits<GLfloat>::max();
+			for (GLfloat image : images)
+			{
+				GLfloat needed = (image - hit) / rise * std::abs(velocity.y) / DEFLECTION;
+				if (std::abs(needed) < std::abs(offset))
+					offset = needed;
+			}
+			offset = glm::clamp(offset, -MAX_OFFSET, MAX_OFFSET);
+			// Aim only if the paddle gets there in time, catching the ball comes first
+			GLfloat aimed = hit - offset * half;
+			if (std::abs(aimed - center) <= PLAYER_VELOCITY * time)
+				goal = aimed;
+		}
+	}
+	// Within half a step of the goal the paddle stays put rather than overshooting back and forth
+	GLfloat step = PLAYER_VELOCITY * TICK_DURATION;
+	setKey(game, GLFW_KEY_A, goal < center - step / 2);
+	setKey(game, GLFW_KEY_D, goal > center + step / 2);
+	setKey(game, GLFW_KEY_SPACE, stuck);
+}
+
+void Autopilot::pickTarget(const Game &game, GLfloat x)
+{
+	if (!game.Endless && this->lastLevelRevision == game.LevelRevision && this->lastBrickRevision == game.BrickRevision)
+		return;
+	GLfloat nearest = std::numeric_limits<GLfloat>::max();
+	this->HasTarget = GL_FALSE;
+	if (game.Endless)
+	{
+		// The lowest resident row comes first
+		const StreamingLevel &stream = game.Stream;
+		for (GLuint64 row = stream.FirstRow(); row < stream.EndRow() && !this->HasTarget; ++row)
+		{
+			for (GLuint column = 0; column < stream.Columns; ++column)
+			{
+				if (stream.Tile(row, column) <= 1)
+					continue;
+				Transform bounds = stream.TileBounds(row, column);
+				glm::vec2 middle = bounds.Position + bounds.Size / 2.0f;
+				if (std::abs(middle.x - x) < nearest)
+				{
+					nearest = std::abs(middle.x - x);
+					this->Target = middle;
+					this->targetBottom = bounds.Position.y + bounds.Size.y;
+					this->HasTarget = GL_TRUE;
+				}
+			}
+		}
+		return;
+	}
+	if (game.Level >= game.Levels.size())
+		return;
+	const GameLevel &level = game.Levels[game.Level];
+	if (this->lastLevelRevision != game.LevelRevision)
+		this->targetRow = level.Rows;
+	this->lastLevelRevision = game.LevelRevision;
+	this->lastBrickRevision = game.BrickRevision;
+	// From the row of the last target upwards
+	for (GLuint row = std::min(this->targetRow + 1, level.Rows); row-- > 0 && !this->HasTarget;)
+	{
+		for (GLuint column = 0; column < level.Columns; ++column)
+		{
+			GLuint index = row * level.Columns + column;
+			if (index >= game.BrickGrid.size() || !game.BrickGrid[index].IsValid())
+				continue;
+			const Brick &brick = game.Entities.Get<Brick>(game.BrickGrid[index]);
+			if (brick.IsSolid || brick.Destroyed)
+				continue;
+			const Transform &bounds = game.Entities.Get<Transform>(game.BrickGrid[index]);
+			glm::vec2 middle = bounds.Position + bounds.Size / 2.0f;
+			if (std::abs(middle.x - x) < nearest)
+			{
+				nearest = std::abs(middle.x - x);
+				this->Target = middle;
+				this->targetBottom = bounds.Position.y + bounds.Size.y;
+				this->HasTarget = GL_TRUE;
+				this->targetRow = row;
+			}
+		}
+	}
+}
+
+void Autopilot::setKey(Game &game, GLuint key, GLboolean down)
+{
+	if (game.Keys[key] != down)
+		game.ApplyKey(key, down ? GLFW_PRESS : GLFW_RELEASE);
+}
@@ -0,0 +1,97 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "broadphase.h"
+
+#include <algorithm>
+
+
+void Broadphase::Update(Registry &registry, ComponentMask mask)
+{
+	++this->stamp;
+	GLuint added = 0;
+	registry.Each(mask | COMPONENT_TRANSFORM | COMPONENT_COLLIDER, [&](Archetype &archetype) {
+		for (GLuint i = 0; i < archetype.Size(); ++i)
+		{
+			const Entity &entity = archetype.Entities[i];
+			const Transform &transform = archetype.Transforms[i];
+			if (entity.Index >= this->slots.size())
+				this->slots.resize(entity.Index + 1, 0xFFFFFFFF);
+			// Update the entity's proxy in place, or append one for entities seen for the first time
+			GLuint slot = this->slots[entity.Index];
+			if (slot >= this->Proxies.size() || this->Proxies[slot].Owner != entity)
+			{
+				slot = static_cast<GLuint>(this->Proxies.size());
+				this->slots[entity.Index] = slot;
+				this->Proxies.push_back(Proxy());
+				this->Proxies[slot].Owner = entity;
+				++added;
+			}
+			Proxy &proxy = this->Proxies[slot];
+			proxy.MinX = transform.Position.x;
+			proxy.MaxX = transform.Position.x + transform.Size.x;
+			proxy.MinY = transform.Position.y;
+			proxy.MaxY = transform.Position.y + transform.Size.y;
+			proxy.Mask = archetype.Mask;
+			proxy.Stamp = this->stamp;
+		}
+	});
+	// Drop proxies of entities that were destroyed or lost their collider, keeping the order
+	GLuint kept = 0;
+	for (GLuint i = 0; i < this->Proxies.size(); ++i)
+		if (this->Proxies[i].Stamp == this->stamp)
+			this->Proxies[kept++] = this->Proxies[i];
+	this->Proxies.resize(kept);
+	// Known proxies are nearly sorted already; new ones (a freshly spawned level
+	// for instance) are appended at the back, sorted on their own and merged in.
+	// The merge goes through a kept buffer since std::inplace_merge allocates
+	std::vector<Proxy>::iterator fresh = this->Proxies.end() - added;
+	this->sort(kept - added);
+	if (added > 0)
+	{
+		std::sort(fresh, this->Proxies.end(), lessMinX);
+		this->merged.reserve(this->Proxies.capacity());
+		this->merged.resize(this->Proxies.size());
+		std::merge(this->Proxies.begin(), fresh, fresh, this->Proxies.end(), this->merged.begin(), lessMinX);
+		this->Proxies.swap(this->merged);
+	}
+	for (GLuint i = 0; i < this->Proxies.size(); ++i)
+		this->slots[this->Proxies[i].Owner.Index] = i;
+	// The sweep never remembers more proxies than there are, so size its list up front
+	this->active.reserve(this->Proxies.size());
+}
+
+void Broadphase::Clear()
+{
+	this->Proxies.clear();
+	this->slots.clear();
+}
+
+GLboolean Broadphase::lessMinX(const Proxy &a, const Proxy &b)
+{
+	return a.MinX < b.MinX;
+}
+
+void Broadphase::sort(GLuint count)
+{
+	this->Shifts = 0;
+	for (GLuint i = 1; i < count; ++i)
+	{
+		if (this->Proxies[i - 1].MinX <= this->Proxies[i].MinX)
+			continue;
+		Proxy proxy = this->Proxies[i];
+		GLuint j = i;
+		while (j > 0 && this->Proxies[j - 1].MinX > proxy.MinX)
+		{
+			this->Proxies[j] = this->Proxies[j - 1];
+			--j;
+		}
+		this->Proxies[j] = proxy;
+		this->Shifts += i - j;
+	}
+}
@@ -0,0 +1,57 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "camera.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+
+Camera::Camera(glm::vec2 viewSize)
+	: Position(0.0f), ViewSize(viewSize), WorldSize(viewSize), Stiffness(5.0f)
+{
+
+}
+
+GLboolean Camera::Scrolls() const
+{
+	return this->WorldSize.x > this->ViewSize.x || this->WorldSize.y > this->ViewSize.y;
+}
+
+void Camera::CenterOn(glm::vec2 target)
+{
+	this->Position = target - this->ViewSize * 0.5f;
+	this->clamp();
+}
+
+void Camera::Follow(glm::vec2 target, GLfloat dt)
+{
+	// Exponential smoothing, the same share of the distance per second at any tick rate
+	GLfloat t = 1.0f - std::exp(-this->Stiffness * dt);
+	this->Position += (target - this->ViewSize * 0.5f - this->Position) * t;
+	this->clamp();
+}
+
+GLboolean Camera::Sees(glm::vec2 position, glm::vec2 size) const
+{
+	return position.x < this->Position.x + this->ViewSize.x && position.x + size.x > this->Position.x
+		&& position.y < this->Position.y + this->ViewSize.y && position.y + size.y > this->Position.y;
+}
+
+glm::mat4 Camera::Projection(glm::vec2 position, glm::vec2 size)
+{
+	return glm::ortho(position.x, position.x + size.x, position.y + size.y, position.y, -1.0f, 1.0f);
+}
+
+void Camera::clamp()
+{
+	glm::vec2 limit = glm::max(this->WorldSize - this->ViewSize, glm::vec2(0.0f));
+	this->Position = glm::clamp(this->Position, glm::vec2(0.0f), limit);
+}
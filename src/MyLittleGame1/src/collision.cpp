@@ -0,0 +1,100 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "collision.h"
+
+// 򵥵ײ⣬˫Ծ߿Ϊײ
+GLboolean CheckCollision(const Transform &one, const Transform &two) // AABB - AABB collision
+{
+	// Collision x-axis?
+	// жϷxǷغ
+	// ൱ϷϽǶ
+	// һһĺķΧ
+	bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
+		two.Position.x + two.Size.x >= one.Position.x;
+	// Collision y-axis?
+	// жϷyǷغ
+	// ൱ϷϽǶ
+	// һһķΧ
+	bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
+		two.Position.y + two.Size.y >= one.Position.y;
+	// Collision only if on both axes
+	return collisionX && collisionY;
+}
+
+// ߿ - Բ߿ײ
+Collision CheckCollision(const Transform &one, GLfloat radius, const Transform &two) // AABB - Circle collision
+{
+	// Բײ߿Բ
+	// Get center point circle first 
+	glm::vec2 center(one.Position + radius);
+	// ײ߿ƫ
+	//ȥԲĵĵУھڲĲ֣
+	// Calculate AABB info (center, half-extents)
+	glm::vec2 aabb_half_extents(two.Size.x / 2, two.Size.y / 2);
+	glm::vec2 aabb_center(two.Position.x + aabb_half_extents.x, two.Position.y + aabb_half_extents.y);
+	// Get difference vector between both centers
+	// ӾĵԲĵڵķ clamped
+	glm::vec2 difference = center - aabb_center;
+	glm::vec2 clamped = glm::clamp(difference, -aabb_half_extents, aabb_half_extents);
+	// Now that we know the the clamped values, add this to AABB_center and we get the value of box closest to circle
+	//ȡαϵԲĵ㣬ҲǴӾƫһڷ clamped
+	glm::vec2 closest = aabb_center + clamped;
+	// Now retrieve vector between center circle and closest point AABB and check if length < radius
+	// ԲĵαԼײ߾һߣңԼ볤ȣСڰ뾶ײˣ
+	difference = closest - center;
+
+	// غ˲ײո㣬 <  <=
+	if (glm::length(difference) < radius)
+	{
+		// ֵ (Ƿײײ--ԲΪ㿴
+		//               Բײ--ײָľͷλûغ)
+		return std::make_tuple(GL_TRUE, VectorDirection(difference), difference);
+	}
+	else
+		return std::make_tuple(GL_FALSE, UP, glm::vec2(0, 0));
+}
+
+// Calculates which direction a vector is facing (N,E,S or W)
+// ÿһcompassһײķtargetһԲĵε
+// ķһߵķcosֵ˵нԽСҳнСķ򣬾ײķ
+//  target ֱĵֱӣΪܽнǵֵ޶һСļ
+// ھΣ 0 90 180 
+Direction VectorDirection(const glm::vec2 target)
+{
+	glm::vec2 compass[] = {
+		glm::vec2(0.0f, 1.0f),	// up
+		glm::vec2(1.0f, 0.0f),	// right
+		glm::vec2(0.0f, -1.0f),	// down
+		glm::vec2(-1.0f, 0.0f)	// left
+	};
+	GLfloat max = 0.0f;
+	GLuint best_match = -1;
+	for (GLuint i = 0; i < 4; i++)
+	{
+		GLfloat dot_product = glm::dot(glm::normalize(target), compass[i]);
+		if (dot_product > max)
+		{
+			max = dot_product;
+			best_match = i;
+		}
+	}
+	return (Direction)best_match;
+}
+
+Collision CheckCollision(const Transform &one, GLfloat radiusOne, const Transform &two, GLfloat radiusTwo) // Circle - Circle collision
+{
+	glm::vec2 difference = (two.Position + radiusTwo) - (one.Position + radiusOne);
+	GLfloat distance = radiusOne + radiusTwo;
+	// Compare squared lengths, the square root is only needed once a pair actually overlaps
+	GLfloat lengthSquared = glm::dot(difference, difference);
+	if (lengthSquared < distance * distance)
+		return std::make_tuple(GL_TRUE, lengthSquared > 0.0f ? VectorDirection(difference) : UP, difference);
+	else
+		return std::make_tuple(GL_FALSE, UP, glm::vec2(0, 0));
+}
@@ -0,0 +1,186 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "entity_registry.h"
+
+
+GLuint Archetype::push(Entity entity)
+{
+	GLuint row = this->Size();
+	this->Entities.push_back(entity);
+	if (this->Mask & COMPONENT_TRANSFORM)
+		this->Transforms.push_back(Transform());
+	if (this->Mask & COMPONENT_VELOCITY)
+		this->Velocities.push_back(Velocity());
+	if (this->Mask & COMPONENT_SPRITE)
+		this->Sprites.push_back(Sprite());
+	if (this->Mask & COMPONENT_COLLIDER)
+		this->Colliders.push_back(Collider());
+	if (this->Mask & COMPONENT_BRICK)
+		this->Bricks.push_back(Brick());
+	if (this->Mask & COMPONENT_BALL)
+		this->Balls.push_back(Ball());
+	return row;
+}
+
+// Swaps the last element of a column into row and drops the last element
+template <typename T>
+static void removeSwap(std::vector<T> &column, GLuint row)
+{
+	if (column.empty())
+		return;
+	if (row + 1 != column.size())
+		column[row] = column.back();
+	column.pop_back();
+}
+
+void Archetype::remove(GLuint row)
+{
+	removeSwap(this->Entities, row);
+	removeSwap(this->Transforms, row);
+	removeSwap(this->Velocities, row);
+	removeSwap(this->Sprites, row);
+	removeSwap(this->Colliders, row);
+	removeSwap(this->Bricks, row);
+	removeSwap(this->Balls, row);
+}
+
+void Archetype::copyRow(GLuint row, const Archetype &from, GLuint fromRow)
+{
+	ComponentMask shared = this->Mask & from.Mask;
+	if (shared & COMPONENT_TRANSFORM)
+		this->Transforms[row] = from.Transforms[fromRow];
+	if (shared & COMPONENT_VELOCITY)
+		this->Velocities[row] = from.Velocities[fromRow];
+	if (shared & COMPONENT_SPRITE)
+		this->Sprites[row] = from.Sprites[fromRow];
+	if (shared & COMPONENT_COLLIDER)
+		this->Colliders[row] = from.Colliders[fromRow];
+	if (shared & COMPONENT_BRICK)
+		this->Bricks[row] = from.Bricks[fromRow];
+	if (shared & COMPONENT_BALL)
+		this->Balls[row] = from.Balls[fromRow];
+}
+
+
+Entity Registry::Create(ComponentMask mask)
+{
+	GLuint index;
+	if (!this->freeIndices.empty())
+	{
+		index = this->freeIndices.back();
+		this->freeIndices.pop_back();
+	}
+	else
+	{
+		index = static_cast<GLuint>(this->records.size());
+		Record record;
+		record.Generation = 0;
+		this->records.push_back(record);
+	}
+	Record &record = this->records[index];
+	Entity entity(index, record.Generation);
+	record.ArchetypeIndex = this->archetypeFor(mask);
+	record.Row = this->archetypes[record.ArchetypeIndex].push(entity);
+	record.Alive = GL_TRUE;
+	return entity;
+}
+
+void Registry::Destroy(Entity entity)
+{
+	if (!this->IsAlive(entity))
+		return;
+	const Record &record = this->records[entity.Index];
+	this->removeRow(record.ArchetypeIndex, record.Row);
+	this->release(entity.Index);
+}
+
+void Registry::DestroyAll(ComponentMask mask)
+{
+	for (Archetype &archetype : this->archetypes)
+	{
+		if (!archetype.Has(mask))
+			continue;
+		for (const Entity &entity : archetype.Entities)
+			this->release(entity.Index);
+		// clear() keeps the capacity, so respawning a level does not reallocate
+		archetype.Entities.clear();
+		archetype.Transforms.clear();
+		archetype.Velocities.clear();
+		archetype.Sprites.clear();
+		archetype.Colliders.clear();
+		archetype.Bricks.clear();
+		archetype.Balls.clear();
+	}
+}
+
+void Registry::Clear()
+{
+	this->DestroyAll(0);
+}
+
+GLboolean Registry::IsAlive(Entity entity) const
+{
+	return entity.Index < this->records.size() && this->records[entity.Index].Alive
+		&& this->records[entity.Index].Generation == entity.Generation;
+}
+
+ComponentMask Registry::MaskOf(Entity entity) const
+{
+	assert(this->IsAlive(entity));
+	return this->archetypes[this->records[entity.Index].ArchetypeIndex].Mask;
+}
+
+void Registry::SetMask(Entity entity, ComponentMask mask)
+{
+	if (!this->IsAlive(entity) || this->MaskOf(entity) == mask)
+		return;
+	// Look up the target first: adding an archetype may move the others in memory
+	GLuint target = this->archetypeFor(mask);
+	Record &record = this->records[entity.Index];
+	GLuint row = this->archetypes[target].push(entity);
+	this->archetypes[target].copyRow(row, this->archetypes[record.ArchetypeIndex], record.Row);
+	this->removeRow(record.ArchetypeIndex, record.Row);
+	record.ArchetypeIndex = target;
+	record.Row = row;
+}
+
+GLuint Registry::Count(ComponentMask mask) const
+{
+	GLuint count = 0;
+	for (const Archetype &archetype : this->archetypes)
+		if (archetype.Has(mask))
+			count += archetype.Size();
+	return count;
+}
+
+GLuint Registry::archetypeFor(ComponentMask mask)
+{
+	for (GLuint i = 0; i < this->archetypes.size(); ++i)
+		if (this->archetypes[i].Mask == mask)
+			return i;
+	this->archetypes.push_back(Archetype(mask));
+	return static_cast<GLuint>(this->archetypes.size() - 1);
+}
+
+void Registry::removeRow(GLuint archetype, GLuint row)
+{
+	Archetype &storage = this->archetypes[archetype];
+	Entity moved = storage.Entities.back();
+	storage.remove(row);
+	if (row < storage.Size())
+		this->records[moved.Index].Row = row;
+}
+
+void Registry::release(GLuint index)
+{
+	Record &record = this->records[index];
+	record.Alive = GL_FALSE;
+	++record.Generation;
+	this->freeIndices.push_back(index);
+}
@@ -0,0 +1,110 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+
+namespace
+{
+	// Byte written over released memory in debug builds
+	const unsigned char POISON = 0xDD;
+
+	// Offset at or after offset whose address within memory is a multiple of alignment
+	size_t alignUp(const unsigned char *memory, size_t offset, size_t alignment)
+	{
+		uintptr_t address = reinterpret_cast<uintptr_t>(memory) + offset;
+		return offset + ((alignment - address % alignment) % alignment);
+	}
+}
+
+
+LinearArena::LinearArena(size_t capacity)
+	: offset(0), used(0), peak(0)
+{
+	this->addBlock(capacity);
+}
+
+LinearArena::~LinearArena()
+{
+	for (Block &block : this->blocks)
+		std::free(block.Memory);
+}
+
+void *LinearArena::Allocate(size_t size, size_t alignment)
+{
+	Block *block = &this->blocks.back();
+	size_t start = alignUp(block->Memory, this->offset, alignment);
+	if (start + size > block->Size)
+	{
+		// Overflow: the new block is at least as big as everything so far, so overflows stay rare
+		this->addBlock(std::max(size + alignment, this->Capacity()));
+		block = &this->blocks.back();
+		start = alignUp(block->Memory, 0, alignment);
+	}
+	this->offset = start + size;
+	this->used += size;
+	this->peak = std::max(this->peak, this->used);
+	return block->Memory + start;
+}
+
+void LinearArena::Reset()
+{
+#if LITTLEGAME_ARENA_POISON
+	for (size_t i = 0; i < this->blocks.size(); ++i)
+		std::memset(this->blocks[i].Memory, POISON, i + 1 < this->blocks.size() ? this->blocks[i].Size : this->offset);
+#endif
+	if (this->blocks.size() > 1)
+	{
+		// Replace the chain by a single block that fits the peak
+		size_t capacity = std::max(this->Capacity(), this->peak);
+		for (Block &block : this->blocks)
+			std::free(block.Memory);
+		this->blocks.clear();
+		this->addBlock(capacity);
+	}
+	this->offset = 0;
+	this->used = 0;
+}
+
+size_t LinearArena::Capacity() const
+{
+	size_t capacity = 0;
+	for (const Block &block : this->blocks)
+		capacity += block.Size;
+	return capacity;
+}
+
+void LinearArena::addBlock(size_t size)
+{
+	Block block;
+	block.Size = std::max<size_t>(size, 1);
+	block.Memory = static_cast<unsigned char *>(std::malloc(block.Size));
+	if (!block.Memory)
+		throw std::bad_alloc();
+	this->blocks.push_back(block);
+	this->offset = 0;
+}
+
+
+FrameArena::FrameArena(size_t capacity)
+	: even(capacity), odd(capacity), current(0)
+{
+
+}
+
+void FrameArena::BeginFrame()
+{
+	this->current ^= 1;
+	this->Current().Reset();
+}
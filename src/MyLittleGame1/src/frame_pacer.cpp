@@ -0,0 +1,76 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "frame_pacer.h"
+
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+
+FramePacer::FramePacer(PacingMode mode, GLfloat targetFps)
+	: Mode(mode), TargetFps(targetFps), SpinSeconds(0.001f), scheduled(GL_FALSE)
+{
+
+}
+
+void FramePacer::Apply()
+{
+	GLint interval = 0;
+	if (this->Mode == PACING_VSYNC)
+		interval = 1;
+	else if (this->Mode == PACING_ADAPTIVE_VSYNC)
+	{
+		// Negative intervals need swap tearing support; plain vsync otherwise
+		GLboolean tear = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+		interval = tear ? -1 : 1;
+	}
+	glfwSwapInterval(interval);
+	this->Restart();
+}
+
+void FramePacer::Wait()
+{
+	if (this->Mode != PACING_LIMIT || this->TargetFps <= 0.0f)
+		return;
+	Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<GLdouble>(1.0 / this->TargetFps));
+	Clock::time_point now = Clock::now();
+	// Start a new schedule the first time and whenever we fell more than a frame behind
+	if (!this->scheduled || now - this->deadline > period)
+	{
+		this->deadline = now;
+		this->scheduled = GL_TRUE;
+		return;
+	}
+	this->deadline += period;
+	Clock::time_point wake = this->deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<GLfloat>(this->SpinSeconds));
+	if (wake > now)
+		std::this_thread::sleep_until(wake);
+	while (Clock::now() < this->deadline)
+		std::this_thread::yield();
+}
+
+void FramePacer::Restart()
+{
+	this->scheduled = GL_FALSE;
+}
+
+GLboolean FramePacer::Parse(const std::string &name, PacingMode &mode)
+{
+	if (name == "off")
+		mode = PACING_OFF;
+	else if (name == "vsync")
+		mode = PACING_VSYNC;
+	else if (name == "adaptive")
+		mode = PACING_ADAPTIVE_VSYNC;
+	else if (name == "limit")
+		mode = PACING_LIMIT;
+	else
+		return GL_FALSE;
+	return GL_TRUE;
+}
@@ -9,130 +9,325 @@
 #include "game.h"
 #include "resource_manager.h"
 #include "sprite_renderer.h"
-#include "game_object.h"
-#include "ball_object.h"
 #include "particle_generator.h"
+#include "game_systems.h"
+#include "job_system.h"
+#include "render_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
-// Game-related State data
-SpriteRenderer    *Renderer;
-GameObject        *Player;
-BallObject        *Ball;
-ParticleGenerator *Particles;
-
-// Collision detection
-GLboolean CheckCollision(GameObject &one, GameObject &two);
-Collision CheckCollision(BallObject &one, GameObject &two);
-Direction VectorDirection(glm::vec2 closest);
-
 
 Game::Game(GLuint width, GLuint height)
-	: State(GAME_ACTIVE), Keys(), KeyPress(), KeyState(), Width(width), Height(height)
+	: State(GAME_ACTIVE), Keys(), KeyPress(), KeyState(), Width(width), Height(height), Seed(0), Ticks(0), View(glm::vec2(width, height)),
+	  Endless(GL_FALSE), Renderer(nullptr), Particles(nullptr), LevelRevision(0), BrickRevision(0), PlayerLead(0.0f, 0.0f), renderedView(0.0f)
 {
-
+	// The background covers the whole window
+	this->StaticLayer.Opaque = GL_TRUE;
 }
 
 Game::~Game()
 {
-	delete Renderer;
-	delete Player;
-	delete Ball;
-	delete Particles;
+	delete this->Renderer;
+	delete this->Particles;
 }
 
-void Game::Init()
+void Game::Init(GLboolean headless)
 {
-	// Load shaders
-	ResourceManager::LoadShader("sprite.vs", "sprite.frag", nullptr, "sprite");
-	ResourceManager::LoadShader("particle.vs", "particle.frag", nullptr, "particle");
-	// Configure shaders 
-	// ͳһͶӰΪ2DϷֻҪָڳߴ磬Լӳ䵽䣬ܱ֤
-	// Ⱦʱڴڳߴ궼ȷʾ ҡ¡ϱ߽磬
-	// Ұ0800֮x任-11֮䣬0600֮y任-11֮
-	glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(this->Width), static_cast<GLfloat>(this->Height), 0.0f, -1.0f, 1.0f);
-	ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
-	ResourceManager::GetShader("sprite").SetMatrix4("projection", projection);
-	ResourceManager::GetShader("particle").Use().SetInteger("sprite", 0);
-	ResourceManager::GetShader("particle").SetMatrix4("projection", projection);
-	// Load textures
-	ResourceManager::LoadTexture("textures/background.jpg", GL_FALSE, "background");
-	ResourceManager::LoadTexture("textures/awesomeface.png", GL_TRUE, "face");
-	ResourceManager::LoadTexture("textures/block.png", GL_FALSE, "block");
-	ResourceManager::LoadTexture("textures/block_solid.png", GL_FALSE, "block_solid");
-	ResourceManager::LoadTexture("textures/paddle.png", GL_TRUE, "paddle");
-	ResourceManager::LoadTexture("textures/particle.png", GL_TRUE, "particle");
-	// Set render-specific controls
-	Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
-	Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), ResourceManager::GetTexture("particle"), 500);
+	if (!headless)
+		this->LoadResources();
+	// Register the metrics recorded while playing
+	this->Stats.Ticks = Metrics::RegisterCounter("ticks");
+	this->Stats.Collisions = Metrics::RegisterHistogram("collisions_per_tick");
+	this->Stats.UpdateTime = Metrics::RegisterHistogram("update_time_us");
+	this->Stats.RenderTime = Metrics::RegisterHistogram("render_time_us");
+	this->Stats.DrawCalls = Metrics::RegisterHistogram("draw_calls");
+	this->Stats.LiveBricks = Metrics::RegisterGauge("live_bricks");
+	this->Stats.LiveParticles = Metrics::RegisterGauge("live_particles");
+	// Resolve the resources used while playing once
+	this->BackgroundTexture = ResourceManager::FindTexture("background");
+	this->PaddleTexture = ResourceManager::FindTexture("paddle");
+	this->BallTexture = ResourceManager::FindTexture("face");
+	this->BlockTexture = ResourceManager::FindTexture("block");
+	this->SolidBlockTexture = ResourceManager::FindTexture("block_solid");
+	ShaderHandle particleShader = ResourceManager::FindShader("particle");
+	TextureHandle particleTexture = ResourceManager::FindTexture("particle");
+	if (particleShader.IsValid() && particleTexture.IsValid())
+		this->Particles = new ParticleGenerator(ResourceManager::GetShader(particleShader), ResourceManager::GetTexture(particleTexture), 500, this->Seed);
+	else
+	{
+		// Headless games never draw, so the generator gets an empty shader and texture
+		static Shader noShader;
+		this->Particles = new ParticleGenerator(noShader, TextureView(), 500, this->Seed);
+	}
 	// Load levels
 	// ֤еשڴڵϰ벿֣ʹõ height * 0.5 
-	GameLevel one; one.Load("levels/one.lvl", this->Width, this->Height * 0.5);
-	GameLevel two; two.Load("levels/two.lvl", this->Width, this->Height * 0.5);
-	GameLevel three; three.Load("levels/three.lvl", this->Width, this->Height * 0.5);
-	GameLevel four; four.Load("levels/four.lvl", this->Width, this->Height * 0.5);
-	this->Levels.push_back(one);
-	this->Levels.push_back(two);
-	this->Levels.push_back(three);
-	this->Levels.push_back(four);
+	// Reading and building a level touches nothing but the level, so they are loaded in parallel on the job system
+	static const GLchar *levelFiles[] = { "levels/one.lvl", "levels/two.lvl", "levels/three.lvl", "levels/four.lvl" };
+	const GLuint levelCount = sizeof(levelFiles) / sizeof(levelFiles[0]);
+	size_t firstLevel = this->Levels.size();
+	this->Levels.resize(firstLevel + levelCount);
+	JobSystem::ParallelFor(levelCount, 1, [this, firstLevel](GLuint begin, GLuint end) {
+		for (GLuint i = begin; i < end; ++i)
+			this->Levels[firstLevel + i].Load(levelFiles[i], this->Width, this->Height * 0.5);
+	});
 	this->Level = 0;
+	this->Levels[this->Level].Spawn(this->Entities, &this->BrickGrid);
+	this->resetBrickBits();
 	// Configure geme objects
 	// ڵײм䣬ΪͶӰЧϽǵΪ
 	// ֵСֵ½Ϊֵֵӳ䵽 -11 
 	glm::vec2 playerPos = glm::vec2(this->Width / 2 - PLAYER_SIZE.x / 2,
 									this->Height - PLAYER_SIZE.y);
-	Player = new GameObject(playerPos, PLAYER_SIZE, ResourceManager::GetTexture("paddle"));
+	this->Player = this->Entities.Create(PADDLE_ARCHETYPE);
+	this->Entities.Get<Transform>(this->Player) = Transform(playerPos, PLAYER_SIZE);
+	this->Entities.Get<Sprite>(this->Player) = this->spriteOf(this->PaddleTexture);
 	glm::vec2 ballPos = playerPos + glm::vec2(PLAYER_SIZE.x / 2 - BALL_RADIUS, -BALL_RADIUS * 2);
-	Ball = new BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY,
-		ResourceManager::GetTexture("face"));
+	this->SpawnBall(ballPos, INITIAL_BALL_VELOCITY);
+}
+
+void Game::LoadResources(const std::string &shaderDirectory)
+{
+	// Load shaders
+	Shader &sprite = ResourceManager::GetShader(ResourceManager::LoadShader((shaderDirectory + "sprite.vs").c_str(), (shaderDirectory + "sprite.frag").c_str(), nullptr, "sprite"));
+	Shader &particle = ResourceManager::GetShader(ResourceManager::LoadShader((shaderDirectory + "particle.vs").c_str(), (shaderDirectory + "particle.frag").c_str(), nullptr, "particle"));
+	// Configure shaders 
+	// ͳһͶӰΪ2DϷֻҪָڳߴ磬Լӳ䵽䣬ܱ֤
+	// Ⱦʱڴڳߴ궼ȷʾ ҡ¡ϱ߽磬
+	// Ұ0800֮x任-11֮䣬0600֮y任-11֮
+	glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(this->Width), static_cast<GLfloat>(this->Height), 0.0f, -1.0f, 1.0f);
+	sprite.Use().SetInteger("image", 0);
+	sprite.SetMatrix4("projection", projection);
+	particle.Use().SetInteger("sprite", 0);
+	particle.SetMatrix4("projection", projection);
+	// Load textures
+	std::vector<TextureRequest> textures = {
+		{ "textures/background.jpg", GL_FALSE, "background" },
+		{ "textures/awesomeface.png", GL_TRUE, "face" },
+		{ "textures/block.png", GL_FALSE, "block" },
+		{ "textures/block_solid.png", GL_FALSE, "block_solid" },
+		{ "textures/paddle.png", GL_TRUE, "paddle" },
+		{ "textures/particle.png", GL_TRUE, "particle" }
+	};
+	ResourceManager::LoadTextures(textures);
+	// Set render-specific controls
+	this->Renderer = new SpriteRenderer(sprite);
+}
+
+Entity Game::SpawnBall(glm::vec2 position, glm::vec2 velocity)
+{
+	Entity ball = this->Entities.Create(BALL_ARCHETYPE);
+	this->Entities.Get<Transform>(ball) = Transform(position, glm::vec2(BALL_RADIUS * 2, BALL_RADIUS * 2));
+	this->Entities.Get<Velocity>(ball) = Velocity(velocity);
+	this->Entities.Get<Sprite>(ball) = this->spriteOf(this->BallTexture);
+	this->Entities.Get<Collider>(ball) = Collider(COLLIDER_CIRCLE, BALL_RADIUS);
+	return ball;
+}
+
+void Game::SpawnBalls(GLuint count)
+{
+	// Copied, spawning may reallocate component storage
+	Transform player = this->Entities.Get<Transform>(this->Player);
+	GLfloat speed = glm::length(INITIAL_BALL_VELOCITY);
+	for (GLuint i = 0; i < count; ++i)
+	{
+		// Spread positions over the paddle and directions over a 120 degree fan
+		GLfloat t = count > 1 ? static_cast<GLfloat>(i) / (count - 1) : 0.5f;
+		GLfloat angle = glm::radians(-60.0f + 120.0f * t);
+		glm::vec2 position(player.Position.x + t * (player.Size.x - BALL_RADIUS * 2), player.Position.y - BALL_RADIUS * 2);
+		Entity ball = this->SpawnBall(position, glm::vec2(std::sin(angle), -std::cos(angle)) * speed);
+		this->Entities.Get<Ball>(ball).Stuck = GL_FALSE;
+	}
 }
 
 void Game::Update(GLfloat dt)
 {
+	MetricTimer timer(this->Stats.UpdateTime);
+	Metrics::Add(this->Stats.Ticks);
+	this->Frame.BeginFrame();
+	// Endless rows scroll every tick, so the brick layer is redrawn whenever they moved
+	if (this->Endless && this->Stream.Advance(dt))
+		++this->BrickRevision;
+	++this->Ticks;
 	// Update objects
-	Ball->Move(dt, this->Width);
+	MoveSystem(this->Entities, dt, this->Width);
 
 	//Check for collisions
-	this->DoCollisions();
+	Metrics::Record(this->Stats.Collisions, this->DoCollisions());
 
 	// Update particles
-	Particles->Update(dt, *Ball, 2, glm::vec2(Ball->Radius / 2));
+	ParticleEmitSystem(this->Entities, *this->Particles, 2);
+	this->Particles->Update(dt);
 
 	//Check for lossing game condition -- falling out of window range
-	if (Ball->Position.y >= this->Height) {
+	// Balls leaving the window are removed, the round is lost once none are left
+	ArenaVector<Entity> fallen((ArenaAllocator<Entity>(this->Frame.Current())));
+	this->Entities.Each(BALL_ARCHETYPE, [&](Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+			if (balls.Transforms[i].Position.y >= this->Height)
+				fallen.push_back(balls.Entities[i]);
+	});
+	for (const Entity &ball : fallen)
+		this->Entities.Destroy(ball);
+	// In the endless mode the round is also lost once breakable bricks reach the paddle
+	GLboolean overrun = this->Endless && this->Stream.Overrun(this->Entities.Get<Transform>(this->Player).Position.y);
+	if (this->Entities.Count(COMPONENT_BALL) == 0 || overrun) {
 		this->ResetLevel();
 		this->ResetPlayer();
 	}
+	// In a playfield larger than the window the camera follows the ball closest to the paddle
+	if (this->View.Scrolls())
+	{
+		glm::vec2 target(0.0f);
+		GLfloat lowest = -1.0f;
+		this->Entities.Each(BALL_ARCHETYPE, [&](Archetype &balls) {
+			for (const Transform &ball : balls.Transforms)
+			{
+				glm::vec2 center = ball.Position + ball.Size * 0.5f;
+				if (center.y > lowest)
+				{
+					lowest = center.y;
+					target = center;
+				}
+			}
+		});
+		this->View.Follow(target, dt);
+	}
+	// Keep the tick for rewinding; once an image no longer fits the budget at all, rewinding is turned off
+	if (this->History.Budget() > 0)
+	{
+		this->stateImage.clear();
+		StateWriter writer(this->stateImage);
+		this->SaveState(writer);
+		if (!this->History.Record(this->Ticks, this->stateImage))
+		{
+			std::cout << "ERROR::GAME: A state image of " << this->stateImage.size() << " bytes does not fit the rewind budget, rewinding is off" << std::endl;
+			this->History.SetBudget(0);
+		}
+	}
+}
+
+
+void Game::ApplyKey(GLuint key, GLuint action)
+{
+	if (key == RELEASE_ALL_KEYS)
+	{
+		for (GLuint i = 0; i < 1024; ++i)
+		{
+			this->Keys[i] = GL_FALSE;
+			this->KeyState[i] = GLFW_RELEASE;
+		}
+		return;
+	}
+	if (key >= 1024)
+		return;
+	if (action == GLFW_PRESS)
+		this->Keys[key] = GL_TRUE;
+	else if (action == GLFW_RELEASE)
+		this->Keys[key] = GL_FALSE;
+	this->KeyState[key] = action;
+}
+
+GLuint Game::ConsumeInput(InputQueue &input, GLdouble time)
+{
+	// Keys this tick already changed
+	GLuint changed[InputQueue::CAPACITY];
+	GLuint count = 0;
+	KeyEvent event;
+	while (count < InputQueue::CAPACITY && input.Peek(event) && event.Time <= time)
+	{
+		if (std::find(changed, changed + count, event.Key) != changed + count)
+			break;
+		this->ApplyKey(event.Key, event.Action);
+		changed[count++] = event.Key;
+		input.Pop();
+	}
+	return count;
+}
+
+void Game::SamplePlayer(const InputQueue &input, GLfloat ahead)
+{
+	this->PlayerLead = glm::vec2(0.0f);
+	if (this->State != GAME_ACTIVE)
+		return;
+	// Newest state of the movement keys, including events no tick has consumed yet
+	GLboolean left = this->Keys[GLFW_KEY_A], right = this->Keys[GLFW_KEY_D];
+	GLuint pending = input.Size();
+	for (GLuint i = 0; i < pending; ++i)
+	{
+		const KeyEvent &event = input.Pending(i);
+		if (event.Key == RELEASE_ALL_KEYS)
+			left = right = GL_FALSE;
+		else if (event.Action == GLFW_REPEAT)
+			continue;
+		else if (event.Key == GLFW_KEY_A)
+			left = event.Action == GLFW_PRESS;
+		else if (event.Key == GLFW_KEY_D)
+			right = event.Action == GLFW_PRESS;
+	}
+	const Transform &player = this->Entities.Get<Transform>(this->Player);
+	this->sampleLead(player.Position, player.Size, left, right, ahead);
+}
+
+void Game::SamplePlayer(const RenderSnapshot &snapshot, GLboolean left, GLboolean right, GLfloat ahead)
+{
+	this->PlayerLead = glm::vec2(0.0f);
+	if (snapshot.State == GAME_ACTIVE)
+		this->sampleLead(snapshot.Player.Position, snapshot.Player.Size, left, right, ahead);
 }
 
+GLboolean Game::ProcessRewind()
+{
+	if (this->State != GAME_ACTIVE || this->History.Empty())
+		return GL_FALSE;
+	if (this->KeyState[RETRY_KEY] == GLFW_RELEASE && this->KeyPress[RETRY_KEY])
+		this->KeyPress[RETRY_KEY] = GL_FALSE;
+	if (this->KeyState[RETRY_KEY] == GLFW_PRESS && !this->KeyPress[RETRY_KEY])
+	{
+		this->KeyPress[RETRY_KEY] = GL_TRUE;
+		GLuint64 target = this->Ticks > RETRY_TICKS ? this->Ticks - RETRY_TICKS : 0;
+		return this->Rewind(std::max(target, this->History.FirstTick()));
+	}
+	if (!this->Keys[REWIND_KEY])
+		return GL_FALSE;
+	// Stay on the oldest tick once there is nothing further back
+	if (this->Ticks > this->History.FirstTick())
+		this->Rewind(this->Ticks - 1);
+	return GL_TRUE;
+}
 
 void Game::ProcessInput(GLfloat dt)
 {
 	if (this->State == GAME_ACTIVE)
 	{
 		GLfloat velocity = PLAYER_VELOCITY * dt;
+		Transform &player = this->Entities.Get<Transform>(this->Player);
 		if (this->Keys[GLFW_KEY_A]) {
-			if (Player->Position.x >= 0) {
-				Player->Position.x -= velocity;
-				if (Ball->Stuck)
-					Ball->Position.x -= velocity;
+			if (player.Position.x >= 0) {
+				player.Position.x -= velocity;
+				this->moveStuckBalls(-velocity);
 			}
 		}
 		if (this->Keys[GLFW_KEY_D]) {
-			if (Player->Position.x <= this->Width - Player->Size.x){
-				Player->Position.x += velocity;
-				if (Ball->Stuck)
-					Ball->Position.x += velocity;
+			if (player.Position.x <= this->Width - player.Size.x){
+				player.Position.x += velocity;
+				this->moveStuckBalls(velocity);
 			}
 		}
 		if (this->KeyState[GLFW_KEY_ENTER] == GLFW_PRESS && !this->KeyPress[GLFW_KEY_ENTER]) {
 			this->KeyPress[GLFW_KEY_ENTER] = true;
 			this->Level = (this->Level + 1) % this->Levels.size();
+			this->ResetLevel();
 		}
 		if (this->KeyState[GLFW_KEY_ENTER] == GLFW_RELEASE && this->KeyPress[GLFW_KEY_ENTER]) {
 			this->KeyPress[GLFW_KEY_ENTER] = false;
 		}
 		if (this->Keys[GLFW_KEY_SPACE])
-			Ball->Stuck = false;
+			this->Entities.Each(BALL_ARCHETYPE, [](Archetype &balls) {
+				for (Ball &ball : balls.Balls)
+					ball.Stuck = false;
+			});
 		/*if (this->KeyState[GLFW_KEY_SPACE] == GLFW_PRESS && !this->KeyPress[GLFW_KEY_SPACE]) {
 			Ball->Stuck = true;
 			this->KeyPress[GLFW_KEY_SPACE] = true;
@@ -147,164 +342,422 @@ void Game::ProcessInput(GLfloat dt)
 
 void Game::Render()
 {
-	if (this->State == GAME_ACTIVE)
+	if (this->State == GAME_ACTIVE && this->Renderer)
+	{
+		this->Snapshot(this->Latest);
+		this->Render(this->Latest);
+	}
+}
+
+// Adds a brick to the snapshot unless it is destroyed
+static void snapshotBrick(RenderSnapshot &snapshot, const Brick &brick, const Transform &transform, const Sprite &sprite)
+{
+	if (brick.Destroyed)
+		return;
+	(brick.IsSolid ? snapshot.SolidBricks : snapshot.Bricks).push_back(SpriteInstance(sprite.Texture, transform.Position, transform.Size, transform.Rotation, sprite.Color));
+	snapshot.LiveBricks += !brick.IsSolid;
+}
+
+void Game::Snapshot(RenderSnapshot &snapshot) const
+{
+	snapshot.State = this->State;
+	snapshot.View = this->View.Position;
+	snapshot.LevelRevision = this->LevelRevision;
+	snapshot.BrickRevision = this->BrickRevision;
+	snapshot.SolidBricks.clear();
+	snapshot.Bricks.clear();
+	snapshot.LiveBricks = 0;
+	const GameLevel &level = this->Levels[this->Level];
+	if (this->View.Scrolls() && !this->Endless && level.Rows > 0)
+	{
+		// Only the tiles under the view are looked at, so the cost follows the size of the window, not of the level
+		glm::vec2 tile(level.Width / static_cast<GLfloat>(level.Columns), level.Height / static_cast<GLfloat>(level.Rows));
+		glm::vec2 from = glm::floor(this->View.Position / tile), to = glm::ceil((this->View.Position + this->View.ViewSize) / tile);
+		GLuint left = static_cast<GLuint>(std::max(from.x, 0.0f)), right = static_cast<GLuint>(std::min(to.x, static_cast<GLfloat>(level.Columns)));
+		GLuint top = static_cast<GLuint>(std::max(from.y, 0.0f)), bottom = static_cast<GLuint>(std::min(to.y, static_cast<GLfloat>(level.Rows)));
+		for (GLuint y = top; y < bottom; ++y)
+		{
+			for (GLuint x = left; x < right; ++x)
+			{
+				Entity brick = this->BrickGrid[y * level.Columns + x];
+				if (brick.IsValid())
+					snapshotBrick(snapshot, this->Entities.Get<Brick>(brick), this->Entities.Get<Transform>(brick), this->Entities.Get<Sprite>(brick));
+			}
+		}
+	}
+	else
+	{
+		this->Entities.Each(BRICK_ARCHETYPE, [&](const Archetype &bricks) {
+			for (GLuint i = 0; i < bricks.Size(); ++i)
+				snapshotBrick(snapshot, bricks.Bricks[i], bricks.Transforms[i], bricks.Sprites[i]);
+		});
+	}
+	// Visible rows of the endless mode; all of them scroll, so their solid bricks go with the rest
+	// and the static layer keeps just the background
+	if (this->Endless)
+	{
+		TextureView block = this->spriteOf(this->BlockTexture).Texture, solid = this->spriteOf(this->SolidBlockTexture).Texture;
+		GLuint64 begin, end;
+		this->Stream.RowsIn(0.0f, static_cast<GLfloat>(this->Height), begin, end);
+		for (GLuint64 row = begin; row < end; ++row)
+		{
+			for (GLuint x = 0; x < this->Stream.Columns; ++x)
+			{
+				GLuint tile = this->Stream.Tile(row, x);
+				if (tile == 0)
+					continue;
+				Transform bounds = this->Stream.TileBounds(row, x);
+				snapshot.Bricks.push_back(SpriteInstance(tile == 1 ? solid : block, bounds.Position, bounds.Size, 0.0f, GameLevel::TileColor(tile)));
+				snapshot.LiveBricks += tile != 1;
+			}
+		}
+	}
+	const Transform &player = this->Entities.Get<Transform>(this->Player);
+	const Sprite &paddle = this->Entities.Get<Sprite>(this->Player);
+	snapshot.Player = SpriteInstance(paddle.Texture, player.Position, player.Size, player.Rotation, paddle.Color);
+	snapshot.HeldLeft = this->Keys[GLFW_KEY_A];
+	snapshot.HeldRight = this->Keys[GLFW_KEY_D];
+	snapshot.Balls.clear();
+	snapshot.BallStuck.clear();
+	this->Entities.Each(BALL_ARCHETYPE, [&](const Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+		{
+			const Transform &transform = balls.Transforms[i];
+			snapshot.Balls.push_back(SpriteInstance(balls.Sprites[i].Texture, transform.Position, transform.Size, transform.Rotation, balls.Sprites[i].Color));
+			snapshot.BallStuck.push_back(balls.Balls[i].Stuck);
+		}
+	});
+	if (this->View.Scrolls())
 	{
+		// Particles off screen are left out; each is drawn PARTICLE_SIZE large from its position
+		snapshot.Particles.clear();
+		for (const Particle &particle : this->Particles->Particles())
+			if (particle.Life > 0.0f && this->View.Sees(particle.Position, glm::vec2(PARTICLE_SIZE)))
+				snapshot.Particles.push_back(particle);
+	}
+	else
+		snapshot.Particles = this->Particles->Particles();
+	snapshot.LiveParticles = this->Particles->LiveCount();
+}
+
+// Key of a cached layer: its revision as seen from the camera at view (a view at the origin keeps the plain revision)
+static GLuint64 layerKey(GLuint revision, glm::vec2 view)
+{
+	GLuint x, y;
+	std::memcpy(&x, &view.x, sizeof(x));
+	std::memcpy(&y, &view.y, sizeof(y));
+	return revision ^ (((static_cast<GLuint64>(x) << 32) | y) * 0x9E3779B97F4A7C15ull);
+}
+
+void Game::Render(const RenderSnapshot &snapshot)
+{
+	if (snapshot.State == GAME_ACTIVE && this->Renderer)
+	{
+		MetricTimer timer(this->Stats.RenderTime);
+		GLuint drawCalls = RenderStats::DrawCalls;
 		// Ϊ2DϷ棬ûȼƣҪʵǰΣײǱͼƬ
 		// Ҫû˳ȻƵڵ
-		// Draw background
-		Renderer->DrawSprite(ResourceManager::GetTexture("background"), glm::vec2(0, 0), glm::vec2(this->Width, this->Height), 0.0f);
-		// Draw level
-		this->Levels[this->Level].Draw(*Renderer);
-		// Draw player
-		Player->Draw(*Renderer);
+		// Draw background and level; both only change with the level or a destroyed brick, so they
+		// are drawn into cached layers and composited with one quad each
+		// Everything is drawn through the camera. The layers are cached per camera position; while the
+		// camera moves they would have to be redrawn every frame anyway, so they are drawn straight away
+		glm::vec2 view = snapshot.View, size = this->View.ViewSize;
+		glm::mat4 projection = Camera::Projection(view, size);
+		this->Renderer->SetProjection(projection);
+		this->Particles->SetProjection(projection);
+		GLboolean cached = view == this->renderedView;
+		this->renderedView = view;
+		if (!cached || this->StaticLayer.Begin(layerKey(snapshot.LevelRevision, view)))
+		{
+			// The background stays put on screen
+			this->Renderer->DrawSprite(ResourceManager::GetTexture(this->BackgroundTexture), view, size, 0.0f);
+			for (const SpriteInstance &brick : snapshot.SolidBricks)
+				this->drawSprite(brick);
+			if (cached)
+				this->StaticLayer.End();
+		}
+		if (!cached || this->BrickLayer.Begin(layerKey(snapshot.BrickRevision, view)))
+		{
+			for (const SpriteInstance &brick : snapshot.Bricks)
+				this->drawSprite(brick);
+			if (cached)
+				this->BrickLayer.End();
+		}
+		if (cached)
+		{
+			this->StaticLayer.Draw(*this->Renderer, size.x, size.y, view);
+			this->BrickLayer.Draw(*this->Renderer, size.x, size.y, view);
+		}
+		// Draw player, moved ahead to the newest input
+		this->drawSprite(snapshot.Player, this->PlayerLead);
 		// Draw particles	
-		Particles->Draw();
-		// Draw ball
-		Ball->Draw(*Renderer);
+		this->Particles->Draw(snapshot.Particles);
+		// Draw ball; balls stuck to the paddle follow its lead
+		for (GLuint i = 0; i < snapshot.Balls.size(); ++i)
+			this->drawSprite(snapshot.Balls[i], snapshot.BallStuck[i] ? this->PlayerLead : glm::vec2(0.0f));
+		// Gauges are sampled once per rendered frame
+		Metrics::Record(this->Stats.DrawCalls, RenderStats::DrawCalls - drawCalls);
+		Metrics::Set(this->Stats.LiveBricks, snapshot.LiveBricks);
+		Metrics::Set(this->Stats.LiveParticles, snapshot.LiveParticles);
 	}
 }
 
+GLboolean Game::PlayEndless(const LevelSpec &spec, GLfloat scrollSpeed)
+{
+	// The endless mode plays within the window; the first rows fill its upper half, like the shipped levels
+	this->Width = static_cast<GLuint>(this->View.ViewSize.x);
+	this->Height = static_cast<GLuint>(this->View.ViewSize.y);
+	this->View.WorldSize = this->View.ViewSize;
+	this->View.Position = glm::vec2(0.0f);
+	if (!this->Stream.Init(spec, this->Width, this->Height, this->Height * 0.5f, scrollSpeed))
+		return GL_FALSE;
+	this->Endless = GL_TRUE;
+	this->History.Clear();
+	this->ResetLevel();
+	return GL_TRUE;
+}
+
+GLboolean Game::PlayLevel(const GameLevel &level, glm::vec2 tileSize)
+{
+	if (level.Rows == 0)
+		return GL_FALSE;
+	GameLevel tiled = level;
+	tiled.Width = static_cast<GLuint>(level.Columns * tileSize.x);
+	tiled.Height = static_cast<GLuint>(level.Rows * tileSize.y);
+	this->Width = std::max(static_cast<GLuint>(this->View.ViewSize.x), tiled.Width);
+	this->Height = std::max(static_cast<GLuint>(this->View.ViewSize.y), tiled.Height * 2);
+	this->View.WorldSize = glm::vec2(this->Width, this->Height);
+	this->Levels.assign(1, tiled);
+	this->Level = 0;
+	this->Endless = GL_FALSE;
+	this->History.Clear();
+	this->ResetLevel();
+	this->ResetPlayer();
+	const Transform &player = this->Entities.Get<Transform>(this->Player);
+	this->View.CenterOn(player.Position + player.Size * 0.5f);
+	return GL_TRUE;
+}
+
 void Game::ResetLevel(){
-	if (this->Level == 0)this->Levels[0].Load("levels/one.lvl", this->Width, this->Height * 0.5f);
-	else if (this->Level == 1)
-		this->Levels[1].Load("levels/two.lvl", this->Width, this->Height * 0.5f);
-	else if (this->Level == 2)
-		this->Levels[2].Load("levels/three.lvl", this->Width, this->Height * 0.5f);
-	else if (this->Level == 3)
-		this->Levels[3].Load("levels/four.lvl", this->Width, this->Height * 0.5f);
+	// Bricks are respawned from the tile data, the level file is not read again
+	this->Entities.DestroyAll(COMPONENT_BRICK);
+	if (this->Endless)
+	{
+		this->BrickGrid.clear();
+		this->Stream.Reset();
+	}
+	else
+		this->Levels[this->Level].Spawn(this->Entities, &this->BrickGrid);
+	this->resetBrickBits();
+	++this->LevelRevision;
+	++this->BrickRevision;
 }
 
 void Game::ResetPlayer() {
 	// Reset player and ball states
-	Player->Size = PLAYER_SIZE;
-	Player->Position = glm::vec2(this->Width / 2 - PLAYER_SIZE.x / 2, this->Height - PLAYER_SIZE.y);
-	Ball->Reset(Player->Position + glm::vec2(PLAYER_SIZE.x / 2 - BALL_RADIUS, -(BALL_RADIUS * 2)),INITIAL_BALL_VELOCITY);
-}
-
-void Game::DoCollisions() {
-	// Check for ball - bricks collisions
-	// ÿһשǷײ
-	// C++еһдǰ & ΪܶԵԪضֱӸд
-	for (GameObject &box : this->Levels[this->Level].Bricks) {
-		if (!box.Destroyed) {
-			Collision collision = CheckCollision(*Ball, box);
-			//  tuple<GLboolean, Direction, glm::vec2> ʹ
-			// ȡض tuple е0λõֵҲ GLboolean ֵ
-			if (std::get<0>(collision)) {
-				// ײ򽫷ǹ̶שΪƻ״̬һѭȾש
-				if (!box.IsSolid)
-					box.Destroyed = true;
-				// ײײָԼ
-				Direction dir = std::get<1>(collision);
-				glm::vec2 diff_vector = std::get<2>(collision);
-				if (dir == LEFT || dir == RIGHT) {
-					Ball->Velocity.x = -Ball->Velocity.x; // תϵٶȣhorizontal
-					GLfloat penetration = Ball->Radius - std::abs(diff_vector.x);
-					Ball->Position.x += penetration * (dir == LEFT ? 1 : -1);
-				}
-				if (dir == UP || dir == DOWN) {
-					Ball->Velocity.y = -Ball->Velocity.y; // תϵٶȣvertical
-					GLfloat penetration = Ball->Radius - std::abs(diff_vector.y);
-					Ball->Position.y += penetration * (dir == UP ? -1 : 1);
-				}
-			}
+	Transform &player = this->Entities.Get<Transform>(this->Player);
+	player.Size = PLAYER_SIZE;
+	player.Position = glm::vec2(this->Width / 2 - PLAYER_SIZE.x / 2, this->Height - PLAYER_SIZE.y);
+	// Back to a single ball resting on the paddle
+	this->Entities.DestroyAll(COMPONENT_BALL);
+	this->SpawnBall(player.Position + glm::vec2(PLAYER_SIZE.x / 2 - BALL_RADIUS, -(BALL_RADIUS * 2)), INITIAL_BALL_VELOCITY);
+}
+
+Sprite Game::spriteOf(TextureHandle texture) const {
+	return texture.IsValid() ? Sprite(ResourceManager::GetTexture(texture)) : Sprite();
+}
+
+void Game::sampleLead(glm::vec2 position, glm::vec2 size, GLboolean left, GLboolean right, GLfloat ahead) {
+	// The paddle moves as ProcessInput will move it, within the window
+	GLfloat dx = (static_cast<GLint>(right) - static_cast<GLint>(left)) * PLAYER_VELOCITY * ahead;
+	GLfloat minX = std::min(0.0f, position.x), maxX = std::max(this->Width - size.x, position.x);
+	this->PlayerLead.x = glm::clamp(position.x + dx, minX, maxX) - position.x;
+}
+
+void Game::drawSprite(const SpriteInstance &sprite, glm::vec2 offset) {
+	this->Renderer->DrawSprite(sprite.Texture, sprite.Position + offset, sprite.Size, sprite.Rotation, sprite.Color);
+}
+
+void Game::resetBrickBits() {
+	this->brickBits.assign((this->BrickGrid.size() + 31) / 32, 0);
+	for (GLuint i = 0; i < this->BrickGrid.size(); ++i)
+		if (this->BrickGrid[i].IsValid())
+			this->brickBits[i / 32] |= 1u << (i % 32);
+}
+
+void Game::moveStuckBalls(GLfloat dx) {
+	this->Entities.Each(BALL_ARCHETYPE, [dx](Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+			if (balls.Balls[i].Stuck)
+				balls.Transforms[i].Position.x += dx;
+	});
+}
+
+GLuint Game::DoCollisions() {
+	ArenaVector<Entity> broken((ArenaAllocator<Entity>(this->Frame.Current())));
+	GLuint collisions = CollisionSystem(this->Entities, this->Overlaps, this->Player, &this->BrickRevision, &broken);
+	// Broken bricks lose their bit; the tile of a brick is the one under its center, laid out as GameLevel::Spawn does
+	if (!broken.empty())
+	{
+		const GameLevel &level = this->Levels[this->Level];
+		glm::vec2 tile(level.Width / static_cast<GLfloat>(level.Columns), level.Height / level.Rows);
+		for (const Entity &brick : broken)
+		{
+			const Transform &bounds = this->Entities.Get<Transform>(brick);
+			glm::vec2 cell = glm::floor((bounds.Position + bounds.Size * 0.5f) / tile);
+			GLuint index = static_cast<GLuint>(cell.y) * level.Columns + static_cast<GLuint>(cell.x);
+			this->brickBits[index / 32] &= ~(1u << (index % 32));
 		}
 	}
-	// ǷҿƵײ
-	Collision result = CheckCollision(*Ball, *Player);
-	if (!Ball->Stuck && std::get<0>(result)) {
-		// ʵһЧҽסλûӦظıںٶȷĴС
-		GLfloat centerBoard = Player->Position.x + Player->Size.x / 2;
-		GLfloat distance = (Ball->Position.x + Ball->Radius) - centerBoard;
-		GLfloat percentage = distance / (Player->Size.x / 2);
-		// ٶȷʹС
-		GLfloat strength = 2.0f;
-		glm::vec2 oldVelocity = Ball->Velocity;
-		// Ϊ˲ٶȷ̫ףÿκϵıٶԳٶΪ
-		Ball->Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength;
-		// ȻҪٶȵ䣬ҪٶĳȲ
-		Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
-		// ֤ϵٶȷߵ
-		Ball->Velocity.y = -1 * abs(Ball->Velocity.y);
-	}
+	if (this->Endless)
+		collisions += StreamingCollisionSystem(this->Entities, this->Stream, &this->BrickRevision);
+	return collisions;
 }
 
-// 򵥵ײ⣬˫Ծ߿Ϊײ
-GLboolean CheckCollision(GameObject &one, GameObject &two) // AABB - AABB collision
+GLboolean Game::Rewind(GLuint64 tick)
 {
-	// Collision x-axis?
-	// жϷxǷغ
-	// ൱ϷϽǶ
-	// һһĺķΧ
-	bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
-		two.Position.x + two.Size.x >= one.Position.x;
-	// Collision y-axis?
-	// жϷyǷغ
-	// ൱ϷϽǶ
-	// һһķΧ
-	bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
-		two.Position.y + two.Size.y >= one.Position.y;
-	// Collision only if on both axes
-	return collisionX && collisionY;
-}
-
-// ߿ - Բ߿ײ
-Collision CheckCollision(BallObject &one, GameObject &two) // AABB - Circle collision
-{
-	// Բײ߿Բ
-	// Get center point circle first 
-	glm::vec2 center(one.Position + one.Radius);
-	// ײ߿ƫ
-	//ȥԲĵĵУھڲĲ֣
-	// Calculate AABB info (center, half-extents)
-	glm::vec2 aabb_half_extents(two.Size.x / 2, two.Size.y / 2);
-	glm::vec2 aabb_center(two.Position.x + aabb_half_extents.x, two.Position.y + aabb_half_extents.y);
-	// Get difference vector between both centers
-	// ӾĵԲĵڵķ clamped
-	glm::vec2 difference = center - aabb_center;
-	glm::vec2 clamped = glm::clamp(difference, -aabb_half_extents, aabb_half_extents);
-	// Now that we know the the clamped values, add this to AABB_center and we get the value of box closest to circle
-	//ȡαϵԲĵ㣬ҲǴӾƫһڷ clamped
-	glm::vec2 closest = aabb_center + clamped;
-	// Now retrieve vector between center circle and closest point AABB and check if length < radius
-	// ԲĵαԼײ߾һߣңԼ볤ȣСڰ뾶ײˣ
-	difference = closest - center;
-
-	// غ˲ײո㣬 <  <=
-	if (glm::length(difference) < one.Radius)
+	if (!this->History.Seek(tick, this->stateImage))
+		return GL_FALSE;
+	StateReader reader(this->stateImage);
+	if (!this->LoadState(reader))
 	{
-		std::cout<< "(" << difference[0] << " , " << difference[1] << ")" << std::endl;
-		// ֵ (Ƿײײ--ԲΪ㿴
-		//               Բײ--ײָľͷλûغ)
-		return std::make_tuple(GL_TRUE, VectorDirection(difference), difference);
+		std::cout << "ERROR::GAME: Failed to restore tick " << tick << " from the rewind buffer" << std::endl;
+		this->History.Clear();
+		return GL_FALSE;
 	}
-	else
-		return std::make_tuple(GL_FALSE, UP, glm::vec2(0, 0));
+	// The restored bricks may differ from what the layers hold
+	++this->LevelRevision;
+	++this->BrickRevision;
+	return GL_TRUE;
 }
 
-// Calculates which direction a vector is facing (N,E,S or W)
-// ÿһcompassһײķtargetһԲĵε
-// ķһߵķcosֵ˵нԽСҳнСķ򣬾ײķ
-//  target ֱĵֱӣΪܽнǵֵ޶һСļ
-// ھΣ 0 90 180 
-Direction VectorDirection(const glm::vec2 target)
+void Game::SaveState(StateWriter &writer) const
 {
-	glm::vec2 compass[] = {
-		glm::vec2(0.0f, 1.0f),	// up
-		glm::vec2(1.0f, 0.0f),	// right
-		glm::vec2(0.0f, -1.0f),	// down
-		glm::vec2(-1.0f, 0.0f)	// left
-	};
-	GLfloat max = 0.0f;
-	GLuint best_match = -1;
-	for (GLuint i = 0; i < 4; i++)
+	// Fixed-size parts first, so the images of consecutive ticks line up byte for byte
+	writer.Write(this->State);
+	writer.Write(this->Level);
+	writer.Write(this->Ticks);
+	writer.Write(this->View.Position);
+	if (this->Particles)
+		this->Particles->SaveState(writer);
+	this->Stream.SaveState(writer);
+	writer.Write(this->Entities.Get<Transform>(this->Player));
+	writer.Write(this->brickBits);
+	// The balls last, since their number changes
+	writer.Write(this->Entities.Count(COMPONENT_BALL));
+	this->Entities.Each(BALL_ARCHETYPE, [&](const Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+		{
+			writer.Write(balls.Transforms[i]);
+			writer.Write(balls.Velocities[i]);
+			writer.Write(balls.Balls[i]);
+		}
+	});
+}
+
+GLboolean Game::LoadState(StateReader &reader)
+{
+	GLuint level = 0;
+	reader.Read(this->State);
+	reader.Read(level);
+	reader.Read(this->Ticks);
+	reader.Read(this->View.Position);
+	if (reader.Failed() || level >= this->Levels.size())
+		return GL_FALSE;
+	// The bricks of another level are spawned first, then brought to the image's state like those of this one
+	if (level != this->Level)
+	{
+		this->Level = level;
+		this->ResetLevel();
+	}
+	if (this->Particles)
+		this->Particles->LoadState(reader);
+	this->Stream.LoadState(reader);
+	reader.Read(this->Entities.Get<Transform>(this->Player));
+	// Only the bricks whose bit changed are touched
+	GLuint64 words = 0;
+	if (!reader.Read(words) || words != this->brickBits.size())
+		return GL_FALSE;
+	for (GLuint i = 0; i < words; ++i)
+	{
+		GLuint bits = 0;
+		if (!reader.Read(bits))
+			return GL_FALSE;
+		GLuint changed = bits ^ this->brickBits[i];
+		for (GLuint bit = 0; changed != 0; ++bit, changed >>= 1)
+		{
+			if (!(changed & 1))
+				continue;
+			Entity brick = this->BrickGrid[i * 32 + bit];
+			if (!brick.IsValid())
+				return GL_FALSE;
+			this->Entities.Get<Brick>(brick).Destroyed = !((bits >> bit) & 1);
+		}
+		this->brickBits[i] = bits;
+	}
+	// The balls there are keep their handles unless their number differs; Overlaps drops and adds proxies
+	// of balls that went or came, and re-sorts the moved ones, by itself at the next Update
+	GLuint count = 0;
+	if (!reader.Read(count))
+		return GL_FALSE;
+	if (count != this->Entities.Count(COMPONENT_BALL))
 	{
-		GLfloat dot_product = glm::dot(glm::normalize(target), compass[i]);
-		if (dot_product > max)
+		this->Entities.DestroyAll(COMPONENT_BALL);
+		for (GLuint i = 0; i < count; ++i)
+			this->SpawnBall(glm::vec2(0.0f), glm::vec2(0.0f));
+	}
+	this->Entities.Each(BALL_ARCHETYPE, [&](Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
 		{
-			max = dot_product;
-			best_match = i;
+			reader.Read(balls.Transforms[i]);
+			reader.Read(balls.Velocities[i]);
+			reader.Read(balls.Balls[i]);
 		}
+	});
+	return !reader.Failed();
+}
+
+// FNV-1a over raw bytes
+static GLuint64 hashBytes(GLuint64 hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+template <typename T>
+static GLuint64 hashColumn(GLuint64 hash, const std::vector<T> &column)
+{
+	return column.empty() ? hash : hashBytes(hash, column.data(), column.size() * sizeof(T));
+}
+
+GLuint64 Game::Checksum() const
+{
+	GLuint64 hash = 14695981039346656037ull;
+	hash = hashBytes(hash, &this->State, sizeof(this->State));
+	hash = hashBytes(hash, &this->Level, sizeof(this->Level));
+	hash = hashBytes(hash, this->KeyPress, sizeof(this->KeyPress));
+	// Sprites are left out, texture names differ between headless and windowed runs
+	this->Entities.Each(0, [&](const Archetype &archetype) {
+		hash = hashBytes(hash, &archetype.Mask, sizeof(archetype.Mask));
+		hash = hashColumn(hash, archetype.Entities);
+		hash = hashColumn(hash, archetype.Transforms);
+		hash = hashColumn(hash, archetype.Velocities);
+		hash = hashColumn(hash, archetype.Colliders);
+		hash = hashColumn(hash, archetype.Bricks);
+		hash = hashColumn(hash, archetype.Balls);
+	});
+	if (this->Endless)
+	{
+		GLuint64 first = this->Stream.FirstRow(), end = this->Stream.EndRow();
+		GLfloat top = this->Stream.RowTop(first);
+		hash = hashBytes(hash, &first, sizeof(first));
+		hash = hashBytes(hash, &end, sizeof(end));
+		hash = hashBytes(hash, &top, sizeof(top));
+		hash = hashColumn(hash, this->Stream.Tiles());
 	}
-	return (Direction)best_match;
-}
\ No newline at end of file
+	if (this->Particles)
+		hash = hashColumn(hash, this->Particles->Particles());
+	return hash;
+}
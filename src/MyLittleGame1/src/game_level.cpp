@@ -9,86 +9,137 @@
 #include "game_level.h"
 
 #include <fstream>
+#include <iostream>
 #include <sstream>
 
 
 void GameLevel::Load(const GLchar *file, GLuint levelWidth, GLuint levelHeight)
 {
 	// Clear old data
-	this->Bricks.clear();
+	this->Tiles.clear();
+	this->Columns = this->Rows = 0;
 	// Load from file
 	GLuint tileCode;
-	GameLevel level;
 	std::string line;
 	std::ifstream fstream(file);
-	std::vector<std::vector<GLuint>> tileData;
+	// The rows are scratch data, so they all come from one arena freed in a single step
+	LinearArena scratch(16 * 1024);
+	ArenaAllocator<GLuint> allocator(scratch);
+	ArenaVector<ArenaVector<GLuint>> tileData(allocator);
 	if (fstream)
 	{
 		while (std::getline(fstream, line)) // Read each line from level file
 		{
 			std::istringstream sstream(line);
-			std::vector<GLuint> row;
+			ArenaVector<GLuint> row(allocator);
 			while (sstream >> tileCode) // Read each word seperated by spaces
 				row.push_back(tileCode);
-			tileData.push_back(row);
+			tileData.push_back(std::move(row));
 		}
 		if (tileData.size() > 0)
 			this->init(tileData, levelWidth, levelHeight);
 	}
 }
 
-void GameLevel::Draw(SpriteRenderer &renderer)
+GLboolean GameLevel::Save(const GLchar *file) const
 {
-	for (GameObject &tile : this->Bricks)
-		if (!tile.Destroyed)
-			tile.Draw(renderer);
-}
-
-GLboolean GameLevel::IsCompleted()
-{
-	for (GameObject &tile : this->Bricks)
-		if (!tile.IsSolid && !tile.Destroyed)
-			return GL_FALSE;
-	return GL_TRUE;
+	std::ofstream out(file);
+	if (!out)
+	{
+		std::cout << "ERROR::GAME_LEVEL: Failed to write " << file << std::endl;
+		return GL_FALSE;
+	}
+	// One line per row, codes separated by spaces
+	std::string line;
+	for (GLuint y = 0; y < this->Rows; ++y)
+	{
+		line.clear();
+		for (GLuint x = 0; x < this->Columns; ++x)
+		{
+			if (x > 0)
+				line += ' ';
+			line += std::to_string(this->Tiles[y * this->Columns + x]);
+		}
+		line += '\n';
+		out << line;
+	}
+	return out.good();
 }
 
-void GameLevel::init(std::vector<std::vector<GLuint>> tileData, GLuint levelWidth, GLuint levelHeight)
+void GameLevel::Spawn(Registry &registry, std::vector<Entity> *grid) const
 {
+	if (grid)
+		grid->assign(this->Tiles.size(), Entity());
+	if (this->Rows == 0)
+		return;
 	// Calculate dimensions
-	GLuint height = tileData.size();
-	GLuint width = tileData[0].size(); // Note we can index vector at [0] since this function is only called if height > 0
-	GLfloat unit_width = levelWidth / static_cast<GLfloat>(width), unit_height = levelHeight / height;
+	GLfloat unit_width = this->Width / static_cast<GLfloat>(this->Columns), unit_height = this->Height / this->Rows;
+	// Headless games load no textures, their bricks get empty views
+	TextureHandle solid = ResourceManager::FindTexture("block_solid"), block = ResourceManager::FindTexture("block");
+	TextureView solidTexture = solid.IsValid() ? TextureView(ResourceManager::GetTexture(solid)) : TextureView();
+	TextureView blockTexture = block.IsValid() ? TextureView(ResourceManager::GetTexture(block)) : TextureView();
 	// Initialize level tiles based on tileData		
-	for (GLuint y = 0; y < height; ++y)
+	for (GLuint y = 0; y < this->Rows; ++y)
 	{
-		for (GLuint x = 0; x < width; ++x)
+		for (GLuint x = 0; x < this->Columns; ++x)
 		{
+			GLuint tile = this->Tiles[y * this->Columns + x];
+			if (tile == 0)
+				continue;
+			glm::vec2 pos(unit_width * x, unit_height * y);
+			glm::vec2 size(unit_width, unit_height);
+			Entity brick = registry.Create(BRICK_ARCHETYPE);
+			if (grid)
+				(*grid)[y * this->Columns + x] = brick;
+			registry.Get<Transform>(brick) = Transform(pos, size);
 			// Check block type from level data (2D level array)
-			if (tileData[y][x] == 1) // Solid
+			if (tile == 1) // Solid
 			{
-				glm::vec2 pos(unit_width * x, unit_height * y);
-				glm::vec2 size(unit_width, unit_height);
-				GameObject obj(pos, size, ResourceManager::GetTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
-				obj.IsSolid = GL_TRUE;
-				this->Bricks.push_back(obj);
-			}
-			else if (tileData[y][x] > 1)	// Non-solid; now determine its color based on level data
-			{
-				glm::vec3 color = glm::vec3(1.0f); // original: white
-				if (tileData[y][x] == 2)
-					color = glm::vec3(0.2f, 0.6f, 1.0f);
-				else if (tileData[y][x] == 3)
-					color = glm::vec3(0.0f, 0.7f, 0.0f);
-				else if (tileData[y][x] == 4)
-					color = glm::vec3(0.8f, 0.8f, 0.4f);
-				else if (tileData[y][x] == 5)
-					color = glm::vec3(1.0f, 0.5f, 0.0f);
-				else
-					color = glm::vec3(1.0f, 1.0f, 1.0f);
-				glm::vec2 pos(unit_width * x, unit_height * y);
-				glm::vec2 size(unit_width, unit_height);
-				this->Bricks.push_back(GameObject(pos, size, ResourceManager::GetTexture("block"), color));
+				registry.Get<Sprite>(brick) = Sprite(solidTexture, TileColor(tile));
+				registry.Get<Brick>(brick) = Brick(GL_TRUE);
 			}
+			else	// Non-solid; its color is based on level data
+				registry.Get<Sprite>(brick) = Sprite(blockTexture, TileColor(tile));
 		}
 	}
+}
+
+GLboolean GameLevel::IsCompleted(Registry &registry) const
+{
+	GLboolean completed = GL_TRUE;
+	registry.Each(COMPONENT_BRICK, [&](Archetype &bricks) {
+		for (const Brick &tile : bricks.Bricks)
+			if (!tile.IsSolid && !tile.Destroyed)
+				completed = GL_FALSE;
+	});
+	return completed;
+}
+
+glm::vec3 GameLevel::TileColor(GLuint tile)
+{
+	if (tile == 1) // Solid
+		return glm::vec3(0.8f, 0.8f, 0.7f);
+	if (tile == 2)
+		return glm::vec3(0.2f, 0.6f, 1.0f);
+	if (tile == 3)
+		return glm::vec3(0.0f, 0.7f, 0.0f);
+	if (tile == 4)
+		return glm::vec3(0.8f, 0.8f, 0.4f);
+	if (tile == 5)
+		return glm::vec3(1.0f, 0.5f, 0.0f);
+	return glm::vec3(1.0f, 1.0f, 1.0f); // original: white
+}
+
+void GameLevel::init(const ArenaVector<ArenaVector<GLuint>> &tileData, GLuint levelWidth, GLuint levelHeight)
+{
+	// Store dimensions
+	this->Rows = tileData.size();
+	this->Columns = tileData[0].size(); // Note we can index vector at [0] since this function is only called if height > 0
+	this->Width = levelWidth;
+	this->Height = levelHeight;
+	// Flatten the tile codes; rows shorter than the first one are padded with empty tiles
+	this->Tiles.assign(this->Rows * this->Columns, 0);
+	for (GLuint y = 0; y < this->Rows; ++y)
+		for (GLuint x = 0; x < this->Columns && x < tileData[y].size(); ++x)
+			this->Tiles[y * this->Columns + x] = tileData[y][x];
 }
\ No newline at end of file
@@ -0,0 +1,253 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "game_systems.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "collision.h"
+#include "game.h"
+
+
+glm::vec2 MoveBall(Transform &transform, Velocity &velocity, const Ball &ball, GLfloat dt, GLuint window_width)
+{
+	// If not stuck to player board
+	if (!ball.Stuck)
+	{
+		// Move the ball
+		transform.Position += velocity.Value * dt;
+		// Then check if outside window bounds and if so, reverse velocity and restore at correct position
+		if (transform.Position.x <= 0.0f)
+		{
+			velocity.Value.x = -velocity.Value.x;
+			transform.Position.x = 0.0f;
+		}
+		else if (transform.Position.x + transform.Size.x >= window_width)
+		{
+			velocity.Value.x = -velocity.Value.x;
+			transform.Position.x = window_width - transform.Size.x;
+		}
+		if (transform.Position.y <= 0.0f)
+		{
+			velocity.Value.y = -velocity.Value.y;
+			transform.Position.y = 0.0f;
+		}
+	}
+	return transform.Position;
+}
+
+void MoveSystem(Registry &registry, GLfloat dt, GLuint window_width)
+{
+	registry.Each(BALL_ARCHETYPE, [&](Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+			MoveBall(balls.Transforms[i], balls.Velocities[i], balls.Balls[i], dt, window_width);
+	});
+}
+
+void BounceOffBox(Transform &ball, glm::vec2 &velocity, GLfloat radius, const Collision &collision)
+{
+	// ײײָԼ
+	Direction dir = std::get<1>(collision);
+	glm::vec2 diff_vector = std::get<2>(collision);
+	if (dir == LEFT || dir == RIGHT) {
+		velocity.x = -velocity.x; // תϵٶȣhorizontal
+		GLfloat penetration = radius - std::abs(diff_vector.x);
+		ball.Position.x += penetration * (dir == LEFT ? 1 : -1);
+	}
+	if (dir == UP || dir == DOWN) {
+		velocity.y = -velocity.y; // תϵٶȣvertical
+		GLfloat penetration = radius - std::abs(diff_vector.y);
+		ball.Position.y += penetration * (dir == UP ? -1 : 1);
+	}
+}
+
+// Resolves a ball - brick pair; returns 1 if they collided and counts the brick in destroyed (and lists it in bricks, if given) if it broke
+static GLuint collideBallBrick(Registry &registry, Entity ballEntity, Entity brickEntity, GLuint &destroyed, ArenaVector<Entity> *bricks)
+{
+	Brick &box = registry.Get<Brick>(brickEntity);
+	if (box.Destroyed)
+		return 0;
+	Transform &ball = registry.Get<Transform>(ballEntity);
+	glm::vec2 &velocity = registry.Get<Velocity>(ballEntity).Value;
+	GLfloat radius = registry.Get<Collider>(ballEntity).Radius;
+	Collision collision = CheckCollision(ball, radius, registry.Get<Transform>(brickEntity));
+	//  tuple<GLboolean, Direction, glm::vec2> ʹ
+	// ȡض tuple е0λõֵҲ GLboolean ֵ
+	if (!std::get<0>(collision))
+		return 0;
+	// ײ򽫷ǹ̶שΪƻ״̬һѭȾש
+	if (!box.IsSolid)
+	{
+		box.Destroyed = true;
+		++destroyed;
+		if (bricks)
+			bricks->push_back(brickEntity);
+	}
+	BounceOffBox(ball, velocity, radius, collision);
+	return 1;
+}
+
+GLboolean BounceOffPaddle(Transform &ball, glm::vec2 &velocity, GLfloat radius, const Transform &player)
+{
+	// ǷҿƵײ
+	Collision result = CheckCollision(ball, radius, player);
+	if (!std::get<0>(result))
+		return GL_FALSE;
+	// ʵһЧҽסλûӦظıںٶȷĴС
+	GLfloat centerBoard = player.Position.x + player.Size.x / 2;
+	GLfloat distance = (ball.Position.x + radius) - centerBoard;
+	GLfloat percentage = distance / (player.Size.x / 2);
+	// ٶȷʹС
+	GLfloat strength = 2.0f;
+	glm::vec2 oldVelocity = velocity;
+	// Ϊ˲ٶȷ̫ףÿκϵıٶԳٶΪ
+	velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength;
+	// ȻҪٶȵ䣬ҪٶĳȲ
+	velocity = glm::normalize(velocity) * glm::length(oldVelocity);
+	// ֤ϵٶȷߵ
+	velocity.y = -1 * std::abs(velocity.y);
+	return GL_TRUE;
+}
+
+// Resolves a ball - paddle pair; returns 1 if they collided
+static GLuint collideBallPaddle(Registry &registry, Entity ballEntity, Entity paddle)
+{
+	if (registry.Get<Ball>(ballEntity).Stuck)
+		return 0;
+	Transform &ball = registry.Get<Transform>(ballEntity);
+	glm::vec2 &velocity = registry.Get<Velocity>(ballEntity).Value;
+	GLfloat radius = registry.Get<Collider>(ballEntity).Radius;
+	return BounceOffPaddle(ball, velocity, radius, registry.Get<Transform>(paddle));
+}
+
+GLboolean BounceBalls(Transform &one, glm::vec2 &velocityOne, GLfloat radiusOne, Transform &two, glm::vec2 &velocityTwo, GLfloat radiusTwo)
+{
+	Collision collision = CheckCollision(one, radiusOne, two, radiusTwo);
+	if (!std::get<0>(collision))
+		return GL_FALSE;
+	// Push both balls apart along the line through their centers
+	glm::vec2 difference = std::get<2>(collision);
+	GLfloat length = glm::length(difference);
+	glm::vec2 normal = length > 0.0f ? difference / length : glm::vec2(1.0f, 0.0f);
+	GLfloat penetration = radiusOne + radiusTwo - length;
+	one.Position -= normal * (penetration * 0.5f);
+	two.Position += normal * (penetration * 0.5f);
+	// Equal masses swap their velocity components along the normal, but only while approaching
+	GLfloat approach = glm::dot(velocityOne - velocityTwo, normal);
+	if (approach > 0.0f)
+	{
+		velocityOne -= normal * approach;
+		velocityTwo += normal * approach;
+	}
+	return GL_TRUE;
+}
+
+// Resolves a ball - ball pair as an elastic collision of equal masses; returns 1 if they collided
+static GLuint collideBalls(Registry &registry, Entity first, Entity second)
+{
+	// Balls resting on the paddle are left alone
+	if (registry.Get<Ball>(first).Stuck || registry.Get<Ball>(second).Stuck)
+		return 0;
+	return BounceBalls(registry.Get<Transform>(first), registry.Get<Velocity>(first).Value, registry.Get<Collider>(first).Radius,
+		registry.Get<Transform>(second), registry.Get<Velocity>(second).Value, registry.Get<Collider>(second).Radius);
+}
+
+GLuint CollisionSystem(Registry &registry, Broadphase &broadphase, Entity paddle, GLuint *bricksDestroyed, ArenaVector<Entity> *destroyedBricks)
+{
+	GLuint collisions = 0, destroyed = 0;
+	// Only pairs whose bounds overlap are tested: ball - brick, ball - paddle and ball - ball
+	broadphase.Update(registry, COMPONENT_TRANSFORM | COMPONENT_COLLIDER);
+	broadphase.Sweep([&](const Proxy &a, const Proxy &b) {
+		GLboolean ballA = (a.Mask & COMPONENT_BALL) != 0, ballB = (b.Mask & COMPONENT_BALL) != 0;
+		if (ballA && ballB)
+			collisions += collideBalls(registry, a.Owner, b.Owner);
+		else if (ballA || ballB)
+		{
+			const Proxy &ball = ballA ? a : b;
+			const Proxy &other = ballA ? b : a;
+			if (other.Mask & COMPONENT_BRICK)
+				collisions += collideBallBrick(registry, ball.Owner, other.Owner, destroyed, destroyedBricks);
+			else if (other.Owner == paddle)
+				collisions += collideBallPaddle(registry, ball.Owner, paddle);
+		}
+	});
+	if (bricksDestroyed)
+		*bricksDestroyed += destroyed;
+	return collisions;
+}
+
+GLuint StreamingCollisionSystem(Registry &registry, StreamingLevel &level, GLuint *bricksDestroyed)
+{
+	GLuint collisions = 0, destroyed = 0;
+	if (level.Columns == 0)
+		return 0;
+	registry.Each(BALL_ARCHETYPE, [&](Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+		{
+			Transform &ball = balls.Transforms[i];
+			glm::vec2 &velocity = balls.Velocities[i].Value;
+			GLfloat radius = balls.Colliders[i].Radius;
+			// Only the tiles under the ball's bounds are tested
+			GLuint64 begin, end;
+			level.RowsIn(ball.Position.y, ball.Position.y + ball.Size.y, begin, end);
+			GLint left = static_cast<GLint>(std::floor(ball.Position.x / level.TileWidth));
+			GLint right = static_cast<GLint>(std::floor((ball.Position.x + ball.Size.x) / level.TileWidth));
+			left = std::max(left, 0);
+			right = std::min(right, static_cast<GLint>(level.Columns) - 1);
+			for (GLuint64 row = begin; row < end; ++row)
+			{
+				for (GLint x = left; x <= right; ++x)
+				{
+					GLuint &tile = level.Tile(row, x);
+					if (tile == 0)
+						continue;
+					Collision collision = CheckCollision(ball, radius, level.TileBounds(row, x));
+					if (!std::get<0>(collision))
+						continue;
+					// Breakable tiles are emptied, the slot stays until the row is recycled
+					if (tile != 1)
+					{
+						tile = 0;
+						++destroyed;
+					}
+					BounceOffBox(ball, velocity, radius, collision);
+					++collisions;
+				}
+			}
+		}
+	});
+	if (bricksDestroyed)
+		*bricksDestroyed += destroyed;
+	return collisions;
+}
+
+void RenderSystem(Registry &registry, SpriteRenderer &renderer, ComponentMask include, ComponentMask exclude)
+{
+	registry.Each(include | COMPONENT_TRANSFORM | COMPONENT_SPRITE, [&](Archetype &archetype) {
+		if (archetype.Mask & exclude)
+			return;
+		GLboolean bricks = archetype.Has(COMPONENT_BRICK);
+		for (GLuint i = 0; i < archetype.Size(); ++i)
+		{
+			if (bricks && archetype.Bricks[i].Destroyed)
+				continue;
+			const Transform &transform = archetype.Transforms[i];
+			Sprite &sprite = archetype.Sprites[i];
+			renderer.DrawSprite(sprite.Texture, transform.Position, transform.Size, transform.Rotation, sprite.Color);
+		}
+	});
+}
+
+void ParticleEmitSystem(Registry &registry, ParticleGenerator &particles, GLuint newParticles)
+{
+	registry.Each(BALL_ARCHETYPE, [&](Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size(); ++i)
+			particles.Emit(balls.Transforms[i].Position, balls.Velocities[i].Value, newParticles, glm::vec2(balls.Colliders[i].Radius / 2));
+	});
+}
@@ -0,0 +1,60 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "input_queue.h"
+
+
+InputQueue::InputQueue()
+	: head(0), tail(0), dropped(0)
+{
+
+}
+
+GLboolean InputQueue::Push(const KeyEvent &event)
+{
+	GLuint tail = this->tail.load(std::memory_order_relaxed);
+	if (tail - this->head.load(std::memory_order_acquire) == CAPACITY)
+	{
+		this->dropped.fetch_add(1, std::memory_order_relaxed);
+		return GL_FALSE;
+	}
+	this->events[tail % CAPACITY] = event;
+	// Publishes the event to the consumer
+	this->tail.store(tail + 1, std::memory_order_release);
+	return GL_TRUE;
+}
+
+GLboolean InputQueue::Peek(KeyEvent &event) const
+{
+	GLuint head = this->head.load(std::memory_order_relaxed);
+	if (head == this->tail.load(std::memory_order_acquire))
+		return GL_FALSE;
+	event = this->events[head % CAPACITY];
+	return GL_TRUE;
+}
+
+void InputQueue::Pop()
+{
+	// Hands the slot back to the producer
+	this->head.store(this->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+GLuint InputQueue::Size() const
+{
+	return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_relaxed);
+}
+
+const KeyEvent &InputQueue::Pending(GLuint index) const
+{
+	return this->events[(this->head.load(std::memory_order_relaxed) + index) % CAPACITY];
+}
+
+GLuint InputQueue::Dropped() const
+{
+	return this->dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,217 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "input_recording.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+
+// File layout: magic, version, then variable-length integers except for the raw 64 bit seed and checksums
+static const char   RECORDING_MAGIC[4] = { 'B', 'K', 'R', 'P' };
+static const GLuint RECORDING_VERSION = 1;
+
+static void writeVarint(std::ostream &out, GLuint64 value)
+{
+	while (value >= 0x80)
+	{
+		out.put(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.put(static_cast<char>(value));
+}
+
+static GLboolean readVarint(std::istream &in, GLuint64 &value)
+{
+	value = 0;
+	for (GLuint shift = 0; shift < 64; shift += 7)
+	{
+		int byte = in.get();
+		if (byte == EOF)
+			return GL_FALSE;
+		value |= static_cast<GLuint64>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return GL_TRUE;
+	}
+	return GL_FALSE;
+}
+
+static void writeRaw64(std::ostream &out, GLuint64 value)
+{
+	for (GLuint i = 0; i < 8; ++i)
+		out.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+}
+
+static GLboolean readRaw64(std::istream &in, GLuint64 &value)
+{
+	value = 0;
+	for (GLuint i = 0; i < 8; ++i)
+	{
+		int byte = in.get();
+		if (byte == EOF)
+			return GL_FALSE;
+		value |= static_cast<GLuint64>(byte & 0xFF) << (i * 8);
+	}
+	return GL_TRUE;
+}
+
+
+InputRecording::InputRecording()
+	: Seed(0), Width(0), Height(0), Ticks(0), keys(), keyState(), tick(0), cursor(0)
+{
+
+}
+
+void InputRecording::Start(const Game &game)
+{
+	this->Seed = game.Seed;
+	this->Width = game.Width;
+	this->Height = game.Height;
+	this->Ticks = 0;
+	this->Events.clear();
+	this->Checksums.clear();
+	// Replays start from a fresh game with nothing pressed
+	std::memset(this->keys, 0, sizeof(this->keys));
+	std::memset(this->keyState, 0, sizeof(this->keyState));
+	this->Rewind();
+}
+
+void InputRecording::Capture(const Game &game)
+{
+	for (GLuint key = 0; key < 1024; ++key)
+	{
+		if (game.Keys[key] == this->keys[key] && game.KeyState[key] == this->keyState[key])
+			continue;
+		InputEvent event;
+		event.Tick = this->Ticks;
+		event.Key = key;
+		event.Down = game.Keys[key];
+		event.Action = game.KeyState[key];
+		this->Events.push_back(event);
+		this->keys[key] = game.Keys[key];
+		this->keyState[key] = game.KeyState[key];
+	}
+	++this->Ticks;
+}
+
+void InputRecording::Checkpoint(const Game &game)
+{
+	if (this->Ticks % CHECKSUM_INTERVAL == 0)
+		this->Checksums.push_back(game.Checksum());
+}
+
+void InputRecording::Rewind()
+{
+	this->tick = 0;
+	this->cursor = 0;
+}
+
+GLboolean InputRecording::Apply(Game &game)
+{
+	if (this->tick >= this->Ticks)
+		return GL_FALSE;
+	for (; this->cursor < this->Events.size() && this->Events[this->cursor].Tick == this->tick; ++this->cursor)
+	{
+		const InputEvent &event = this->Events[this->cursor];
+		game.Keys[event.Key] = event.Down;
+		game.KeyState[event.Key] = event.Action;
+	}
+	++this->tick;
+	return GL_TRUE;
+}
+
+GLuint64 InputRecording::ChecksumAt(GLuint ticks) const
+{
+	if (ticks == 0 || ticks % CHECKSUM_INTERVAL != 0 || ticks / CHECKSUM_INTERVAL > this->Checksums.size())
+		return 0;
+	return this->Checksums[ticks / CHECKSUM_INTERVAL - 1];
+}
+
+GLboolean InputRecording::Save(const GLchar *file) const
+{
+	std::ofstream out(file, std::ios::binary);
+	if (!out)
+	{
+		std::cout << "ERROR::RECORDING: Failed to open " << file << " for writing" << std::endl;
+		return GL_FALSE;
+	}
+	out.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	writeVarint(out, RECORDING_VERSION);
+	writeRaw64(out, this->Seed);
+	writeVarint(out, this->Width);
+	writeVarint(out, this->Height);
+	writeVarint(out, this->Ticks);
+	writeVarint(out, CHECKSUM_INTERVAL);
+	// Events as (ticks since previous event, key, down | action << 1)
+	writeVarint(out, this->Events.size());
+	GLuint previous = 0;
+	for (const InputEvent &event : this->Events)
+	{
+		writeVarint(out, event.Tick - previous);
+		writeVarint(out, event.Key);
+		writeVarint(out, (event.Down ? 1 : 0) | (event.Action << 1));
+		previous = event.Tick;
+	}
+	writeVarint(out, this->Checksums.size());
+	for (GLuint64 checksum : this->Checksums)
+		writeRaw64(out, checksum);
+	return out.good() ? GL_TRUE : GL_FALSE;
+}
+
+GLboolean InputRecording::Load(const GLchar *file)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in)
+	{
+		std::cout << "ERROR::RECORDING: Failed to open " << file << std::endl;
+		return GL_FALSE;
+	}
+	char magic[4];
+	GLuint64 version, width, height, ticks, interval, count;
+	in.read(magic, sizeof(magic));
+	if (!in || std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0 || !readVarint(in, version) || version != RECORDING_VERSION)
+	{
+		std::cout << "ERROR::RECORDING: " << file << " is not a recording of a supported version" << std::endl;
+		return GL_FALSE;
+	}
+	GLboolean ok = readRaw64(in, this->Seed) && readVarint(in, width) && readVarint(in, height)
+		&& readVarint(in, ticks) && readVarint(in, interval) && interval == CHECKSUM_INTERVAL && readVarint(in, count);
+	this->Width = static_cast<GLuint>(width);
+	this->Height = static_cast<GLuint>(height);
+	this->Ticks = static_cast<GLuint>(ticks);
+	this->Events.clear();
+	this->Checksums.clear();
+	GLuint64 tick = 0;
+	for (GLuint64 i = 0; ok && i < count; ++i)
+	{
+		GLuint64 delta, key, flags;
+		ok = readVarint(in, delta) && readVarint(in, key) && readVarint(in, flags) && key < 1024;
+		tick += delta;
+		InputEvent event;
+		event.Tick = static_cast<GLuint>(tick);
+		event.Key = static_cast<GLuint>(key);
+		event.Down = (flags & 1) ? GL_TRUE : GL_FALSE;
+		event.Action = static_cast<GLuint>(flags >> 1);
+		this->Events.push_back(event);
+	}
+	ok = ok && readVarint(in, count);
+	for (GLuint64 i = 0; ok && i < count; ++i)
+	{
+		GLuint64 checksum;
+		ok = readRaw64(in, checksum);
+		this->Checksums.push_back(checksum);
+	}
+	if (!ok)
+	{
+		std::cout << "ERROR::RECORDING: " << file << " is truncated or corrupt" << std::endl;
+		return GL_FALSE;
+	}
+	this->Rewind();
+	return GL_TRUE;
+}
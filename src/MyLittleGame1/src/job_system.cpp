@@ -0,0 +1,244 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "job_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+
+namespace
+{
+	// Capacity of a single worker deque (power of two); jobs that do not fit run inline
+	const GLuint QUEUE_CAPACITY = 4096;
+
+	// Fixed-size deque of jobs. The owning thread pushes and pops at the
+	// tail, thieves take from the head. Indices grow monotonically and are
+	// wrapped on access, which stays correct across GLuint overflow since
+	// the capacity divides 2^32.
+	struct WorkerQueue {
+		std::mutex Lock;
+		Job        Jobs[QUEUE_CAPACITY];
+		GLuint     Head, Tail;
+
+		WorkerQueue() : Head(0), Tail(0) { }
+
+		GLboolean Push(const Job &job)
+		{
+			std::lock_guard<std::mutex> guard(this->Lock);
+			if (this->Tail - this->Head == QUEUE_CAPACITY)
+				return GL_FALSE;
+			this->Jobs[this->Tail++ % QUEUE_CAPACITY] = job;
+			return GL_TRUE;
+		}
+		GLboolean PopBack(Job &job)
+		{
+			std::lock_guard<std::mutex> guard(this->Lock);
+			if (this->Tail == this->Head)
+				return GL_FALSE;
+			job = this->Jobs[--this->Tail % QUEUE_CAPACITY];
+			return GL_TRUE;
+		}
+		GLboolean StealFront(Job &job)
+		{
+			std::unique_lock<std::mutex> guard(this->Lock, std::try_to_lock);
+			if (!guard.owns_lock() || this->Tail == this->Head)
+				return GL_FALSE;
+			job = this->Jobs[this->Head++ % QUEUE_CAPACITY];
+			return GL_TRUE;
+		}
+	};
+
+	// Pool state; index 0 of Queues belongs to the main (or any non-worker) thread
+	std::vector<WorkerQueue *> Queues;
+	std::vector<std::thread>   Workers;
+	std::atomic<bool>          Running(false);
+	std::atomic<GLint>         Queued(0);
+	std::mutex                 SleepLock;
+	std::condition_variable    WakeUp;
+	thread_local GLuint        WorkerIndex = 0;
+}
+
+
+void JobSystem::Init(GLuint threadCount)
+{
+	if (!Queues.empty())
+		Shutdown();
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	for (GLuint i = 0; i < threadCount; ++i)
+		Queues.push_back(new WorkerQueue());
+	WorkerIndex = 0;
+	Running = true;
+	for (GLuint i = 1; i < threadCount; ++i)
+		Workers.push_back(std::thread(&JobSystem::workerLoop, i));
+}
+
+void JobSystem::Shutdown()
+{
+	// Finish whatever is still queued before tearing the workers down
+	Job job;
+	while (Queued.load() > 0)
+		if (findJob(job))
+			execute(job);
+	Running = false;
+	WakeUp.notify_all();
+	for (std::thread &worker : Workers)
+		worker.join();
+	Workers.clear();
+	for (WorkerQueue *queue : Queues)
+		delete queue;
+	Queues.clear();
+}
+
+GLuint JobSystem::ThreadCount()
+{
+	return static_cast<GLuint>(Workers.size()) + 1;
+}
+
+void JobSystem::Run(JobFunction function, void *data, GLuint begin, GLuint end, JobCounter *counter)
+{
+	Job job;
+	job.Function = function;
+	job.Data = data;
+	job.Begin = begin;
+	job.End = end;
+	job.Counter = counter;
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	schedule(job);
+}
+
+void JobSystem::Run(const std::function<void()> &task, JobCounter *counter)
+{
+	Run(&JobSystem::invokeTask, new std::function<void()>(task), 0, 0, counter);
+}
+
+void JobSystem::RunAfter(JobCounter &dependency, const std::function<void()> &task, JobCounter *counter)
+{
+	Job job;
+	job.Function = &JobSystem::invokeTask;
+	job.Data = new std::function<void()>(task);
+	job.Counter = counter;
+	if (counter)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> guard(dependency.lock);
+		if (dependency.pending.load(std::memory_order_acquire) > 0)
+		{
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+	schedule(job);
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+	Job job;
+	while (!counter.IsDone())
+	{
+		if (findJob(job))
+			execute(job);
+		else
+			std::this_thread::yield();
+	}
+	// Make sure the thread that brought the counter to zero is done touching it
+	std::lock_guard<std::mutex> guard(counter.lock);
+}
+
+void JobSystem::ParallelFor(GLuint count, GLuint grainSize, JobFunction body, void *data)
+{
+	if (count == 0)
+		return;
+	grainSize = std::max(1u, grainSize);
+	if (ThreadCount() == 1 || count <= grainSize)
+	{
+		body(data, 0, count);
+		return;
+	}
+	// Queue every chunk but the first, which the calling thread processes itself
+	JobCounter counter;
+	for (GLuint begin = grainSize; begin < count; begin += grainSize)
+		Run(body, data, begin, std::min(count, begin + grainSize), &counter);
+	body(data, 0, grainSize);
+	Wait(counter);
+}
+
+void JobSystem::schedule(const Job &job)
+{
+	if (Workers.empty() || !Queues[WorkerIndex]->Push(job))
+	{
+		execute(job);
+		return;
+	}
+	Queued.fetch_add(1, std::memory_order_release);
+	WakeUp.notify_one();
+}
+
+void JobSystem::execute(const Job &job)
+{
+	job.Function(job.Data, job.Begin, job.End);
+	JobCounter *counter = job.Counter;
+	if (!counter)
+		return;
+	// Only the decrement to zero takes the lock, so Wait can synchronize with
+	// the last finisher before the counter goes out of scope
+	GLint prev = counter->pending.load(std::memory_order_acquire);
+	while (prev > 1)
+		if (counter->pending.compare_exchange_weak(prev, prev - 1, std::memory_order_acq_rel))
+			return;
+	std::vector<Job> ready;
+	{
+		std::lock_guard<std::mutex> guard(counter->lock);
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			ready.swap(counter->continuations);
+	}
+	for (const Job &continuation : ready)
+		schedule(continuation);
+}
+
+GLboolean JobSystem::findJob(Job &job)
+{
+	if (Queues.empty())
+		return GL_FALSE;
+	GLuint count = static_cast<GLuint>(Queues.size());
+	GLboolean found = Queues[WorkerIndex]->PopBack(job);
+	// Nothing local: try to steal from the other deques, starting with our neighbour
+	for (GLuint i = 1; !found && i < count; ++i)
+		found = Queues[(WorkerIndex + i) % count]->StealFront(job);
+	if (found)
+		Queued.fetch_sub(1, std::memory_order_acq_rel);
+	return found;
+}
+
+void JobSystem::workerLoop(GLuint index)
+{
+	WorkerIndex = index;
+	Job job;
+	while (Running.load(std::memory_order_acquire))
+	{
+		if (findJob(job))
+			execute(job);
+		else
+		{
+			// Sleep until new work arrives; the timeout covers a notify racing with the check
+			std::unique_lock<std::mutex> guard(SleepLock);
+			WakeUp.wait_for(guard, std::chrono::milliseconds(1), [] { return Queued.load() > 0 || !Running.load(); });
+		}
+	}
+}
+
+void JobSystem::invokeTask(void *data, GLuint begin, GLuint end)
+{
+	std::function<void()> *task = static_cast<std::function<void()> *>(data);
+	(*task)();
+	delete task;
+}
@@ -0,0 +1,65 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "layer_cache.h"
+
+
+LayerCache::LayerCache()
+	: Enabled(GL_TRUE), Opaque(GL_FALSE), key(0), valid(GL_FALSE), framebuffer(0), viewport()
+{
+
+}
+
+GLboolean LayerCache::Begin(GLuint64 key)
+{
+	if (!this->Enabled)
+		return GL_TRUE;
+	// The layer has the size of the viewport it is drawn into, so it maps 1:1 onto its pixels
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &this->framebuffer);
+	glGetIntegerv(GL_VIEWPORT, this->viewport);
+	GLuint width = static_cast<GLuint>(this->viewport[2]), height = static_cast<GLuint>(this->viewport[3]);
+	if (this->valid && this->key == key && this->Target.Width == width && this->Target.Height == height)
+		return GL_FALSE;
+	if (this->Target.Width != width || this->Target.Height != height)
+		this->Target.Generate(width, height);
+	this->key = key;
+	this->valid = GL_TRUE;
+	this->Target.Bind();
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	return GL_TRUE;
+}
+
+void LayerCache::End()
+{
+	if (!this->Enabled)
+		return;
+	glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+	glViewport(this->viewport[0], this->viewport[1], this->viewport[2], this->viewport[3]);
+}
+
+void LayerCache::Draw(SpriteRenderer &renderer, GLfloat width, GLfloat height, glm::vec2 origin) const
+{
+	if (!this->Enabled || !this->valid)
+		return;
+	// The target's rows run bottom up, so the quad is mirrored vertically, which also flips its winding
+	GLboolean culling = glIsEnabled(GL_CULL_FACE), blending = glIsEnabled(GL_BLEND);
+	glDisable(GL_CULL_FACE);
+	if (this->Opaque)
+		glDisable(GL_BLEND);
+	renderer.DrawSprite(TextureView(this->Target.Color), origin + glm::vec2(0.0f, height), glm::vec2(width, -height));
+	if (culling)
+		glEnable(GL_CULL_FACE);
+	if (blending)
+		glEnable(GL_BLEND);
+}
+
+void LayerCache::Invalidate()
+{
+	this->valid = GL_FALSE;
+}
@@ -0,0 +1,170 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "level_generator.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "job_system.h"
+#include "random.h"
+
+
+namespace
+{
+	// Rows from one wall to the next in the walls pattern, and the width of a wall's gap as a share of the row
+	const GLuint  WALL_SPACING = 8;
+	const GLfloat WALL_GAP = 0.125f;
+	// Rows generated per job
+	const GLuint  ROWS_PER_JOB = 16;
+	// Every decision draws from its own stream, so changing one (say the density) leaves the others alone
+	enum Stream { STREAM_LAYOUT, STREAM_BRICK, STREAM_MAZE, STREAM_WALL };
+
+	GLuint64 draw(const LevelSpec &spec, Stream stream, GLuint64 index)
+	{
+		return Random::At(Random::At(spec.Seed, stream), index);
+	}
+
+	// Whether 24 of the random bits fall below probability
+	GLboolean chance(GLuint64 bits, GLfloat probability)
+	{
+		return static_cast<GLfloat>(bits >> 40) < probability * 16777216.0f;
+	}
+
+	// A solid or breakable brick, picked by the spec's solid ratio
+	GLuint brickAt(const LevelSpec &spec, GLuint64 index)
+	{
+		GLuint64 bits = draw(spec, STREAM_BRICK, index);
+		return chance(bits, spec.SolidRatio) ? 1 : 2 + static_cast<GLuint>(bits & 3);
+	}
+
+	// Binary tree maze: every cell opens towards either its northern or its western neighbour
+	// (cells of the first row always open west, those of the first column north), which
+	// connects all cells without having to remember any of them
+	GLboolean opensNorth(const LevelSpec &spec, GLuint cellX, GLuint cellY)
+	{
+		if (cellY == 0)
+			return GL_FALSE;
+		return cellX == 0 || (draw(spec, STREAM_MAZE, static_cast<GLuint64>(cellY) * spec.Columns + cellX) & 1);
+	}
+
+	GLboolean opensWest(const LevelSpec &spec, GLuint cellX, GLuint cellY)
+	{
+		if (cellX == 0)
+			return GL_FALSE;
+		return cellY == 0 || !(draw(spec, STREAM_MAZE, static_cast<GLuint64>(cellY) * spec.Columns + cellX) & 1);
+	}
+}
+
+
+GLboolean LevelGenerator::Validate(const LevelSpec &spec)
+{
+	if (spec.Columns < MIN_SIZE || spec.Columns > MAX_SIZE || spec.Rows < MIN_SIZE || spec.Rows > MAX_SIZE)
+	{
+		std::cout << "ERROR::LEVEL_GENERATOR: " << spec.Columns << "x" << spec.Rows << " is outside of "
+			<< MIN_SIZE << "x" << MIN_SIZE << " to " << MAX_SIZE << "x" << MAX_SIZE << std::endl;
+		return GL_FALSE;
+	}
+	return GL_TRUE;
+}
+
+GLboolean LevelGenerator::Generate(const LevelSpec &spec, std::vector<GLuint> &tiles)
+{
+	if (!Validate(spec))
+		return GL_FALSE;
+	tiles.resize(spec.Tiles());
+	GLuint *out = tiles.data();
+	JobSystem::ParallelFor(spec.Rows, ROWS_PER_JOB, [&spec, out](GLuint begin, GLuint end) {
+		for (GLuint y = begin; y < end; ++y)
+			GenerateRow(spec, y, out + static_cast<size_t>(y) * spec.Columns);
+	});
+	return GL_TRUE;
+}
+
+void LevelGenerator::GenerateRow(const LevelSpec &spec, GLuint row, GLuint *tiles)
+{
+	for (GLuint x = 0; x < spec.Columns; ++x)
+		tiles[x] = tileAt(spec, x, row);
+}
+
+GLboolean LevelGenerator::Generate(const LevelSpec &spec, GameLevel &level, GLuint levelWidth, GLuint levelHeight)
+{
+	if (!Generate(spec, level.Tiles))
+		return GL_FALSE;
+	level.Columns = spec.Columns;
+	level.Rows = spec.Rows;
+	level.Width = levelWidth;
+	level.Height = levelHeight;
+	return GL_TRUE;
+}
+
+const std::vector<DatasetLevel> &LevelGenerator::Dataset()
+{
+	// Fixed seeds: results of different commits stay comparable. Mazes have odd sizes so they are walled on all sides
+	static const std::vector<DatasetLevel> dataset = {
+		{ "noise-64x32",     LevelSpec(LEVEL_NOISE, 64, 32, 0.9f, 0.05f, 1) },
+		{ "maze-63x63",      LevelSpec(LEVEL_MAZE, 63, 63, 1.0f, 0.1f, 2) },
+		{ "walls-128x64",    LevelSpec(LEVEL_WALLS, 128, 64, 0.6f, 0.0f, 3) },
+		{ "noise-160x60",    LevelSpec(LEVEL_NOISE, 160, 60, 0.9f, 0.05f, 4) },
+		{ "noise-512x512",   LevelSpec(LEVEL_NOISE, 512, 512, 0.9f, 0.05f, 5) },
+		{ "maze-1023x1023",  LevelSpec(LEVEL_MAZE, 1023, 1023, 1.0f, 0.1f, 6) },
+		{ "walls-1024x1024", LevelSpec(LEVEL_WALLS, 1024, 1024, 0.6f, 0.0f, 7) },
+		{ "noise-4096x4096", LevelSpec(LEVEL_NOISE, 4096, 4096, 0.9f, 0.05f, 8) }
+	};
+	return dataset;
+}
+
+GLboolean LevelGenerator::ParsePattern(const std::string &name, LevelPattern &pattern)
+{
+	const LevelPattern patterns[] = { LEVEL_NOISE, LEVEL_MAZE, LEVEL_WALLS };
+	for (LevelPattern candidate : patterns)
+	{
+		if (name == PatternName(candidate))
+		{
+			pattern = candidate;
+			return GL_TRUE;
+		}
+	}
+	return GL_FALSE;
+}
+
+const char *LevelGenerator::PatternName(LevelPattern pattern)
+{
+	switch (pattern)
+	{
+	case LEVEL_MAZE:  return "maze";
+	case LEVEL_WALLS: return "walls";
+	default:          return "noise";
+	}
+}
+
+GLuint LevelGenerator::tileAt(const LevelSpec &spec, GLuint x, GLuint y)
+{
+	GLuint64 index = static_cast<GLuint64>(y) * spec.Columns + x;
+	if (spec.Pattern == LEVEL_MAZE)
+	{
+		// Cells sit at odd positions; the tiles between them are walls unless the maze opens them
+		GLboolean oddX = x & 1, oddY = y & 1;
+		GLboolean open = GL_FALSE;
+		if (oddX && oddY)
+			open = GL_TRUE;
+		else if (oddX && y + 1 < spec.Rows)
+			open = opensNorth(spec, x / 2, y / 2);
+		else if (oddY && x + 1 < spec.Columns)
+			open = opensWest(spec, x / 2, y / 2);
+		return open ? 0 : brickAt(spec, index);
+	}
+	if (spec.Pattern == LEVEL_WALLS && y % WALL_SPACING == WALL_SPACING - 1)
+	{
+		GLuint gap = std::max(1u, static_cast<GLuint>(spec.Columns * WALL_GAP));
+		GLuint start = static_cast<GLuint>(draw(spec, STREAM_WALL, y) % (spec.Columns - gap + 1));
+		return x >= start && x < start + gap ? 0 : 1;
+	}
+	// Noise, also filling the space between walls
+	return chance(draw(spec, STREAM_LAYOUT, index), spec.Density) ? brickAt(spec, index) : 0;
+}
@@ -0,0 +1,407 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+
+// Instantiate static constants
+const GLuint   Histogram::SUB_BUCKET_BITS;
+const GLuint   Histogram::SUB_BUCKETS;
+const GLuint   Histogram::MAX_BITS;
+const GLuint64 Histogram::MAX_VALUE;
+const GLuint   Histogram::BUCKETS;
+const GLuint   Metrics::MAX_COUNTERS;
+const GLuint   Metrics::MAX_GAUGES;
+const GLuint   Metrics::MAX_HISTOGRAMS;
+
+
+namespace
+{
+	typedef std::atomic<GLuint64> Cell;
+
+	// A histogram's storage within one thread's shard, allocated when the thread first records into it
+	struct HistogramShard {
+		Cell Counts[Histogram::BUCKETS];
+		Cell Sum;
+
+		HistogramShard() : Sum(0)
+		{
+			for (Cell &count : this->Counts)
+				count.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	// Everything one thread records. Only the owning thread writes, so its
+	// updates are plain load and store pairs; Collect reads concurrently.
+	struct Shard {
+		Cell                           Counters[Metrics::MAX_COUNTERS];
+		std::atomic<HistogramShard *>  Histograms[Metrics::MAX_HISTOGRAMS];
+		std::atomic<bool>              InUse;
+
+		Shard() : InUse(true)
+		{
+			for (Cell &counter : this->Counters)
+				counter.store(0, std::memory_order_relaxed);
+			for (std::atomic<HistogramShard *> &histogram : this->Histograms)
+				histogram.store(nullptr, std::memory_order_relaxed);
+		}
+	};
+
+	// Gives a thread's shard back for reuse once the thread exits; totals are cumulative, so a new owner simply continues them
+	struct ShardOwner {
+		Shard *Owned;
+
+		ShardOwner() : Owned(nullptr) { }
+		~ShardOwner() { if (this->Owned) this->Owned->InUse = false; }
+	};
+
+	// Registry state; the lock covers registration, the shard list and Collect
+	std::mutex                            RegistryLock;
+	std::vector<std::string>              CounterNames, GaugeNames, HistogramNames;
+	std::vector<Shard *>                  Shards;
+	std::atomic<GLint64>                  Gauges[Metrics::MAX_GAUGES];
+	thread_local ShardOwner               Owner;
+	// Cumulative totals at the previous Collect
+	std::vector<GLuint64>                 LastCounters;
+	std::vector<Histogram>                LastHistograms;
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now(), LastCollect = Start;
+	// Export thread
+	std::thread                           ExportThread;
+	std::mutex                            ExportLock;
+	std::condition_variable               ExportWake;
+	bool                                  ExportStop = false;
+
+	// Adds to a cell only the calling thread writes
+	inline void bump(Cell &cell, GLuint64 amount)
+	{
+		cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+	Shard *localShard()
+	{
+		if (Owner.Owned)
+			return Owner.Owned;
+		std::lock_guard<std::mutex> guard(RegistryLock);
+		for (Shard *shard : Shards)
+		{
+			if (!shard->InUse.load())
+			{
+				shard->InUse = true;
+				Owner.Owned = shard;
+				return shard;
+			}
+		}
+		Owner.Owned = new Shard();
+		Shards.push_back(Owner.Owned);
+		return Owner.Owned;
+	}
+
+	MetricId registerName(std::vector<std::string> &names, GLuint capacity, const std::string &name)
+	{
+		std::lock_guard<std::mutex> guard(RegistryLock);
+		std::vector<std::string>::iterator found = std::find(names.begin(), names.end(), name);
+		if (found != names.end())
+			return static_cast<MetricId>(found - names.begin());
+		if (names.size() >= capacity)
+		{
+			std::cout << "ERROR::METRICS: No room left for metric " << name << std::endl;
+			return INVALID_METRIC;
+		}
+		names.push_back(name);
+		return static_cast<MetricId>(names.size() - 1);
+	}
+
+	GLuint highestBit(GLuint64 value)
+	{
+#if defined(__GNUC__)
+		return 63 - __builtin_clzll(value);
+#else
+		GLuint bit = 0;
+		while (value >>= 1)
+			++bit;
+		return bit;
+#endif
+	}
+
+	// Shifts path.1 .. path.(maxFiles - 1) up by one, dropping the oldest, and moves path to path.1
+	void rotate(const std::string &path, GLuint maxFiles)
+	{
+		if (maxFiles == 0)
+		{
+			std::remove(path.c_str());
+			return;
+		}
+		std::remove((path + "." + std::to_string(maxFiles)).c_str());
+		for (GLuint i = maxFiles; i > 1; --i)
+			std::rename((path + "." + std::to_string(i - 1)).c_str(), (path + "." + std::to_string(i)).c_str());
+		std::rename(path.c_str(), (path + ".1").c_str());
+	}
+}
+
+
+void Histogram::Add(GLuint bucket, GLuint64 count, GLuint64 sum)
+{
+	this->Counts[bucket] += count;
+	this->Count += count;
+	this->Sum += sum;
+}
+
+void Histogram::Merge(const Histogram &other)
+{
+	for (GLuint i = 0; i < BUCKETS; ++i)
+		this->Counts[i] += other.Counts[i];
+	this->Count += other.Count;
+	this->Sum += other.Sum;
+}
+
+void Histogram::Subtract(const Histogram &earlier)
+{
+	for (GLuint i = 0; i < BUCKETS; ++i)
+		this->Counts[i] -= earlier.Counts[i];
+	this->Count -= earlier.Count;
+	this->Sum -= earlier.Sum;
+}
+
+void Histogram::Reset()
+{
+	std::memset(this->Counts, 0, sizeof(this->Counts));
+	this->Count = 0;
+	this->Sum = 0;
+}
+
+GLuint64 Histogram::Percentile(GLdouble fraction) const
+{
+	if (this->Count == 0)
+		return 0;
+	GLuint64 rank = static_cast<GLuint64>(fraction * this->Count + 0.5);
+	rank = std::max<GLuint64>(1, std::min(rank, this->Count));
+	GLuint64 seen = 0;
+	for (GLuint i = 0; i < BUCKETS; ++i)
+	{
+		seen += this->Counts[i];
+		if (seen >= rank)
+			return HighestOf(i);
+	}
+	return this->Max();
+}
+
+GLuint64 Histogram::Min() const
+{
+	for (GLuint i = 0; i < BUCKETS; ++i)
+		if (this->Counts[i] > 0)
+			return LowestOf(i);
+	return 0;
+}
+
+GLuint64 Histogram::Max() const
+{
+	for (GLuint i = BUCKETS; i > 0; --i)
+		if (this->Counts[i - 1] > 0)
+			return HighestOf(i - 1);
+	return 0;
+}
+
+GLuint Histogram::BucketOf(GLuint64 value)
+{
+	value = std::min(value, MAX_VALUE);
+	if (value < 2 * SUB_BUCKETS)
+		return static_cast<GLuint>(value);
+	GLuint shift = highestBit(value) - SUB_BUCKET_BITS;
+	return 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + static_cast<GLuint>((value >> shift) - SUB_BUCKETS);
+}
+
+GLuint64 Histogram::LowestOf(GLuint bucket)
+{
+	if (bucket < 2 * SUB_BUCKETS)
+		return bucket;
+	GLuint shift = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+	return static_cast<GLuint64>((bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+
+GLuint64 Histogram::HighestOf(GLuint bucket)
+{
+	if (bucket < 2 * SUB_BUCKETS)
+		return bucket;
+	GLuint shift = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+	return LowestOf(bucket) + (1ull << shift) - 1;
+}
+
+
+void MetricsSnapshot::WriteJson(std::ostream &out) const
+{
+	std::ios::fmtflags flags = out.flags();
+	std::streamsize precision = out.precision();
+	out << std::fixed << std::setprecision(3) << "{\"time_s\": " << this->Time << ", \"interval_s\": " << this->Interval << ", \"counters\": {";
+	for (size_t i = 0; i < this->Counters.size(); ++i)
+		out << (i > 0 ? ", " : "") << "\"" << this->Counters[i].first << "\": " << this->Counters[i].second;
+	out << "}, \"gauges\": {";
+	for (size_t i = 0; i < this->Gauges.size(); ++i)
+		out << (i > 0 ? ", " : "") << "\"" << this->Gauges[i].first << "\": " << this->Gauges[i].second;
+	out << "}, \"histograms\": {";
+	for (size_t i = 0; i < this->Histograms.size(); ++i)
+	{
+		const Histogram &histogram = this->Histograms[i].second;
+		out << (i > 0 ? ", " : "") << "\"" << this->Histograms[i].first << "\": {\"count\": " << histogram.Count
+			<< ", \"mean\": " << histogram.Mean() << ", \"min\": " << histogram.Min() << ", \"p50\": " << histogram.Percentile(0.5)
+			<< ", \"p90\": " << histogram.Percentile(0.9) << ", \"p99\": " << histogram.Percentile(0.99)
+			<< ", \"p999\": " << histogram.Percentile(0.999) << ", \"max\": " << histogram.Max() << "}";
+	}
+	out << "}}";
+	out.flags(flags);
+	out.precision(precision);
+}
+
+
+MetricId Metrics::RegisterCounter(const std::string &name)
+{
+	return registerName(CounterNames, MAX_COUNTERS, name);
+}
+
+MetricId Metrics::RegisterGauge(const std::string &name)
+{
+	return registerName(GaugeNames, MAX_GAUGES, name);
+}
+
+MetricId Metrics::RegisterHistogram(const std::string &name)
+{
+	return registerName(HistogramNames, MAX_HISTOGRAMS, name);
+}
+
+void Metrics::Add(MetricId counter, GLuint64 amount)
+{
+	if (counter < MAX_COUNTERS)
+		bump(localShard()->Counters[counter], amount);
+}
+
+void Metrics::Set(MetricId gauge, GLint64 value)
+{
+	if (gauge < MAX_GAUGES)
+		Gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+void Metrics::Record(MetricId histogram, GLuint64 value)
+{
+	if (histogram >= MAX_HISTOGRAMS)
+		return;
+	Shard *shard = localShard();
+	HistogramShard *storage = shard->Histograms[histogram].load(std::memory_order_relaxed);
+	if (!storage)
+	{
+		storage = new HistogramShard();
+		shard->Histograms[histogram].store(storage, std::memory_order_release);
+	}
+	bump(storage->Counts[Histogram::BucketOf(value)], 1);
+	bump(storage->Sum, value);
+}
+
+MetricsSnapshot Metrics::Collect()
+{
+	std::lock_guard<std::mutex> guard(RegistryLock);
+	MetricsSnapshot snapshot;
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	snapshot.Time = std::chrono::duration<GLdouble>(now - Start).count();
+	snapshot.Interval = std::chrono::duration<GLdouble>(now - LastCollect).count();
+	LastCollect = now;
+	// Shards only ever grow, so each interval is the difference to the totals of the previous Collect
+	LastCounters.resize(CounterNames.size(), 0);
+	for (GLuint i = 0; i < CounterNames.size(); ++i)
+	{
+		GLuint64 total = 0;
+		for (const Shard *shard : Shards)
+			total += shard->Counters[i].load(std::memory_order_relaxed);
+		snapshot.Counters.push_back(std::make_pair(CounterNames[i], total - LastCounters[i]));
+		LastCounters[i] = total;
+	}
+	for (GLuint i = 0; i < GaugeNames.size(); ++i)
+		snapshot.Gauges.push_back(std::make_pair(GaugeNames[i], Gauges[i].load(std::memory_order_relaxed)));
+	LastHistograms.resize(HistogramNames.size());
+	for (GLuint i = 0; i < HistogramNames.size(); ++i)
+	{
+		snapshot.Histograms.push_back(std::make_pair(HistogramNames[i], Histogram()));
+		Histogram &interval = snapshot.Histograms.back().second;
+		for (const Shard *shard : Shards)
+		{
+			const HistogramShard *storage = shard->Histograms[i].load(std::memory_order_acquire);
+			if (!storage)
+				continue;
+			for (GLuint bucket = 0; bucket < Histogram::BUCKETS; ++bucket)
+				interval.Add(bucket, storage->Counts[bucket].load(std::memory_order_relaxed), 0);
+			interval.Sum += storage->Sum.load(std::memory_order_relaxed);
+		}
+		Histogram total = interval;
+		interval.Subtract(LastHistograms[i]);
+		LastHistograms[i] = total;
+	}
+	return snapshot;
+}
+
+GLboolean Metrics::StartExport(const std::string &path, GLfloat interval, GLuint64 maxFileBytes, GLuint maxFiles)
+{
+	StopExport();
+	if (!std::ofstream(path.c_str(), std::ios::app))
+	{
+		std::cout << "ERROR::METRICS: Could not open " << path << " for writing" << std::endl;
+		return GL_FALSE;
+	}
+	// The first exported interval starts now
+	Collect();
+	ExportStop = false;
+	ExportThread = std::thread(&Metrics::exportLoop, path, interval, maxFileBytes, maxFiles);
+	return GL_TRUE;
+}
+
+void Metrics::StopExport()
+{
+	if (!ExportThread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(ExportLock);
+		ExportStop = true;
+	}
+	ExportWake.notify_all();
+	ExportThread.join();
+}
+
+void Metrics::exportLoop(std::string path, GLfloat interval, GLuint64 maxFileBytes, GLuint maxFiles)
+{
+	GLuint64 written = static_cast<GLuint64>(std::max<std::streamoff>(0, std::ifstream(path.c_str(), std::ios::ate | std::ios::binary).tellg()));
+	std::ofstream out(path.c_str(), std::ios::app);
+	std::unique_lock<std::mutex> lock(ExportLock);
+	GLboolean stopping = GL_FALSE;
+	while (!stopping)
+	{
+		stopping = ExportWake.wait_for(lock, std::chrono::duration<GLfloat>(interval), [] { return ExportStop; });
+		lock.unlock();
+		std::ostringstream line;
+		Collect().WriteJson(line);
+		line << '\n';
+		std::string text = line.str();
+		if (written > 0 && written + text.size() > maxFileBytes)
+		{
+			out.close();
+			rotate(path, maxFiles);
+			out.open(path.c_str(), std::ios::trunc);
+			written = 0;
+		}
+		out << text << std::flush;
+		written += text.size();
+		lock.lock();
+	}
+}
@@ -0,0 +1,143 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "offscreen_context.h"
+
+#include <iostream>
+
+#ifdef LITTLEGAME_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+
+OffscreenContext::OffscreenContext()
+	: display(nullptr), surface(nullptr), context(nullptr), window(nullptr)
+{
+
+}
+
+OffscreenContext::~OffscreenContext()
+{
+	this->Destroy();
+}
+
+#ifdef LITTLEGAME_EGL
+GLboolean OffscreenContext::Create(GLuint width, GLuint height)
+{
+	// Prefer Mesa's surfaceless platform, it needs neither a window system nor a GPU
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		std::cout << "ERROR::OFFSCREEN: No EGL display available" << std::endl;
+		return GL_FALSE;
+	}
+	this->display = display;
+	const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8, EGL_NONE };
+	EGLConfig config;
+	EGLint configs = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0)
+	{
+		std::cout << "ERROR::OFFSCREEN: No EGL config supports desktop OpenGL" << std::endl;
+		this->Destroy();
+		return GL_FALSE;
+	}
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::cout << "ERROR::OFFSCREEN: Failed to create an OpenGL 3.3 core context" << std::endl;
+		this->Destroy();
+		return GL_FALSE;
+	}
+	this->context = context;
+	// Without EGL_KHR_surfaceless_context a small pbuffer has to be current alongside
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, static_cast<EGLint>(width), EGL_HEIGHT, static_cast<EGLint>(height), EGL_NONE };
+		EGLSurface surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+		if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context))
+		{
+			std::cout << "ERROR::OFFSCREEN: Failed to make the EGL context current" << std::endl;
+			this->Destroy();
+			return GL_FALSE;
+		}
+		this->surface = surface;
+	}
+	glewExperimental = GL_TRUE;
+	glewInit();
+	glGetError(); // Call it once to catch glewInit() bug, all other errors are now from our application.
+	return GL_TRUE;
+}
+
+void OffscreenContext::Destroy()
+{
+	if (!this->display)
+		return;
+	eglMakeCurrent(this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (this->surface)
+		eglDestroySurface(this->display, this->surface);
+	if (this->context)
+		eglDestroyContext(this->display, this->context);
+	eglTerminate(this->display);
+	this->display = this->surface = this->context = nullptr;
+}
+#else
+GLboolean OffscreenContext::Create(GLuint width, GLuint height)
+{
+	if (!glfwInit())
+	{
+		std::cout << "ERROR::OFFSCREEN: Failed to initialize GLFW" << std::endl;
+		return GL_FALSE;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	GLFWwindow *window = glfwCreateWindow(width, height, "Breakout (offscreen)", nullptr, nullptr);
+	if (!window)
+	{
+		std::cout << "ERROR::OFFSCREEN: Failed to create a hidden GLFW window" << std::endl;
+		glfwTerminate();
+		return GL_FALSE;
+	}
+	this->window = window;
+	glfwMakeContextCurrent(window);
+	glewExperimental = GL_TRUE;
+	glewInit();
+	glGetError(); // Call it once to catch glewInit() bug, all other errors are now from our application.
+	return GL_TRUE;
+}
+
+void OffscreenContext::Destroy()
+{
+	if (!this->window)
+		return;
+	glfwDestroyWindow(static_cast<GLFWwindow *>(this->window));
+	glfwTerminate();
+	this->window = nullptr;
+}
+#endif
+
+std::string OffscreenContext::Renderer() const
+{
+	const GLubyte *renderer = glGetString(GL_RENDERER);
+	return renderer ? reinterpret_cast<const char *>(renderer) : "unknown";
+}
@@ -8,50 +8,112 @@
 ******************************************************************/
 #include "particle_generator.h"
 
-ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, GLuint amount)
-	: shader(shader), texture(texture), amount(amount)
+#include <algorithm>
+#include <cassert>
+
+#include "job_system.h"
+#include "render_stats.h"
+
+
+// Number of particles per update job. Fixed, so that how respawns are
+// distributed never depends on the number of threads.
+const GLuint PARTICLE_CHUNK_SIZE = 4096;
+
+ParticleGenerator::ParticleGenerator(Shader &shader, TextureView texture, GLuint amount, GLuint64 seed)
+	: amount(amount), seed(seed), spawned(0), recycleCursor(0), shader(&shader), texture(texture)
 {
-	this->init();
+	// Create this->amount default particle instances
+	this->particles.resize(this->amount);
+	GLuint chunks = (this->amount + PARTICLE_CHUNK_SIZE - 1) / PARTICLE_CHUNK_SIZE;
+	this->chunkSpawns.resize(chunks);
+	this->chunkFirst.resize(chunks);
 }
 
-// Particles->Update(dt, *Ball, 2, glm::vec2(Ball->Radius / 2));
+void ParticleGenerator::Emit(glm::vec2 position, glm::vec2 velocity, GLuint newParticles, glm::vec2 offset)
+{
+	if (newParticles == 0)
+		return;
+	ParticleEmission emission;
+	emission.Position = position;
+	emission.Velocity = velocity;
+	emission.Offset = offset;
+	emission.Count = newParticles;
+	this->emissions.push_back(emission);
+	this->emissionEnds.push_back((this->emissionEnds.empty() ? 0 : this->emissionEnds.back()) + newParticles);
+}
 
-void ParticleGenerator::Update(GLfloat dt, GameObject &object, GLuint newParticles, glm::vec2 offset)
+void ParticleGenerator::Update(GLfloat dt)
 {
-	// Add new particles 
-	for (GLuint i = 0; i < newParticles; ++i)
+	GLuint chunks = static_cast<GLuint>(this->chunkSpawns.size());
+	GLuint requested = this->emissionEnds.empty() || this->amount == 0 ? 0 : this->emissionEnds.back();
+	// Find out how many dead particles every chunk has to offer
+	if (requested > 0)
 	{
-		int unusedParticle = this->firstUnusedParticle();
-		this->respawnParticle(this->particles[unusedParticle], object, offset);
+		JobSystem::ParallelFor(chunks, 1, [this](GLuint begin, GLuint end) {
+			for (GLuint chunk = begin; chunk < end; ++chunk)
+				this->countDead(chunk);
+		});
 	}
-	// Update all particles
-	for (GLuint i = 0; i < this->amount; ++i)
+	// Hand out the new particles to chunks in order, so each chunk knows
+	// which slice of the random stream it owns and no locking is needed
+	GLuint assigned = 0, dead = 0;
+	for (GLuint chunk = 0; chunk < chunks; ++chunk)
 	{
-		Particle &p = this->particles[i];
-		p.Life -= dt; // reduce life
-		if (p.Life > 0.0f)
-		{	// particle is alive, thus update
-			p.Position -= p.Velocity * dt;
-			p.Color.a -= dt * 2.5;
-		}
+		GLuint take = std::min(this->chunkSpawns[chunk], requested - assigned);
+		dead += this->chunkSpawns[chunk];
+		this->chunkFirst[chunk] = assigned;
+		this->chunkSpawns[chunk] = take;
+		assigned += take;
+	}
+	// All particles are taken, override live ones round robin (note that if it repeatedly hits this case, more particles should be reserved);
+	// dead ones are skipped, they already went to the chunks
+	for (; assigned < requested && dead < this->amount; ++assigned)
+	{
+		while (this->particles[this->recycleCursor].Life <= 0.0f)
+			this->recycleCursor = (this->recycleCursor + 1) % this->amount;
+		this->respawnParticle(this->particles[this->recycleCursor], assigned);
+		this->recycleCursor = (this->recycleCursor + 1) % this->amount;
 	}
+	// Spawn and update all particles
+	JobSystem::ParallelFor(chunks, 1, [this, dt](GLuint begin, GLuint end) {
+		for (GLuint chunk = begin; chunk < end; ++chunk)
+			this->updateChunk(chunk, dt);
+	});
+	this->spawned += requested;
+	this->emissions.clear();
+	this->emissionEnds.clear();
+}
+
+void ParticleGenerator::SetProjection(const glm::mat4 &projection)
+{
+	// Headless games hand in a shader that was never compiled
+	if (this->shader->Program.ID())
+		this->shader->SetMatrix4("projection", projection, GL_TRUE);
 }
 
 // Render all particles
 void ParticleGenerator::Draw()
 {
+	this->Draw(this->particles);
+}
+
+void ParticleGenerator::Draw(const std::vector<Particle> &particles)
+{
+	if (!this->VAO.ID())
+		this->init();
 	// Use additive blending to give it a 'glow' effect
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-	this->shader.Use();
-	for (Particle particle : this->particles)
+	this->shader->Use();
+	for (const Particle &particle : particles)
 	{
 		if (particle.Life > 0.0f)
 		{
-			this->shader.SetVector2f("offset", particle.Position);
-			this->shader.SetVector4f("color", particle.Color);
+			this->shader->SetVector2f("offset", particle.Position);
+			this->shader->SetVector4f("color", particle.Color);
 			this->texture.Bind();
-			glBindVertexArray(this->VAO);
+			glBindVertexArray(this->VAO.ID());
 			glDrawArrays(GL_TRIANGLES, 0, 6);
+			RenderStats::Draw(6);
 			glBindVertexArray(0);
 		}
 	}
@@ -59,10 +121,39 @@ void ParticleGenerator::Draw()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
+GLuint ParticleGenerator::LiveCount() const
+{
+	GLuint live = 0;
+	for (const Particle &particle : this->particles)
+		live += particle.Life > 0.0f;
+	return live;
+}
+
+void ParticleGenerator::Seed(GLuint64 seed)
+{
+	this->seed = seed;
+	this->spawned = 0;
+	this->recycleCursor = 0;
+}
+
+void ParticleGenerator::SaveState(StateWriter &writer) const
+{
+	writer.Write(this->seed);
+	writer.Write(this->spawned);
+	writer.Write(this->recycleCursor);
+}
+
+GLboolean ParticleGenerator::LoadState(StateReader &reader)
+{
+	reader.Read(this->seed);
+	reader.Read(this->spawned);
+	reader.Read(this->recycleCursor);
+	return !reader.Failed();
+}
+
 void ParticleGenerator::init()
 {
 	// Set up mesh and attribute properties
-	GLuint VBO;
 	GLfloat particle_quad[] = {
 		0.0f, 1.0f, 0.0f, 1.0f,
 		1.0f, 0.0f, 1.0f, 0.0f,
@@ -72,53 +163,65 @@ void ParticleGenerator::init()
 		1.0f, 1.0f, 1.0f, 1.0f,
 		1.0f, 0.0f, 1.0f, 0.0f
 	};
-	glGenVertexArrays(1, &this->VAO);
-	glGenBuffers(1, &VBO);
-	glBindVertexArray(this->VAO);
+	glBindVertexArray(this->VAO.Get());
 	// Fill mesh buffer
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, this->VBO.Get());
 	glBufferData(GL_ARRAY_BUFFER, sizeof(particle_quad), particle_quad, GL_STATIC_DRAW);
 	// Set mesh attributes
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
 	glBindVertexArray(0);
+}
 
-	// Create this->amount default particle instances
-	for (GLuint i = 0; i < this->amount; ++i)
-		this->particles.push_back(Particle());
+void ParticleGenerator::countDead(GLuint chunk)
+{
+	GLuint begin = chunk * PARTICLE_CHUNK_SIZE;
+	GLuint end = std::min(this->amount, begin + PARTICLE_CHUNK_SIZE);
+	GLuint dead = 0;
+	for (GLuint i = begin; i < end; ++i)
+		dead += this->particles[i].Life <= 0.0f;
+	this->chunkSpawns[chunk] = dead;
 }
 
-// Stores the index of the last particle used (for quick access to next dead particle)
-GLuint lastUsedParticle = 0;
-GLuint ParticleGenerator::firstUnusedParticle()
+void ParticleGenerator::updateChunk(GLuint chunk, GLfloat dt)
 {
-	// First search from last used particle, this will usually return almost instantly
-	for (GLuint i = lastUsedParticle; i < this->amount; ++i) {
-		if (this->particles[i].Life <= 0.0f) {
-			lastUsedParticle = i;
-			return i;
+	GLuint begin = chunk * PARTICLE_CHUNK_SIZE;
+	GLuint end = std::min(this->amount, begin + PARTICLE_CHUNK_SIZE);
+	GLuint spawnIndex = this->chunkFirst[chunk];
+	GLuint remaining = this->chunkSpawns[chunk];
+	for (GLuint i = begin; i < end; ++i)
+	{
+		Particle &p = this->particles[i];
+		// Add new particles in the first dead slots of this chunk
+		if (remaining > 0 && p.Life <= 0.0f)
+		{
+			this->respawnParticle(p, spawnIndex++);
+			--remaining;
 		}
-	}
-	// Otherwise, do a linear search
-	for (GLuint i = 0; i < lastUsedParticle; ++i) {
-		if (this->particles[i].Life <= 0.0f) {
-			lastUsedParticle = i;
-			return i;
+		p.Life -= dt; // reduce life
+		if (p.Life > 0.0f)
+		{	// particle is alive, thus update
+			p.Position -= p.Velocity * dt;
+			p.Color.a -= dt * 2.5;
 		}
 	}
-	// All particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
-	lastUsedParticle = 0;
-	return 0;
+	// Recycling left the dead slots countDead found to the chunk
+	assert(remaining == 0);
 }
 
-void ParticleGenerator::respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset)
+void ParticleGenerator::respawnParticle(Particle &particle, GLuint spawnIndex)
 {
-	GLfloat random = ((rand() % 100) - 50) / 10.0f;
-	GLfloat rColor1 = 0.5 + ((rand() % 100) / 100.0f);
-	GLfloat rColor2 = 0.6 + ((rand() % 100) / 100.0f);
-	GLfloat rColor3 = 0.4 + ((rand() % 100) / 100.0f);
-	particle.Position = object.Position + random + offset;
+	// Look up the emission this spawn belongs to
+	GLuint emission = static_cast<GLuint>(std::upper_bound(this->emissionEnds.begin(), this->emissionEnds.end(), spawnIndex) - this->emissionEnds.begin());
+	const ParticleEmission &source = this->emissions[emission];
+	// Every spawn owns one position of the random stream, whichever thread runs it
+	GLuint64 bits = Random::At(this->seed, this->spawned + spawnIndex);
+	GLfloat random = (static_cast<GLint>((bits & 0xFFFF) % 100) - 50) / 10.0f;
+	GLfloat rColor1 = 0.5f + (((bits >> 16) & 0xFFFF) % 100) / 100.0f;
+	GLfloat rColor2 = 0.6f + (((bits >> 32) & 0xFFFF) % 100) / 100.0f;
+	GLfloat rColor3 = 0.4f + (((bits >> 48) & 0xFFFF) % 100) / 100.0f;
+	particle.Position = source.Position + random + source.Offset;
 	particle.Color = glm::vec4(rColor1, rColor2, rColor3, 1.0f);
 	particle.Life = 1.0f;
-	particle.Velocity = object.Velocity * 0.1f;
+	particle.Velocity = source.Velocity * 0.1f;
 }
\ No newline at end of file
@@ -0,0 +1,288 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "png_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "stb_image.h"
+
+
+namespace
+{
+	// Sliding window and match limits of deflate
+	const GLuint WINDOW_SIZE = 32768;
+	const GLuint MIN_MATCH = 3, MAX_MATCH = 258;
+	// Hash chain positions tried per match; more compresses better but slower
+	const GLuint MAX_CHAIN = 32;
+	const GLuint HASH_BITS = 15;
+
+	const GLushort LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const GLubyte  LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const GLushort DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const GLubyte  DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	// Writes a little-endian bit stream as deflate expects it
+	struct BitWriter {
+		std::vector<unsigned char> &Out;
+		GLuint                      Buffer, Count;
+
+		BitWriter(std::vector<unsigned char> &out) : Out(out), Buffer(0), Count(0) { }
+		void Bits(GLuint value, GLuint count)
+		{
+			this->Buffer |= value << this->Count;
+			this->Count += count;
+			while (this->Count >= 8)
+			{
+				this->Out.push_back(static_cast<unsigned char>(this->Buffer));
+				this->Buffer >>= 8;
+				this->Count -= 8;
+			}
+		}
+		// Huffman codes are stored most significant bit first
+		void Code(GLuint code, GLuint length)
+		{
+			GLuint reversed = 0;
+			for (GLuint i = 0; i < length; ++i)
+				reversed |= ((code >> i) & 1) << (length - 1 - i);
+			this->Bits(reversed, length);
+		}
+		void Flush()
+		{
+			if (this->Count > 0)
+				this->Out.push_back(static_cast<unsigned char>(this->Buffer));
+			this->Buffer = this->Count = 0;
+		}
+	};
+
+	// Fixed Huffman code of a literal/length symbol
+	void writeSymbol(BitWriter &bits, GLuint symbol)
+	{
+		if (symbol < 144)
+			bits.Code(0x30 + symbol, 8);
+		else if (symbol < 256)
+			bits.Code(0x190 + symbol - 144, 9);
+		else if (symbol < 280)
+			bits.Code(symbol - 256, 7);
+		else
+			bits.Code(0xC0 + symbol - 280, 8);
+	}
+
+	void writeMatch(BitWriter &bits, GLuint length, GLuint distance)
+	{
+		GLuint code = 28;
+		while (LENGTH_BASE[code] > length)
+			--code;
+		writeSymbol(bits, 257 + code);
+		bits.Bits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+		code = 29;
+		while (DISTANCE_BASE[code] > distance)
+			--code;
+		bits.Code(code, 5);
+		bits.Bits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+	}
+
+	GLuint hash3(const unsigned char *p)
+	{
+		return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	// Paeth predictor of the PNG filters
+	GLint paeth(GLint a, GLint b, GLint c)
+	{
+		GLint p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+		return pb <= pc ? b : c;
+	}
+}
+
+
+GLboolean PngImage::Write(const std::string &file, GLuint width, GLuint height, GLuint channels, const std::vector<unsigned char> &pixels)
+{
+	static const unsigned char COLOR_TYPES[4] = { 0, 4, 2, 6 };
+	if (channels < 1 || channels > 4 || pixels.size() < static_cast<size_t>(width) * height * channels)
+	{
+		std::cout << "ERROR::PNG: Invalid image for " << file << std::endl;
+		return GL_FALSE;
+	}
+	// Filter each row with whichever of the five PNG filters gives the smallest absolute sum
+	size_t stride = static_cast<size_t>(width) * channels;
+	std::vector<unsigned char> filtered;
+	filtered.reserve((stride + 1) * height);
+	std::vector<unsigned char> candidate(stride), best(stride);
+	std::vector<unsigned char> zero(stride, 0);
+	for (GLuint y = 0; y < height; ++y)
+	{
+		const unsigned char *row = &pixels[y * stride];
+		const unsigned char *above = y > 0 ? &pixels[(y - 1) * stride] : &zero[0];
+		GLuint bestSum = 0xFFFFFFFF;
+		unsigned char bestFilter = 0;
+		for (unsigned char filter = 0; filter < 5; ++filter)
+		{
+			GLuint sum = 0;
+			for (size_t x = 0; x < stride; ++x)
+			{
+				GLint left = x >= channels ? row[x - channels] : 0;
+				GLint upLeft = x >= channels ? above[x - channels] : 0;
+				GLint predicted = 0;
+				switch (filter)
+				{
+				case 1: predicted = left; break;
+				case 2: predicted = above[x]; break;
+				case 3: predicted = (left + above[x]) / 2; break;
+				case 4: predicted = paeth(left, above[x], upLeft); break;
+				}
+				candidate[x] = static_cast<unsigned char>(row[x] - predicted);
+				sum += candidate[x] < 128 ? candidate[x] : 256 - candidate[x];
+			}
+			if (sum < bestSum)
+			{
+				bestSum = sum;
+				bestFilter = filter;
+				best.swap(candidate);
+			}
+		}
+		filtered.push_back(bestFilter);
+		filtered.insert(filtered.end(), best.begin(), best.end());
+	}
+
+	std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> header = {
+		static_cast<unsigned char>(width >> 24), static_cast<unsigned char>(width >> 16), static_cast<unsigned char>(width >> 8), static_cast<unsigned char>(width),
+		static_cast<unsigned char>(height >> 24), static_cast<unsigned char>(height >> 16), static_cast<unsigned char>(height >> 8), static_cast<unsigned char>(height),
+		8, COLOR_TYPES[channels - 1], 0, 0, 0
+	};
+	writeChunk(png, "IHDR", header);
+	std::vector<unsigned char> data;
+	deflate(filtered, data);
+	writeChunk(png, "IDAT", data);
+	writeChunk(png, "IEND", std::vector<unsigned char>());
+
+	std::ofstream out(file.c_str(), std::ios::binary);
+	out.write(reinterpret_cast<const char *>(&png[0]), png.size());
+	if (!out)
+	{
+		std::cout << "ERROR::PNG: Failed to write " << file << std::endl;
+		return GL_FALSE;
+	}
+	return GL_TRUE;
+}
+
+GLboolean PngImage::Read(const std::string &file, GLuint &width, GLuint &height, GLuint channels, std::vector<unsigned char> &pixels)
+{
+	int w, h, n;
+	unsigned char *image = stbi_load(file.c_str(), &w, &h, &n, channels);
+	if (!image)
+		return GL_FALSE;
+	width = w;
+	height = h;
+	pixels.assign(image, image + static_cast<size_t>(w) * h * channels);
+	stbi_image_free(image);
+	return GL_TRUE;
+}
+
+void PngImage::deflate(const std::vector<unsigned char> &data, std::vector<unsigned char> &out)
+{
+	// zlib header: deflate with a 32K window, no preset dictionary
+	out.push_back(0x78);
+	out.push_back(0x01);
+	BitWriter bits(out);
+	// A single final block using the fixed Huffman codes
+	bits.Bits(1, 1);
+	bits.Bits(1, 2);
+	std::vector<GLint> head(1 << HASH_BITS, -1), previous(WINDOW_SIZE, -1);
+	GLuint size = static_cast<GLuint>(data.size());
+	GLuint position = 0;
+	while (position < size)
+	{
+		GLuint bestLength = 0, bestDistance = 0;
+		if (position + MIN_MATCH <= size)
+		{
+			GLuint hash = hash3(&data[position]);
+			GLuint limit = std::min(MAX_MATCH, size - position);
+			GLint candidate = head[hash];
+			for (GLuint chain = 0; chain < MAX_CHAIN && candidate >= 0 && position - candidate <= WINDOW_SIZE; ++chain)
+			{
+				GLuint length = 0;
+				while (length < limit && data[candidate + length] == data[position + length])
+					++length;
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestDistance = position - candidate;
+					if (length == limit)
+						break;
+				}
+				candidate = previous[candidate % WINDOW_SIZE];
+			}
+		}
+		GLuint advance = bestLength >= MIN_MATCH ? bestLength : 1;
+		if (bestLength >= MIN_MATCH)
+			writeMatch(bits, bestLength, bestDistance);
+		else
+			writeSymbol(bits, data[position]);
+		// Insert every position covered into the hash chains
+		for (GLuint end = position + advance; position < end; ++position)
+			if (position + MIN_MATCH <= size)
+			{
+				GLuint hash = hash3(&data[position]);
+				previous[position % WINDOW_SIZE] = head[hash];
+				head[hash] = position;
+			}
+	}
+	writeSymbol(bits, 256);
+	bits.Flush();
+	// Adler-32 of the uncompressed data, big-endian
+	GLuint a = 1, b = 0;
+	for (unsigned char byte : data)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	GLuint adler = (b << 16) | a;
+	for (GLint shift = 24; shift >= 0; shift -= 8)
+		out.push_back(static_cast<unsigned char>(adler >> shift));
+}
+
+void PngImage::writeChunk(std::vector<unsigned char> &out, const char *type, const std::vector<unsigned char> &data)
+{
+	GLuint length = static_cast<GLuint>(data.size());
+	for (GLint shift = 24; shift >= 0; shift -= 8)
+		out.push_back(static_cast<unsigned char>(length >> shift));
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	GLuint checksum = crc(&out[start], out.size() - start);
+	for (GLint shift = 24; shift >= 0; shift -= 8)
+		out.push_back(static_cast<unsigned char>(checksum >> shift));
+}
+
+GLuint PngImage::crc(const unsigned char *data, size_t length, GLuint crc)
+{
+	static GLuint table[256];
+	static GLboolean initialized = GL_FALSE;
+	if (!initialized)
+	{
+		for (GLuint n = 0; n < 256; ++n)
+		{
+			GLuint c = n;
+			for (GLuint k = 0; k < 8; ++k)
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+		initialized = GL_TRUE;
+	}
+	crc = ~crc;
+	for (size_t i = 0; i < length; ++i)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
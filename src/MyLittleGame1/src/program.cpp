@@ -10,12 +10,28 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#include "alloc_tracker.h"
+#include "autopilot.h"
+#include "frame_pacer.h"
 #include "game.h"
+#include "input_recording.h"
+#include "job_system.h"
+#include "metrics.h"
+#include "resolution_scaler.h"
 #include "resource_manager.h"
+#include "simulation_thread.h"
 
 
 // GLFW function declerations
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
+void refresh_callback(GLFWwindow* window);
+void focus_callback(GLFWwindow* window, int focused);
 
 // The Width of the screen
 const GLuint SCREEN_WIDTH = 800;
@@ -23,9 +39,113 @@ const GLuint SCREEN_WIDTH = 800;
 const GLuint SCREEN_HEIGHT = 600;
 
 Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
+// Key events on their way from the GLFW callbacks to the simulation ticks
+InputQueue Input;
+// Key state as the callbacks saw it last, for late input sampling while the simulation has its own thread
+GLboolean KeysDown[1024];
+
+// Longest time an idle loop blocks waiting for events, in seconds
+const GLdouble IDLE_WAKEUP = 0.25;
+// Set by events that need the window redrawn while the loop is idle
+GLboolean RedrawRequested = GL_TRUE;
+
+// Whether there is nothing to play: the game is not active, or the window is in the background
+GLboolean isIdle(GLFWwindow *window, GLuint state)
+{
+	return state != GAME_ACTIVE || !glfwGetWindowAttrib(window, GLFW_FOCUSED) || glfwGetWindowAttrib(window, GLFW_ICONIFIED);
+}
+
+// Blocks until an event arrives (GLFW before 3.2 cannot time out, but every event that matters wakes it)
+void waitEvents()
+{
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 2)
+	glfwWaitEventsTimeout(IDLE_WAKEUP);
+#else
+	glfwWaitEvents();
+#endif
+}
+
+// Draws the snapshot, or the game itself if there is none, through the resolution scaler if there is one;
+// workTime is how long the last frame kept the loop busy
+void renderFrame(ResolutionScaler *scaler, GLfloat workTime, const RenderSnapshot *snapshot)
+{
+	if (scaler)
+		scaler->Begin();
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	if (snapshot)
+		Breakout.Render(*snapshot);
+	else
+		Breakout.Render();
+	if (scaler)
+		scaler->End(workTime);
+}
 
 int main(int argc, char *argv[])
 {
+	// --record <file> saves the session's input for littleGame_replay
+	const char *recordFile = nullptr;
+	for (int i = 1; i + 1 < argc; ++i)
+		if (std::strcmp(argv[i], "--record") == 0)
+			recordFile = argv[++i];
+	// --check-allocations reports heap allocations of warmed up frames (builds with LITTLEGAME_ALLOC_HOOKS only)
+	GLboolean checkAllocations = GL_FALSE;
+	for (int i = 1; i < argc; ++i)
+		if (std::strcmp(argv[i], "--check-allocations") == 0)
+			checkAllocations = GL_TRUE;
+	if (checkAllocations && !AllocTracker::Enabled())
+		std::cout << "ERROR::GAME: --check-allocations needs a build with LITTLEGAME_ALLOC_HOOKS" << std::endl;
+	// --metrics <file> appends a metrics snapshot every 10 seconds to file (JSON lines, rotated at 16 MiB)
+	const char *metricsFile = nullptr;
+	for (int i = 1; i + 1 < argc; ++i)
+		if (std::strcmp(argv[i], "--metrics") == 0)
+			metricsFile = argv[++i];
+	// --pacing off|vsync|adaptive|limit picks how frames are paced (vsync by default), --fps N sets the limiter's target
+	FramePacer pacer;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--pacing") == 0 && !FramePacer::Parse(argv[++i], pacer.Mode))
+			std::cout << "ERROR::GAME: Unknown pacing mode " << argv[i] << std::endl;
+		else if (std::strcmp(argv[i], "--fps") == 0)
+			pacer.TargetFps = static_cast<GLfloat>(std::atof(argv[++i]));
+	}
+	// --single-thread runs the simulation ticks within the render loop instead of on a thread of their own
+	GLboolean singleThread = GL_FALSE;
+	for (int i = 1; i < argc; ++i)
+		if (std::strcmp(argv[i], "--single-thread") == 0)
+			singleThread = GL_TRUE;
+	// --dynamic-resolution <min scale> renders at 'min scale' to 100% of the window, whatever holds the frame rate
+	GLfloat minScale = 0.0f;
+	for (int i = 1; i + 1 < argc; ++i)
+		if (std::strcmp(argv[i], "--dynamic-resolution") == 0)
+			minScale = static_cast<GLfloat>(std::atof(argv[++i]));
+	// --endless plays the endless mode: rows of generated bricks keep scrolling in from the top
+	GLboolean endless = GL_FALSE;
+	for (int i = 1; i < argc; ++i)
+		if (std::strcmp(argv[i], "--endless") == 0)
+			endless = GL_TRUE;
+	// --level <file> plays a level file (such as those of littleGame_level_gen) at a fixed tile size, with a camera following the ball
+	const char *levelFile = nullptr;
+	for (int i = 1; i + 1 < argc; ++i)
+		if (std::strcmp(argv[i], "--level") == 0)
+			levelFile = argv[++i];
+	// Recordings store neither the mode nor the playfield, so littleGame_replay could never play these games back
+	if ((endless || levelFile) && recordFile)
+	{
+		std::cout << "ERROR::GAME: --record only works with the shipped levels, not with --endless or --level" << std::endl;
+		return 1;
+	}
+	// --rewind <MiB> sets how much memory the rewind buffer (Backspace, R to retry) may take, 0 turns it off
+	GLuint rewindBudget = 64;
+	for (int i = 1; i + 1 < argc; ++i)
+		if (std::strcmp(argv[i], "--rewind") == 0)
+			rewindBudget = static_cast<GLuint>(std::atoi(argv[++i]));
+	// --autopilot lets the Autopilot play the paddle and launch the ball (the rewind keys still work)
+	GLboolean autopilot = GL_FALSE;
+	for (int i = 1; i < argc; ++i)
+		if (std::strcmp(argv[i], "--autopilot") == 0)
+			autopilot = GL_TRUE;
+
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -40,6 +160,9 @@ int main(int argc, char *argv[])
 	glGetError(); // Call it once to catch glewInit() bug, all other errors are now from our application.
 
 	glfwSetKeyCallback(window, key_callback);
+	glfwSetWindowRefreshCallback(window, refresh_callback);
+	glfwSetWindowFocusCallback(window, focus_callback);
+	pacer.Apply();
 
 	// OpenGL configuration
 	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
@@ -47,12 +170,59 @@ int main(int argc, char *argv[])
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+	// The scaler aims at the limiter's rate, or at 60 fps
+	ResolutionScaler *scaler = nullptr;
+	if (minScale > 0.0f)
+	{
+		GLfloat fps = pacer.Mode == PACING_LIMIT && pacer.TargetFps > 0.0f ? pacer.TargetFps : 60.0f;
+		scaler = new ResolutionScaler(1.0f / fps, std::min(minScale, 1.0f), 1.0f);
+		if (!scaler->Init(SCREEN_WIDTH, SCREEN_HEIGHT))
+		{
+			delete scaler;
+			scaler = nullptr;
+		}
+	}
+
+	// Start the shared worker pool before anything wants to use it
+	JobSystem::Init();
+
 	// Initialize game
+	Breakout.Seed = static_cast<GLuint64>(std::time(nullptr));
 	Breakout.Init();
+	if (levelFile)
+	{
+		GameLevel level;
+		level.Load(levelFile, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
+		if (!Breakout.PlayLevel(level))
+			std::cout << "ERROR::GAME: Failed to load level " << levelFile << std::endl;
+	}
+	if (endless)
+	{
+		LevelSpec rows = ENDLESS_LEVEL;
+		rows.Seed = Breakout.Seed;
+		Breakout.PlayEndless(rows);
+	}
+	// A recording cannot hold rewinds, so recorded sessions play straight through
+	if (recordFile)
+		rewindBudget = 0;
+	Breakout.History.SetBudget(static_cast<size_t>(rewindBudget) << 20);
+	InputRecording recording;
+	recording.Start(Breakout);
+	Autopilot pilot;
+	MetricId frameTime = Metrics::RegisterHistogram("frame_time_us");
+	MetricId frameCount = Metrics::RegisterCounter("frames");
+	if (metricsFile)
+		Metrics::StartExport(metricsFile);
 
 	// DeltaTime variables
 	GLfloat deltaTime = 0.0f;
 	GLfloat lastFrame = 0.0f;
+	GLfloat accumulator = 0.0f;
+	// Time the last frame kept the loop busy (everything but the pacer's wait)
+	GLfloat workTime = 0.0f;
+	// Frames (and simulation ticks, on their own thread) before the allocation check starts, so arrays can grow to their working size first
+	const GLuint ALLOCATION_WARMUP = 300;
+	GLuint frames = 0;
 
 	// Start Game within Menu State
 	// Ϸ״̬翪ʼϷͣϷͨص
@@ -60,31 +230,131 @@ int main(int argc, char *argv[])
 	// ֻҪȾѭи޸״̬Ϳ
 	Breakout.State = GAME_ACTIVE;
 
+	// Unless asked not to, the simulation ticks on its own thread and the loop below only draws
+	// the snapshots it publishes; from here on that thread owns the game's simulation state
+	SimulationThread *simulation = nullptr;
+	if (!singleThread)
+	{
+		simulation = new SimulationThread();
+		if (checkAllocations)
+			simulation->ExpectNoAllocations(ALLOCATION_WARMUP);
+		simulation->Start(Breakout, Input, recordFile ? &recording : nullptr, autopilot ? &pilot : nullptr);
+	}
+
 	while (!glfwWindowShouldClose(window))
 	{
+		const RenderSnapshot *snapshot = nullptr;
+		if (simulation)
+		{
+			simulation->Snapshots.Acquire();
+			snapshot = &simulation->Snapshots.Front();
+		}
+		// While idle the loop sleeps in the event queue and only redraws when asked to;
+		// the simulation is paused, so the time spent waiting is not caught up afterwards
+		GLboolean idle = isIdle(window, snapshot ? snapshot->State : Breakout.State);
+		if (simulation)
+			simulation->SetPaused(idle);
+		if (idle)
+		{
+			waitEvents();
+			lastFrame = glfwGetTime();
+			// Nothing ticks, so input is applied as it comes (a paused simulation thread does that itself)
+			if (!simulation)
+				while (Breakout.ConsumeInput(Input, lastFrame) > 0)
+					;
+			pacer.Restart();
+			if (RedrawRequested)
+			{
+				RedrawRequested = GL_FALSE;
+				Breakout.PlayerLead = glm::vec2(0.0f);
+				renderFrame(scaler, 0.0f, snapshot);
+				glfwSwapBuffers(window);
+			}
+			continue;
+		}
+		pacer.Wait();
+		GLdouble workStart = glfwGetTime();
+
 		// Calculate delta time
 		GLfloat currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
+		Metrics::Record(frameTime, static_cast<GLuint64>(deltaTime * 1.0e6f));
+		Metrics::Add(frameCount);
 		glfwPollEvents();
+		AllocTracker::ExpectNoAllocations(checkAllocations && frames++ >= ALLOCATION_WARMUP);
+		AllocTracker::BeginFrame();
+
+		if (simulation)
+		{
+			// Late input sampling: the newest snapshot, with the paddle moved on by the keys held since
+			// (the autopilot's, as of the snapshot, when it plays)
+			simulation->Snapshots.Acquire();
+			snapshot = &simulation->Snapshots.Front();
+			GLfloat ahead = static_cast<GLfloat>(glfwGetTime() - snapshot->Time);
+			GLboolean left = autopilot ? snapshot->HeldLeft : KeysDown[GLFW_KEY_A];
+			GLboolean right = autopilot ? snapshot->HeldRight : KeysDown[GLFW_KEY_D];
+			Breakout.SamplePlayer(*snapshot, left, right, ahead);
+		}
+		else
+		{
+			// The simulation advances in fixed ticks so a recorded session replays
+			// identically; after a long stall at most a quarter second is caught up
+			accumulator += deltaTime;
+			if (accumulator > 0.25f)
+				accumulator = 0.25f;
+			// Wall clock time the next tick ends at: it runs with the input events stamped before then
+			GLdouble tickEnd = workStart - accumulator + TICK_DURATION;
+			while (accumulator >= TICK_DURATION)
+			{
+				Breakout.ConsumeInput(Input, tickEnd);
+				tickEnd += TICK_DURATION;
+				if (autopilot)
+					pilot.Apply(Breakout);
+				if (recordFile)
+					recording.Capture(Breakout);
+				if (!Breakout.ProcessRewind())
+				{
+					// Manage user input
+					Breakout.ProcessInput(TICK_DURATION);
 
-		//deltaTime = 0.001f;
-		// Manage user input
-		Breakout.ProcessInput(deltaTime);
+					// Update Game state
+					Breakout.Update(TICK_DURATION);
+				}
+				if (recordFile)
+					recording.Checkpoint(Breakout);
+				accumulator -= TICK_DURATION;
+			}
 
-		// Update Game state
-		Breakout.Update(deltaTime);
+			// Late input sampling: poll once more right before drawing and show the paddle where
+			// the newest input puts it, which the next ticks catch up with
+			glfwPollEvents();
+			Breakout.SamplePlayer(Input, accumulator + static_cast<GLfloat>(glfwGetTime() - workStart));
+		}
 
 		// Render
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-		Breakout.Render();
+		renderFrame(scaler, workTime, snapshot);
+		AllocTracker::EndFrame();
 
 		glfwSwapBuffers(window);
+		workTime = static_cast<GLfloat>(glfwGetTime() - workStart);
 	}
 
+	// Hand the game back to this thread before anything reads it
+	delete simulation;
+	AllocTracker::ExpectNoAllocations(GL_FALSE);
+	Metrics::StopExport();
+	if (recordFile && recording.Save(recordFile))
+		std::cout << "Recorded " << recording.Ticks << " ticks to " << recordFile << std::endl;
+	if (checkAllocations && AllocTracker::Violations() > 0)
+		std::cout << "ERROR::GAME: " << AllocTracker::Violations() << " allocations in warmed up frames" << std::endl;
+	if (Input.Dropped() > 0)
+		std::cout << "ERROR::GAME: " << Input.Dropped() << " input events dropped, the queue was full" << std::endl;
+
 	// Delete all resources as loaded using the resource manager
+	delete scaler;
 	ResourceManager::Clear();
+	JobSystem::Shutdown();
 
 	glfwTerminate();
 	return 0;
@@ -99,12 +369,28 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	// Keys飬ΪϣGLFW еİԼ״̬һintִ
 	// ĺôǣе봦ӳٵϷBreakoutнУ൱ڴݺʹ
 	// ˽һµϷ֮һֱ޷
+	// Events are stamped here and queued; each simulation tick takes the ones that happened before it ends
 	if (key >= 0 && key < 1024)
 	{
-		if (action == GLFW_PRESS)
-			Breakout.Keys[key] = GL_TRUE;
-		else if (action == GLFW_RELEASE)
-			Breakout.Keys[key] = GL_FALSE;
-		Breakout.KeyState[key] = action;
+		Input.Push(KeyEvent(glfwGetTime(), key, action));
+		if (action != GLFW_REPEAT)
+			KeysDown[key] = action == GLFW_PRESS;
+	}
+	RedrawRequested = GL_TRUE;
+}
+
+void refresh_callback(GLFWwindow* window)
+{
+	RedrawRequested = GL_TRUE;
+}
+
+void focus_callback(GLFWwindow* window, int focused)
+{
+	// Keys released while the window was in the background never reach us
+	if (!focused)
+	{
+		Input.Push(KeyEvent(glfwGetTime(), RELEASE_ALL_KEYS, GLFW_RELEASE));
+		std::fill(KeysDown, KeysDown + 1024, GL_FALSE);
 	}
+	RedrawRequested = GL_TRUE;
 }
\ No newline at end of file
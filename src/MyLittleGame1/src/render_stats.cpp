@@ -0,0 +1,21 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "render_stats.h"
+
+
+// Instantiate static variables
+GLuint RenderStats::DrawCalls = 0;
+GLuint RenderStats::Vertices = 0;
+
+
+void RenderStats::Reset()
+{
+	DrawCalls = 0;
+	Vertices = 0;
+}
@@ -0,0 +1,63 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "render_target.h"
+
+#include <iostream>
+
+
+RenderTarget::RenderTarget()
+	: Width(0), Height(0)
+{
+
+}
+
+GLboolean RenderTarget::Generate(GLuint width, GLuint height)
+{
+	this->Width = width;
+	this->Height = height;
+	this->Color.Internal_Format = GL_RGBA;
+	this->Color.Image_Format = GL_RGBA;
+	this->Color.Wrap_S = GL_CLAMP_TO_EDGE;
+	this->Color.Wrap_T = GL_CLAMP_TO_EDGE;
+	this->Color.Generate(width, height, nullptr);
+	glBindFramebuffer(GL_FRAMEBUFFER, this->Framebuffer.Get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->Color.Object.ID(), 0);
+	GLboolean complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!complete)
+		std::cout << "ERROR::RENDER_TARGET: Framebuffer of " << width << "x" << height << " is not complete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return complete;
+}
+
+void RenderTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, this->Framebuffer.ID());
+	glViewport(0, 0, this->Width, this->Height);
+}
+
+void RenderTarget::BindDefault(GLuint width, GLuint height)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+}
+
+void RenderTarget::ReadPixels(std::vector<unsigned char> &pixels) const
+{
+	pixels.resize(this->Width * this->Height * 4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, this->Framebuffer.ID());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, this->Width, this->Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::Destroy()
+{
+	this->Framebuffer.Release();
+	this->Color.Object.Release();
+}
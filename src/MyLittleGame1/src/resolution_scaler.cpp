@@ -0,0 +1,138 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "resolution_scaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+	// Frames between two scale changes, so a change shows in the timings before the next one
+	const GLuint  ADJUST_INTERVAL = 10;
+	// Weight of the newest sample in the smoothed timings
+	const GLfloat SMOOTHING = 0.2f;
+	// Share of the target frame time aimed for, and the band around it that is left alone
+	const GLfloat HEADROOM = 0.9f, DEAD_BAND = 0.15f;
+	// Largest change of Scale per adjustment
+	const GLfloat MAX_STEP = 0.1f;
+	// GPU timings beyond this are bogus (some drivers return garbage for a first query)
+	const GLfloat MAX_GPU_TIME = 1.0f;
+
+	GLfloat smooth(GLfloat average, GLfloat sample)
+	{
+		return average > 0.0f ? average + SMOOTHING * (sample - average) : sample;
+	}
+}
+
+
+ResolutionScaler::ResolutionScaler(GLfloat targetFrameTime, GLfloat minScale, GLfloat maxScale)
+	: MinScale(minScale), MaxScale(maxScale), TargetFrameTime(targetFrameTime), Scale(maxScale), GpuTime(0.0f), UseGpuTimer(GL_TRUE),
+	  pending(), query(0), timing(GL_FALSE), frameTime(0.0f), framesSinceChange(0), width(0), height(0)
+{
+
+}
+
+GLboolean ResolutionScaler::Init(GLuint width, GLuint height)
+{
+	this->width = width;
+	this->height = height;
+	const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+	const char *software[] = { "llvmpipe", "softpipe", "SwiftShader", "GDI Generic" };
+	for (const char *name : software)
+		if (renderer && std::strstr(renderer, name))
+			this->UseGpuTimer = GL_FALSE;
+	return this->Target.Generate(width, height);
+}
+
+void ResolutionScaler::Begin()
+{
+	this->collectQueries();
+	// A query still in flight after QUERIES frames is left alone, this frame just goes untimed
+	if (this->UseGpuTimer && !this->pending[this->query])
+	{
+		glBeginQuery(GL_TIME_ELAPSED, this->queries[this->query].Get());
+		this->timing = GL_TRUE;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, this->Target.Framebuffer.ID());
+	glViewport(0, 0, this->ScaledWidth(), this->ScaledHeight());
+}
+
+void ResolutionScaler::End(GLfloat frameTime, GLuint framebuffer)
+{
+	if (this->timing)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		this->pending[this->query] = GL_TRUE;
+		this->query = (this->query + 1) % QUERIES;
+		this->timing = GL_FALSE;
+	}
+	GLuint scaledWidth = this->ScaledWidth(), scaledHeight = this->ScaledHeight();
+	GLboolean native = scaledWidth == this->width && scaledHeight == this->height;
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, this->Target.Framebuffer.ID());
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glBlitFramebuffer(0, 0, scaledWidth, scaledHeight, 0, 0, this->width, this->height, GL_COLOR_BUFFER_BIT, native ? GL_NEAREST : GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, this->width, this->height);
+	if (frameTime > 0.0f)
+		this->frameTime = smooth(this->frameTime, frameTime);
+	this->adapt();
+}
+
+GLuint ResolutionScaler::ScaledWidth() const
+{
+	return std::max(1u, static_cast<GLuint>(this->width * this->Scale + 0.5f));
+}
+
+GLuint ResolutionScaler::ScaledHeight() const
+{
+	return std::max(1u, static_cast<GLuint>(this->height * this->Scale + 0.5f));
+}
+
+void ResolutionScaler::collectQueries()
+{
+	// Oldest query first
+	for (GLuint i = 0; i < QUERIES; ++i)
+	{
+		GLuint slot = (this->query + i) % QUERIES;
+		if (!this->pending[slot])
+			continue;
+		GLint available = 0;
+		glGetQueryObjectiv(this->queries[slot].ID(), GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(this->queries[slot].ID(), GL_QUERY_RESULT, &nanoseconds);
+		if (nanoseconds * 1.0e-9f < MAX_GPU_TIME)
+			this->GpuTime = smooth(this->GpuTime, nanoseconds * 1.0e-9f);
+		this->pending[slot] = GL_FALSE;
+	}
+}
+
+void ResolutionScaler::adapt()
+{
+	if (++this->framesSinceChange < ADJUST_INTERVAL)
+		return;
+	GLfloat cost = this->UseGpuTimer && this->GpuTime > 0.0f ? this->GpuTime : this->frameTime;
+	if (cost <= 0.0f || this->TargetFrameTime <= 0.0f)
+		return;
+	GLfloat ratio = this->TargetFrameTime * HEADROOM / cost;
+	if (std::abs(ratio - 1.0f) < DEAD_BAND)
+		return;
+	// The cost of filling grows with the number of pixels, the square of the scale
+	GLfloat scale = this->Scale * std::sqrt(ratio);
+	scale = std::max(this->Scale - MAX_STEP, std::min(this->Scale + MAX_STEP, scale));
+	scale = std::max(this->MinScale, std::min(this->MaxScale, scale));
+	if (scale != this->Scale)
+	{
+		this->Scale = scale;
+		this->framesSinceChange = 0;
+	}
+}
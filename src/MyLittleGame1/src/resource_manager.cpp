@@ -13,41 +13,117 @@
 
 #include <SOIL.h>
 
+#include "job_system.h"
+
 // Instantiate static variables
-std::map<std::string, Texture2D>    ResourceManager::Textures;
-std::map<std::string, Shader>       ResourceManager::Shaders;
+ResourcePool<Shader, ResourceManager::MAX_SHADERS>     ResourceManager::shaders;
+ResourcePool<Texture2D, ResourceManager::MAX_TEXTURES> ResourceManager::textures;
+
+// Raw pixel data of an image decoded from disk, waiting to be uploaded to the GPU
+struct ImageData {
+	unsigned char *Pixels;
+	int            Width, Height, Components;
+	const GLchar  *File;
+	const char    *Failure;  // why stb_image failed to decode it, as seen by the decoding thread
+
+	ImageData() : Pixels(nullptr), Width(0), Height(0), Components(0), File(nullptr), Failure(nullptr) { }
+};
+
+// Decodes an image file into memory; safe to call from any thread
+static ImageData decodeImage(const GLchar *file);
+// Creates a texture from decoded pixels and frees them, or reports why there are none; needs the GL context
+static Texture2D createTexture(ImageData &image, GLboolean alpha);
+
 
+ShaderHandle ResourceManager::LoadShader(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile, HashedName name)
+{
+	ShaderHandle handle = shaders.Store(name, loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile));
+	if (!handle.IsValid())
+		std::cout << "ERROR::RESOURCE_MANAGER: More than " << MAX_SHADERS << " shaders loaded" << std::endl;
+	return handle;
+}
 
-Shader ResourceManager::LoadShader(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile, std::string name)
+ShaderHandle ResourceManager::FindShader(HashedName name)
 {
-	Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
-	return Shaders[name];
+	return shaders.Find(name);
 }
 
-Shader ResourceManager::GetShader(std::string name)
+Shader &ResourceManager::GetShader(ShaderHandle handle)
 {
-	return Shaders[name];
+	if (!shaders.IsAlive(handle))
+	{
+		static Shader missing;
+		std::cout << "ERROR::RESOURCE_MANAGER: Invalid or stale shader handle" << std::endl;
+		return missing;
+	}
+	return shaders.Get(handle);
 }
 
-Texture2D ResourceManager::LoadTexture(const GLchar *file, GLboolean alpha, std::string name)
+Shader &ResourceManager::GetShader(HashedName name)
 {
-	Textures[name] = loadTextureFromFile(file, alpha);
-	return Textures[name];
+	ShaderHandle handle = shaders.Find(name);
+	if (!handle.IsValid())
+		std::cout << "ERROR::RESOURCE_MANAGER: No shader named " << std::hex << name.Value << std::dec << std::endl;
+	return GetShader(handle);
 }
 
-Texture2D ResourceManager::GetTexture(std::string name)
+TextureHandle ResourceManager::LoadTexture(const GLchar *file, GLboolean alpha, HashedName name)
 {
-	return Textures[name];
+	return storeTexture(name, loadTextureFromFile(file, alpha));
+}
+
+void ResourceManager::LoadTextures(const std::vector<TextureRequest> &requests)
+{
+	// Decoding is the expensive part and touches no GL state, so spread it over the workers
+	std::vector<ImageData> images(requests.size());
+	JobSystem::ParallelFor(static_cast<GLuint>(requests.size()), 1, [&](GLuint begin, GLuint end) {
+		for (GLuint i = begin; i < end; ++i)
+			images[i] = decodeImage(requests[i].File);
+	});
+	// Uploads have to happen on the thread owning the context
+	for (size_t i = 0; i < requests.size(); ++i)
+		storeTexture(requests[i].Name, createTexture(images[i], requests[i].Alpha));
+}
+
+TextureHandle ResourceManager::FindTexture(HashedName name)
+{
+	return textures.Find(name);
+}
+
+const Texture2D &ResourceManager::GetTexture(TextureHandle handle)
+{
+	if (!textures.IsAlive(handle))
+	{
+		// Never generated, so it binds texture object 0, which samples as black
+		static Texture2D missing;
+		std::cout << "ERROR::RESOURCE_MANAGER: Invalid or stale texture handle" << std::endl;
+		return missing;
+	}
+	return textures.Get(handle);
+}
+
+const Texture2D &ResourceManager::GetTexture(HashedName name)
+{
+	TextureHandle handle = textures.Find(name);
+	if (!handle.IsValid())
+		std::cout << "ERROR::RESOURCE_MANAGER: No texture named " << std::hex << name.Value << std::dec << std::endl;
+	return GetTexture(handle);
 }
 
 void ResourceManager::Clear()
 {
 	// (Properly) delete all shaders	
-	for (auto iter : Shaders)
-		glDeleteProgram(iter.second.ID);
+	shaders.Clear();
 	// (Properly) delete all textures
-	for (auto iter : Textures)
-		glDeleteTextures(1, &iter.second.ID);
+	textures.Clear();
+}
+
+TextureHandle ResourceManager::storeTexture(HashedName name, Texture2D &&texture)
+{
+	TextureHandle handle = textures.Store(name, std::move(texture));
+	if (!handle.IsValid())
+		std::cout << "ERROR::RESOURCE_MANAGER: More than " << MAX_TEXTURES << " textures loaded" << std::endl;
+	return handle;
 }
 
 Shader ResourceManager::loadShaderFromFile(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile)
@@ -95,29 +171,46 @@ Shader ResourceManager::loadShaderFromFile(const GLchar *vShaderFile, const GLch
 }
 
 Texture2D ResourceManager::loadTextureFromFile(const GLchar *file, GLboolean alpha)
+{
+	ImageData image = decodeImage(file);
+	return createTexture(image, alpha);
+}
+
+ImageData decodeImage(const GLchar *file)
+{
+	// Load image
+	ImageData image;
+	//unsigned char* image = SOIL_load_image(file, &width, &height, 0, texture.Image_Format == GL_RGBA ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+	image.Pixels = stbi_load(file, &image.Width, &image.Height, &image.Components, 0);
+	image.File = file;
+	// The reason is kept per thread (see stb_image.cpp), so it has to be picked up here
+	if (!image.Pixels)
+		image.Failure = stbi_failure_reason();
+	return image;
+}
+
+Texture2D createTexture(ImageData &image, GLboolean alpha)
 {
 	// Create Texture object
 	Texture2D texture;
+	if (!image.Pixels)
+		std::cout << "ERROR::RESOURCE_MANAGER: Failed to load texture " << image.File << ": " << image.Failure << std::endl;
 	if (alpha)
 	{
 		texture.Internal_Format = GL_RGBA;
 		texture.Image_Format = GL_RGBA;
 	}
-	// Load image
-	int width, height, nrComponents;
-	//unsigned char* image = SOIL_load_image(file, &width, &height, 0, texture.Image_Format == GL_RGBA ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
-	unsigned char* image = stbi_load(file, &width, &height, &nrComponents, 0);
-	GLenum format;
-	if (nrComponents == 1)
+	if (image.Components == 1)
 		texture.Internal_Format = texture.Image_Format = GL_RED;
-	else if (nrComponents == 3)
+	else if (image.Components == 3)
 		texture.Internal_Format = texture.Image_Format = GL_RGB;
-	else if (nrComponents == 4)
+	else if (image.Components == 4)
 		texture.Internal_Format = texture.Image_Format = GL_RGBA;
 	// Now generate texture
-	texture.Generate(width, height, image);
+	texture.Generate(image.Width, image.Height, image.Pixels);
 	// And finally free image data
 	//SOIL_free_image_data(image);
-	stbi_image_free(image);
+	stbi_image_free(image.Pixels);
+	image.Pixels = nullptr;
 	return texture;
-}
\ No newline at end of file
+}
@@ -0,0 +1,303 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "rewind_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+	// Unchanged bytes it takes to end a literal run; shorter gaps are cheaper to copy along
+	const size_t MIN_ZERO_RUN = 4;
+
+	void writeVarint(std::vector<GLubyte> &out, size_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<GLubyte>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<GLubyte>(value));
+	}
+
+	size_t readVarint(const GLubyte *&data, const GLubyte *end)
+	{
+		size_t value = 0;
+		for (GLuint shift = 0; data < end; shift += 7)
+		{
+			GLubyte byte = *data++;
+			value |= static_cast<size_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				break;
+		}
+		return value;
+	}
+}
+
+
+RewindBuffer::RewindBuffer(size_t budget, GLuint keyframeInterval)
+	: KeyframeInterval(keyframeInterval), budget(0), head(0), count(0), bytes(0), keyframes(0), keyTick(0), keyValid(GL_FALSE)
+{
+	this->SetBudget(budget);
+}
+
+void RewindBuffer::SetBudget(size_t budget)
+{
+	this->Clear();
+	this->budget = budget;
+	// Reserved rather than sized, so the pages of the ring are only touched once frames reach them
+	std::vector<GLubyte>().swap(this->ring);
+	std::vector<Frame>().swap(this->frames);
+	if (budget > 0)
+	{
+		this->ring.reserve(budget);
+		this->frames.reserve(MAX_FRAMES);
+	}
+}
+
+void RewindBuffer::Clear()
+{
+	this->head = this->count = 0;
+	this->bytes = 0;
+	this->keyframes = 0;
+	this->keyValid = GL_FALSE;
+}
+
+GLuint64 RewindBuffer::FirstTick() const
+{
+	return this->count > 0 ? this->frame(0).Tick : 0;
+}
+
+GLuint64 RewindBuffer::LastTick() const
+{
+	return this->count > 0 ? this->frame(this->count - 1).Tick : 0;
+}
+
+GLboolean RewindBuffer::Record(GLuint64 tick, const StateImage &image)
+{
+	if (this->budget == 0)
+		return GL_FALSE;
+	// Recording after a seek replaces the frames that were played back
+	while (this->count > 0 && this->LastTick() >= tick)
+		this->dropNewest();
+	if (this->count > 0 && this->LastTick() + 1 != tick)
+		this->Clear();
+	if (this->count == MAX_FRAMES)
+		this->dropOldest();
+	Frame frame;
+	frame.Tick = tick;
+	frame.Length = image.size();
+	frame.Keyframe = this->count > 0 ? this->frame(this->count - 1).Keyframe : tick;
+	if (tick - frame.Keyframe >= this->KeyframeInterval)
+		frame.Keyframe = tick;
+	if (frame.Keyframe != tick)
+	{
+		this->loadKeyframe(frame.Keyframe);
+		this->encode(image, &this->keyImage);
+		if (!this->reserve(this->encoded.size(), frame.Offset))
+			return GL_FALSE;
+		// Making room dropped the keyframe itself, so this frame has to become one
+		if (this->count == 0)
+			frame.Keyframe = tick;
+	}
+	if (frame.Keyframe == tick)
+	{
+		this->encode(image, nullptr);
+		if (!this->reserve(this->encoded.size(), frame.Offset))
+			return GL_FALSE;
+		this->keyImage = image;
+		this->keyTick = tick;
+		this->keyValid = GL_TRUE;
+		++this->keyframes;
+	}
+	frame.Size = this->encoded.size();
+	if (frame.Size > 0)
+		std::memcpy(this->ring.data() + frame.Offset, this->encoded.data(), frame.Size);
+	this->bytes += frame.Size;
+	this->pushFrame(frame);
+	return GL_TRUE;
+}
+
+GLboolean RewindBuffer::Seek(GLuint64 tick, StateImage &image)
+{
+	if (!this->Contains(tick))
+		return GL_FALSE;
+	const Frame &frame = this->frame(static_cast<GLuint>(tick - this->FirstTick()));
+	this->loadKeyframe(frame.Keyframe);
+	image = this->keyImage;
+	if (frame.Keyframe != tick)
+	{
+		image.resize(frame.Length, 0);
+		decode(this->ring.data() + frame.Offset, frame.Size, image);
+	}
+	return GL_TRUE;
+}
+
+void RewindBuffer::dropOldest()
+{
+	do
+	{
+		const Frame &oldest = this->frame(0);
+		this->bytes -= oldest.Size;
+		this->keyframes -= oldest.Keyframe == oldest.Tick;
+		if (this->keyValid && this->keyTick == oldest.Tick)
+			this->keyValid = GL_FALSE;
+		this->head = (this->head + 1) % this->frames.size();
+		--this->count;
+	} while (this->count > 0 && this->frame(0).Keyframe != this->frame(0).Tick);
+}
+
+void RewindBuffer::dropNewest()
+{
+	const Frame &newest = this->frame(this->count - 1);
+	this->bytes -= newest.Size;
+	this->keyframes -= newest.Keyframe == newest.Tick;
+	if (this->keyValid && this->keyTick == newest.Tick)
+		this->keyValid = GL_FALSE;
+	--this->count;
+}
+
+GLboolean RewindBuffer::reserve(size_t size, size_t &offset)
+{
+	if (size > this->budget)
+		return GL_FALSE;
+	// Frames are laid out one after another and wrap around to the start of the ring
+	// once the end has no room left; the space between the newest and oldest frame is free
+	while (this->count > 0)
+	{
+		const Frame &oldest = this->frame(0), &newest = this->frame(this->count - 1);
+		size_t end = newest.Offset + newest.Size;
+		if (newest.Offset >= oldest.Offset)
+		{
+			if (this->budget - end >= size)
+			{
+				offset = end;
+				this->grow(end + size);
+				return GL_TRUE;
+			}
+			if (oldest.Offset >= size)
+			{
+				offset = 0;
+				return GL_TRUE;
+			}
+		}
+		else if (oldest.Offset - end >= size)
+		{
+			offset = end;
+			return GL_TRUE;
+		}
+		this->dropOldest();
+	}
+	offset = 0;
+	this->grow(size);
+	return GL_TRUE;
+}
+
+void RewindBuffer::grow(size_t size)
+{
+	if (size > this->ring.size())
+		this->ring.resize(size);
+}
+
+void RewindBuffer::pushFrame(const Frame &frame)
+{
+	if (this->count == this->frames.size())
+	{
+		// Unroll the ring before growing it
+		std::rotate(this->frames.begin(), this->frames.begin() + this->head, this->frames.end());
+		this->head = 0;
+		this->frames.resize(std::min<size_t>(MAX_FRAMES, std::max<size_t>(64, this->frames.size() * 2)));
+	}
+	this->frame(this->count++) = frame;
+}
+
+void RewindBuffer::loadKeyframe(GLuint64 tick)
+{
+	if (this->keyValid && this->keyTick == tick)
+		return;
+	const Frame &key = this->frame(static_cast<GLuint>(tick - this->FirstTick()));
+	this->keyImage.assign(key.Length, 0);
+	decode(this->ring.data() + key.Offset, key.Size, this->keyImage);
+	this->keyTick = tick;
+	this->keyValid = GL_TRUE;
+}
+
+void RewindBuffer::encode(const StateImage &image, const StateImage *base)
+{
+	// XOR the images a word at a time first, the scan below then only looks for zeros
+	size_t size = image.size(), shared = base ? std::min(size, base->size()) : 0;
+	this->delta.resize(size);
+	if (size == 0)
+	{
+		this->encoded.clear();
+		return;
+	}
+	GLubyte *delta = &this->delta[0];
+	const GLubyte *bytes = &image[0];
+	std::memcpy(delta, bytes, size);
+	for (size_t i = 0; i + 8 <= shared; i += 8)
+	{
+		GLuint64 a, b;
+		std::memcpy(&a, bytes + i, 8);
+		std::memcpy(&b, &(*base)[i], 8);
+		a ^= b;
+		std::memcpy(delta + i, &a, 8);
+	}
+	for (size_t i = shared & ~static_cast<size_t>(7); i < shared; ++i)
+		delta[i] ^= (*base)[i];
+	// Runs of (unchanged bytes to skip, changed bytes to XOR in); trailing unchanged bytes are left out. Every literal
+	// run but the last is followed by MIN_ZERO_RUN unchanged bytes, which bounds the encoding well below twice the image
+	this->encoded.clear();
+	this->encoded.reserve(2 * size + 16);
+	static const GLubyte ZEROS[8] = { 0 };
+	size_t i = 0;
+	while (i < size)
+	{
+		size_t start = i;
+		while (i + 8 <= size && std::memcmp(delta + i, ZEROS, 8) == 0)
+			i += 8;
+		while (i < size && delta[i] == 0)
+			++i;
+		if (i == size)
+			break;
+		// The literal run ends at MIN_ZERO_RUN unchanged bytes in a row, or at the end of the image
+		size_t end = i, zeros = 0;
+		while (end + zeros < size && zeros < MIN_ZERO_RUN)
+		{
+			if (delta[end + zeros] == 0)
+				++zeros;
+			else
+			{
+				end += zeros + 1;
+				zeros = 0;
+			}
+		}
+		writeVarint(this->encoded, i - start);
+		writeVarint(this->encoded, end - i);
+		this->encoded.insert(this->encoded.end(), delta + i, delta + end);
+		i = end;
+	}
+}
+
+void RewindBuffer::decode(const GLubyte *data, size_t size, StateImage &image)
+{
+	const GLubyte *end = data + size;
+	size_t position = 0;
+	while (data < end)
+	{
+		position += readVarint(data, end);
+		size_t literal = std::min<size_t>(readVarint(data, end), end - data);
+		size_t count = position < image.size() ? std::min(literal, image.size() - position) : 0;
+		for (size_t i = 0; i < count; ++i)
+			image[position + i] ^= data[i];
+		position += literal;
+		data += literal;
+	}
+}
@@ -12,7 +12,7 @@
 
 Shader &Shader::Use()
 {
-	glUseProgram(this->ID);
+	glUseProgram(this->Program.ID());
 	return *this;
 }
 
@@ -38,13 +38,14 @@ void Shader::Compile(const GLchar* vertexSource, const GLchar* fragmentSource, c
 		checkCompileErrors(gShader, "GEOMETRY");
 	}
 	// Shader Program
-	this->ID = glCreateProgram();
-	glAttachShader(this->ID, sVertex);
-	glAttachShader(this->ID, sFragment);
+	this->Program.Release();
+	GLuint program = this->Program.Get();
+	glAttachShader(program, sVertex);
+	glAttachShader(program, sFragment);
 	if (geometrySource != nullptr)
-		glAttachShader(this->ID, gShader);
-	glLinkProgram(this->ID);
-	checkCompileErrors(this->ID, "PROGRAM");
+		glAttachShader(program, gShader);
+	glLinkProgram(program);
+	checkCompileErrors(program, "PROGRAM");
 	// Delete the shaders as they're linked into our program now and no longer necessery
 	glDeleteShader(sVertex);
 	glDeleteShader(sFragment);
@@ -56,55 +57,55 @@ void Shader::SetFloat(const GLchar *name, GLfloat value, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform1f(glGetUniformLocation(this->ID, name), value);
+	glUniform1f(glGetUniformLocation(this->Program.ID(), name), value);
 }
 void Shader::SetInteger(const GLchar *name, GLint value, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform1i(glGetUniformLocation(this->ID, name), value);
+	glUniform1i(glGetUniformLocation(this->Program.ID(), name), value);
 }
 void Shader::SetVector2f(const GLchar *name, GLfloat x, GLfloat y, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+	glUniform2f(glGetUniformLocation(this->Program.ID(), name), x, y);
 }
 void Shader::SetVector2f(const GLchar *name, const glm::vec2 &value, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+	glUniform2f(glGetUniformLocation(this->Program.ID(), name), value.x, value.y);
 }
 void Shader::SetVector3f(const GLchar *name, GLfloat x, GLfloat y, GLfloat z, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+	glUniform3f(glGetUniformLocation(this->Program.ID(), name), x, y, z);
 }
 void Shader::SetVector3f(const GLchar *name, const glm::vec3 &value, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+	glUniform3f(glGetUniformLocation(this->Program.ID(), name), value.x, value.y, value.z);
 }
 void Shader::SetVector4f(const GLchar *name, GLfloat x, GLfloat y, GLfloat z, GLfloat w, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+	glUniform4f(glGetUniformLocation(this->Program.ID(), name), x, y, z, w);
 }
 void Shader::SetVector4f(const GLchar *name, const glm::vec4 &value, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+	glUniform4f(glGetUniformLocation(this->Program.ID(), name), value.x, value.y, value.z, value.w);
 }
 void Shader::SetMatrix4(const GLchar *name, const glm::mat4 &matrix, GLboolean useShader)
 {
 	if (useShader)
 		this->Use();
-	glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, GL_FALSE, glm::value_ptr(matrix));
+	glUniformMatrix4fv(glGetUniformLocation(this->Program.ID(), name), 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
 
@@ -0,0 +1,224 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "sim_state.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "collision.h"
+#include "game_systems.h"
+
+
+BrickPages::BrickPages(const BrickPages &other)
+	: table(other.table)
+{
+	if (this->table)
+		this->table->References.fetch_add(1, std::memory_order_relaxed);
+}
+
+BrickPages &BrickPages::operator=(const BrickPages &other)
+{
+	if (other.table)
+		other.table->References.fetch_add(1, std::memory_order_relaxed);
+	release(this->table);
+	this->table = other.table;
+	return *this;
+}
+
+BrickPages::~BrickPages()
+{
+	release(this->table);
+}
+
+void BrickPages::Assign(const GLuint *tiles, GLuint count)
+{
+	release(this->table);
+	this->table = new Table();
+	this->table->References.store(1, std::memory_order_relaxed);
+	this->table->Size = count;
+	for (GLuint first = 0; first < count; first += BRICK_PAGE_TILES)
+	{
+		Page *page = new Page();
+		page->References.store(1, std::memory_order_relaxed);
+		std::memset(page->Tiles, 0, sizeof(page->Tiles));
+		for (GLuint i = first; i < std::min(count, first + BRICK_PAGE_TILES); ++i)
+			page->Tiles[i - first] = static_cast<GLubyte>(std::min(tiles[i], 255u));
+		this->table->Pages.push_back(page);
+	}
+}
+
+void BrickPages::Set(GLuint index, GLubyte tile)
+{
+	// A count of one cannot change behind our back: any other reference would have to be copied from ours.
+	// The acquire pairs with the release of the last other owner, whose reads are then done
+	if (this->table->References.load(std::memory_order_acquire) != 1)
+	{
+		Table *copy = new Table();
+		copy->References.store(1, std::memory_order_relaxed);
+		copy->Size = this->table->Size;
+		copy->Pages = this->table->Pages;
+		for (Page *page : copy->Pages)
+			page->References.fetch_add(1, std::memory_order_relaxed);
+		release(this->table);
+		this->table = copy;
+	}
+	Page *&page = this->table->Pages[index / BRICK_PAGE_TILES];
+	if (page->References.load(std::memory_order_acquire) != 1)
+	{
+		Page *copy = new Page();
+		copy->References.store(1, std::memory_order_relaxed);
+		std::memcpy(copy->Tiles, page->Tiles, sizeof(copy->Tiles));
+		release(page);
+		page = copy;
+	}
+	page->Tiles[index % BRICK_PAGE_TILES] = tile;
+}
+
+void BrickPages::release(Table *table)
+{
+	if (!table || table->References.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+	for (Page *page : table->Pages)
+		release(page);
+	delete table;
+}
+
+void BrickPages::release(Page *page)
+{
+	if (page->References.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete page;
+}
+
+
+SimState::SimState()
+	: Width(0), Height(0), BallCount(0), Columns(0), Rows(0), TileSize(0.0f), BricksLeft(0), Ticks(0), Lost(GL_FALSE)
+{
+
+}
+
+GLboolean SimState::Capture(const Game &game)
+{
+	if (game.Endless || game.Level >= game.Levels.size())
+		return GL_FALSE;
+	const GameLevel &level = game.Levels[game.Level];
+	this->Width = game.Width;
+	this->Height = game.Height;
+	this->Paddle = game.Entities.Get<Transform>(game.Player);
+	// The level's tiles minus the bricks already broken, laid out as GameLevel::Spawn does
+	std::vector<GLuint> tiles = level.Tiles;
+	for (GLuint i = 0; i < game.BrickGrid.size() && i < tiles.size(); ++i)
+		if (game.Entities.IsAlive(game.BrickGrid[i]) && game.Entities.Get<Brick>(game.BrickGrid[i]).Destroyed)
+			tiles[i] = 0;
+	this->Bricks.Assign(tiles.data(), static_cast<GLuint>(tiles.size()));
+	this->Columns = level.Columns;
+	this->Rows = level.Rows;
+	this->TileSize = level.Rows > 0 ? glm::vec2(level.Width / static_cast<GLfloat>(level.Columns), level.Height / level.Rows) : glm::vec2(0.0f);
+	this->BricksLeft = static_cast<GLuint>(std::count_if(tiles.begin(), tiles.end(), [](GLuint tile) { return tile > 1; }));
+	this->BallCount = 0;
+	game.Entities.Each(BALL_ARCHETYPE, [&](const Archetype &balls) {
+		for (GLuint i = 0; i < balls.Size() && this->BallCount < SIM_MAX_BALLS; ++i)
+		{
+			SimBall &ball = this->Balls[this->BallCount++];
+			ball.Box = balls.Transforms[i];
+			ball.Motion = balls.Velocities[i];
+			ball.State = balls.Balls[i];
+			ball.Radius = balls.Colliders[i].Radius;
+		}
+	});
+	this->Ticks = game.Ticks;
+	this->Rng.Seed(game.Seed ^ game.Ticks);
+	this->Lost = this->BallCount == 0;
+	return GL_TRUE;
+}
+
+void SimState::Step(GLboolean left, GLboolean right, GLboolean release, GLfloat dt)
+{
+	if (this->Lost)
+		return;
+	++this->Ticks;
+	// The paddle, as Game::ProcessInput moves it
+	GLfloat velocity = PLAYER_VELOCITY * dt;
+	if (left && this->Paddle.Position.x >= 0)
+	{
+		this->Paddle.Position.x -= velocity;
+		this->moveStuckBalls(-velocity);
+	}
+	if (right && this->Paddle.Position.x <= this->Width - this->Paddle.Size.x)
+	{
+		this->Paddle.Position.x += velocity;
+		this->moveStuckBalls(velocity);
+	}
+	if (release)
+		for (GLuint i = 0; i < this->BallCount; ++i)
+			this->Balls[i].State.Stuck = GL_FALSE;
+	// The balls, as Game::Update moves them and resolves their collisions
+	for (GLuint i = 0; i < this->BallCount; ++i)
+		MoveBall(this->Balls[i].Box, this->Balls[i].Motion, this->Balls[i].State, dt, this->Width);
+	for (GLuint i = 0; i < this->BallCount; ++i)
+	{
+		SimBall &ball = this->Balls[i];
+		this->collideBricks(ball);
+		if (!ball.State.Stuck)
+			BounceOffPaddle(ball.Box, ball.Motion.Value, ball.Radius, this->Paddle);
+	}
+	for (GLuint i = 0; i < this->BallCount; ++i)
+		for (GLuint j = i + 1; j < this->BallCount; ++j)
+			if (!this->Balls[i].State.Stuck && !this->Balls[j].State.Stuck)
+				BounceBalls(this->Balls[i].Box, this->Balls[i].Motion.Value, this->Balls[i].Radius, this->Balls[j].Box, this->Balls[j].Motion.Value, this->Balls[j].Radius);
+	// Balls leaving the playfield are gone; the game would start the round over once none are left
+	GLuint kept = 0;
+	for (GLuint i = 0; i < this->BallCount; ++i)
+		if (this->Balls[i].Box.Position.y < this->Height)
+			this->Balls[kept++] = this->Balls[i];
+	this->BallCount = kept;
+	this->Lost = kept == 0;
+}
+
+void SimState::moveStuckBalls(GLfloat dx)
+{
+	for (GLuint i = 0; i < this->BallCount; ++i)
+		if (this->Balls[i].State.Stuck)
+			this->Balls[i].Box.Position.x += dx;
+}
+
+void SimState::collideBricks(SimBall &ball)
+{
+	if (this->Rows == 0)
+		return;
+	// Only the tiles under the ball's bounds are tested
+	GLint left = static_cast<GLint>(std::floor(ball.Box.Position.x / this->TileSize.x));
+	GLint right = static_cast<GLint>(std::floor((ball.Box.Position.x + ball.Box.Size.x) / this->TileSize.x));
+	GLint top = static_cast<GLint>(std::floor(ball.Box.Position.y / this->TileSize.y));
+	GLint bottom = static_cast<GLint>(std::floor((ball.Box.Position.y + ball.Box.Size.y) / this->TileSize.y));
+	left = std::max(left, 0);
+	top = std::max(top, 0);
+	right = std::min(right, static_cast<GLint>(this->Columns) - 1);
+	bottom = std::min(bottom, static_cast<GLint>(this->Rows) - 1);
+	for (GLint y = top; y <= bottom; ++y)
+	{
+		for (GLint x = left; x <= right; ++x)
+		{
+			GLuint index = y * this->Columns + x;
+			GLubyte tile = this->Bricks.Get(index);
+			if (tile == 0)
+				continue;
+			Transform box(glm::vec2(this->TileSize.x * x, this->TileSize.y * y), this->TileSize);
+			Collision collision = CheckCollision(ball.Box, ball.Radius, box);
+			if (!std::get<0>(collision))
+				continue;
+			if (tile != 1)
+			{
+				this->Bricks.Set(index, 0);
+				--this->BricksLeft;
+			}
+			BounceOffBox(ball.Box, ball.Motion.Value, ball.Radius, collision);
+		}
+	}
+}
@@ -0,0 +1,131 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "simulation_thread.h"
+
+#include <chrono>
+
+#include <GLFW/glfw3.h>
+
+#include "alloc_tracker.h"
+
+
+namespace
+{
+	// How long a paused simulation sleeps between looking for input
+	const std::chrono::milliseconds PAUSE_POLL(5);
+	// Largest stretch of time caught up after a stall, as in the single-threaded loop
+	const GLdouble MAX_CATCH_UP = 0.25;
+}
+
+
+SimulationThread::SimulationThread()
+	: running(false), paused(false), ticks(0), game(nullptr), input(nullptr), recording(nullptr), autopilot(nullptr),
+	  checkAllocations(GL_FALSE), allocationWarmup(0)
+{
+
+}
+
+SimulationThread::~SimulationThread()
+{
+	this->Stop();
+}
+
+void SimulationThread::Start(Game &game, InputQueue &input, InputRecording *recording, Autopilot *autopilot)
+{
+	this->Stop();
+	this->game = &game;
+	this->input = &input;
+	this->recording = recording;
+	this->autopilot = autopilot;
+	// The render thread has something to draw from its first frame on
+	game.Snapshot(this->Snapshots.Back());
+	this->Snapshots.Back().Time = glfwGetTime();
+	this->Snapshots.Publish();
+	this->running = true;
+	this->thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::ExpectNoAllocations(GLuint warmup)
+{
+	this->checkAllocations = GL_TRUE;
+	this->allocationWarmup = warmup;
+}
+
+void SimulationThread::Stop()
+{
+	if (!this->thread.joinable())
+		return;
+	this->running = false;
+	this->thread.join();
+}
+
+void SimulationThread::SetPaused(GLboolean paused)
+{
+	this->paused.store(paused != GL_FALSE, std::memory_order_relaxed);
+}
+
+GLuint64 SimulationThread::Ticks() const
+{
+	return this->ticks.load(std::memory_order_relaxed);
+}
+
+void SimulationThread::run()
+{
+	GLdouble last = glfwGetTime(), accumulator = 0.0;
+	while (this->running.load(std::memory_order_acquire))
+	{
+		GLdouble now = glfwGetTime();
+		if (this->paused.load(std::memory_order_relaxed))
+		{
+			while (this->game->ConsumeInput(*this->input, now) > 0)
+				;
+			last = now;
+			std::this_thread::sleep_for(PAUSE_POLL);
+			continue;
+		}
+		accumulator += now - last;
+		last = now;
+		if (accumulator > MAX_CATCH_UP)
+			accumulator = MAX_CATCH_UP;
+		// Wall clock time the next tick ends at: it runs with the input events stamped before then
+		GLdouble tickEnd = now - accumulator + TICK_DURATION;
+		GLuint batch = 0;
+		AllocTracker::ExpectNoAllocations(this->checkAllocations && this->Ticks() >= this->allocationWarmup);
+		AllocTracker::BeginFrame();
+		while (accumulator >= TICK_DURATION)
+		{
+			this->game->ConsumeInput(*this->input, tickEnd);
+			if (this->autopilot)
+				this->autopilot->Apply(*this->game);
+			if (this->recording)
+				this->recording->Capture(*this->game);
+			if (!this->game->ProcessRewind())
+			{
+				this->game->ProcessInput(TICK_DURATION);
+				this->game->Update(TICK_DURATION);
+			}
+			if (this->recording)
+				this->recording->Checkpoint(*this->game);
+			accumulator -= TICK_DURATION;
+			tickEnd += TICK_DURATION;
+			++batch;
+		}
+		if (batch > 0)
+		{
+			RenderSnapshot &snapshot = this->Snapshots.Back();
+			this->game->Snapshot(snapshot);
+			snapshot.Time = now - accumulator;
+			this->Snapshots.Publish();
+			this->ticks.fetch_add(batch, std::memory_order_relaxed);
+		}
+		AllocTracker::EndFrame();
+		// Sleep until the next tick is due
+		std::this_thread::sleep_for(std::chrono::duration<GLdouble>(TICK_DURATION - accumulator));
+	}
+}
@@ -7,24 +7,25 @@
 ** option) any later version.
 ******************************************************************/
 #include "sprite_renderer.h"
+#include "render_stats.h"
 //#include "GLFW\glfw3.h"
 
 SpriteRenderer::SpriteRenderer(Shader &shader)
+	: shader(&shader)
 {
-	this->shader = shader;
 	this->initRenderData();
 }
 
-SpriteRenderer::~SpriteRenderer()
+void SpriteRenderer::SetProjection(const glm::mat4 &projection)
 {
-	glDeleteVertexArrays(1, &this->quadVAO);
+	this->shader->SetMatrix4("projection", projection, GL_TRUE);
 }
 
 // DrawSprite(ResourceManager::GetTexture("face"), glm::vec2(200, 200), glm::vec2(300, 400), 45.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-void SpriteRenderer::DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size, GLfloat rotate, glm::vec3 color)
+void SpriteRenderer::DrawSprite(TextureView texture, glm::vec2 position, glm::vec2 size, GLfloat rotate, glm::vec3 color)
 {
 	// Prepare transformations
-	this->shader.Use();
+	this->shader->Use();
 	glm::mat4 model;
 	model = glm::translate(model, glm::vec3(position, 0.0f));  // First translate (transformations are: scale happens first, then rotation and then finall translation happens; reversed order)
 
@@ -39,16 +40,17 @@ void SpriteRenderer::DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec
 
 	model = glm::scale(model, glm::vec3(size, 1.0f)); // Last scale
 
-	this->shader.SetMatrix4("model", model);
+	this->shader->SetMatrix4("model", model);
 
 	// Render textured quad
-	this->shader.SetVector3f("spriteColor", color);
+	this->shader->SetVector3f("spriteColor", color);
 
 	glActiveTexture(GL_TEXTURE0);
 	texture.Bind();
 
-	glBindVertexArray(this->quadVAO);
+	glBindVertexArray(this->quadVAO.ID());
 	glDrawArrays(GL_TRIANGLES, 0, 6);
+	RenderStats::Draw(6);
 	glBindVertexArray(0);
 }
 
@@ -57,7 +59,6 @@ void SpriteRenderer::DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec
 void SpriteRenderer::initRenderData()
 {
 	// Configure VAO/VBO
-	GLuint VBO;
 	GLfloat vertices[] = {
 		// Pos      // Tex
 		0.0f, 1.0f, 0.0f, 1.0f,
@@ -69,13 +70,10 @@ void SpriteRenderer::initRenderData()
 		1.0f, 0.0f, 1.0f, 0.0f
 	};
 
-	glGenVertexArrays(1, &this->quadVAO);
-	glGenBuffers(1, &VBO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO.Get());
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-	glBindVertexArray(this->quadVAO);
+	glBindVertexArray(this->quadVAO.Get());
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -0,0 +1,150 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "streaming_level.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+StreamingLevel::StreamingLevel()
+	: Columns(0), Capacity(0), Width(0.0f), Height(0.0f), TileWidth(0.0f), TileHeight(0.0f), StartHeight(0.0f), ScrollSpeed(0.0f),
+	  sourceRows(0), first(0), end(0), firstTop(0.0f)
+{
+
+}
+
+GLboolean StreamingLevel::Init(const LevelSpec &spec, GLuint width, GLuint height, GLfloat startHeight, GLfloat scrollSpeed)
+{
+	if (!LevelGenerator::Validate(spec))
+		return GL_FALSE;
+	this->spec = spec;
+	this->source.clear();
+	this->sourceRows = 0;
+	// Bricks twice as wide as they are high
+	this->layout(spec.Columns, width, height, width / static_cast<GLfloat>(spec.Columns) * 0.5f, startHeight, scrollSpeed);
+	return GL_TRUE;
+}
+
+GLboolean StreamingLevel::Init(const GameLevel &level, GLuint width, GLuint height, GLfloat startHeight, GLfloat scrollSpeed)
+{
+	if (level.Rows == 0)
+		return GL_FALSE;
+	this->source = level.Tiles;
+	this->sourceRows = level.Rows;
+	this->layout(level.Columns, width, height, level.Height / static_cast<GLfloat>(level.Rows), startHeight, scrollSpeed);
+	return GL_TRUE;
+}
+
+void StreamingLevel::Reset()
+{
+	this->first = this->end = 0;
+	this->firstTop = this->StartHeight - this->TileHeight;
+	this->fill();
+}
+
+GLboolean StreamingLevel::Advance(GLfloat dt)
+{
+	if (this->Capacity == 0 || this->ScrollSpeed == 0.0f)
+		return GL_FALSE;
+	this->firstTop += this->ScrollSpeed * dt;
+	// Rows that left the playfield give up their slots
+	while (this->firstTop >= this->Height)
+	{
+		++this->first;
+		this->firstTop -= this->TileHeight;
+	}
+	this->end = std::max(this->end, this->first);
+	this->fill();
+	return GL_TRUE;
+}
+
+void StreamingLevel::RowsIn(GLfloat top, GLfloat bottom, GLuint64 &begin, GLuint64 &end) const
+{
+	begin = end = this->first;
+	if (this->TileHeight <= 0.0f)
+		return;
+	// Rows are stacked upwards from row first, so the span maps to a range of offsets from it
+	GLfloat lowest = std::ceil((this->firstTop - bottom) / this->TileHeight);
+	GLfloat highest = std::floor((this->firstTop + this->TileHeight - top) / this->TileHeight);
+	GLfloat resident = static_cast<GLfloat>(this->end - this->first);
+	lowest = std::max(lowest, 0.0f);
+	highest = std::min(highest + 1.0f, resident);
+	if (highest > lowest)
+	{
+		begin = this->first + static_cast<GLuint64>(lowest);
+		end = this->first + static_cast<GLuint64>(highest);
+	}
+}
+
+GLboolean StreamingLevel::Overrun(GLfloat y) const
+{
+	GLuint64 begin, end;
+	this->RowsIn(y, this->Height, begin, end);
+	for (GLuint64 row = begin; row < end; ++row)
+		for (GLuint x = 0; x < this->Columns; ++x)
+			if (this->Tile(row, x) > 1)
+				return GL_TRUE;
+	return GL_FALSE;
+}
+
+void StreamingLevel::SaveState(StateWriter &writer) const
+{
+	writer.Write(this->tiles);
+	writer.Write(this->first);
+	writer.Write(this->end);
+	writer.Write(this->firstTop);
+}
+
+GLboolean StreamingLevel::LoadState(StateReader &reader)
+{
+	reader.Read(this->tiles);
+	reader.Read(this->first);
+	reader.Read(this->end);
+	reader.Read(this->firstTop);
+	return !reader.Failed();
+}
+
+void StreamingLevel::layout(GLuint columns, GLuint width, GLuint height, GLfloat tileHeight, GLfloat startHeight, GLfloat scrollSpeed)
+{
+	this->Columns = columns;
+	this->Width = static_cast<GLfloat>(width);
+	this->Height = static_cast<GLfloat>(height);
+	this->TileWidth = this->Width / columns;
+	this->TileHeight = tileHeight;
+	this->StartHeight = std::min(startHeight, this->Height);
+	this->ScrollSpeed = scrollSpeed;
+	// Enough rows to cover the playfield, the ones ready above it and one partly scrolled in at either edge
+	this->Capacity = static_cast<GLuint>(std::ceil(this->Height / tileHeight)) + AHEAD_ROWS + 2;
+	this->tiles.assign(static_cast<size_t>(this->Capacity) * columns, 0);
+	this->Reset();
+}
+
+void StreamingLevel::streamIn()
+{
+	GLuint *row = &this->tiles[(this->end % this->Capacity) * this->Columns];
+	if (!this->source.empty())
+	{
+		// The level's bottom row comes in first, so it shows up the right way round
+		GLuint y = this->sourceRows - 1 - static_cast<GLuint>(this->end % this->sourceRows);
+		std::copy(this->source.begin() + static_cast<size_t>(y) * this->Columns, this->source.begin() + static_cast<size_t>(y + 1) * this->Columns, row);
+	}
+	else
+	{
+		LevelSpec block = this->spec;
+		block.Seed = this->spec.Seed + this->end / this->spec.Rows;
+		LevelGenerator::GenerateRow(block, this->spec.Rows - 1 - static_cast<GLuint>(this->end % this->spec.Rows), row);
+	}
+	++this->end;
+}
+
+void StreamingLevel::fill()
+{
+	while (this->end - this->first < this->Capacity && this->RowTop(this->end) + this->TileHeight > -(AHEAD_ROWS * this->TileHeight))
+		this->streamIn();
+}
@@ -14,7 +14,7 @@
 Texture2D::Texture2D()
 	: Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
 {
-	glGenTextures(1, &this->ID);
+
 }
 
 void Texture2D::Generate(GLuint width, GLuint height, unsigned char* data)
@@ -22,7 +22,7 @@ void Texture2D::Generate(GLuint width, GLuint height, unsigned char* data)
 	this->Width = width;
 	this->Height = height;
 	// Create Texture
-	glBindTexture(GL_TEXTURE_2D, this->ID);
+	glBindTexture(GL_TEXTURE_2D, this->Object.Get());
 	glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
 	// Set Texture wrap and filter modes
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
@@ -35,5 +35,5 @@ void Texture2D::Generate(GLuint width, GLuint height, unsigned char* data)
 
 void Texture2D::Bind() const
 {
-	glBindTexture(GL_TEXTURE_2D, this->ID);
+	glBindTexture(GL_TEXTURE_2D, this->Object.ID());
 }
\ No newline at end of file
@@ -0,0 +1,302 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Golden-image regression test of the renderer. Renders a fixed game
+// state of every level (ball launched and particles emitted from a
+// seeded run) into an offscreen framebuffer, compares the frames with
+// the reference PNGs in golden/ and times the same scenes:
+//
+//   littleGame_golden [filter] [--bless] [--dir <game dir>] [--frames N]
+//                     [--threshold T] [--tolerance F] [--out <dir>] [--json <file>]
+//
+// A pixel differs if any channel is off by more than T (default 8); a
+// scene fails if more than a fraction F (default 0.001) of its pixels
+// differ, in which case the actual frame and a difference image are
+// written to --out. --bless replaces the references with the current
+// output. Live GL object counts have to return to the same numbers
+// after every scene, so leaked textures, buffers or VAOs fail as well. Works on Mesa's software rasterizer, which is what the stored
+// references were rendered with. Exits with 1 if any scene failed.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#define chdir _chdir
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#endif
+
+#include "root_directory.h"
+#include "game.h"
+#include "offscreen_context.h"
+#include "png_image.h"
+#include "random.h"
+#include "render_stats.h"
+#include "render_target.h"
+#include "resource_manager.h"
+#include "sprite_renderer.h"
+
+
+const GLuint WIDTH = 800, HEIGHT = 600;
+// Seed of the first scene; scene i uses SEED + i
+const GLuint64 SEED = 20240601;
+
+struct GoldenSettings {
+	GLuint      Frames, Threshold;
+	GLboolean   Bless;
+	double      Tolerance;
+	std::string OutDirectory;
+};
+
+struct SceneResult {
+	std::string Name;
+	GLboolean   Passed;
+	GLuint      DifferentPixels, MaxDelta;
+	double      MeanMs, P95Ms;
+	GLuint      DrawCalls;
+};
+
+// Brings a game into the fixed state of a scene: level loaded, paddle
+// steered a seeded distance, ball launched and flying with its trail
+void setupScene(Game &game, GLuint level, GLuint64 seed)
+{
+	Random random(seed);
+	game.Level = level;
+	game.ResetLevel();
+	game.ResetPlayer();
+	GLuint steer = static_cast<GLuint>(random.Next() % 60);
+	GLuint key = random.Next() % 2 ? GLFW_KEY_A : GLFW_KEY_D;
+	for (GLuint tick = 0; tick < steer; ++tick)
+	{
+		game.Keys[key] = GL_TRUE;
+		game.ProcessInput(TICK_DURATION);
+		game.Update(TICK_DURATION);
+	}
+	game.Keys[key] = GL_FALSE;
+	game.Keys[GLFW_KEY_SPACE] = GL_TRUE;
+	GLuint flight = 30 + static_cast<GLuint>(random.Next() % 30);
+	for (GLuint tick = 0; tick < flight; ++tick)
+	{
+		game.ProcessInput(TICK_DURATION);
+		game.Update(TICK_DURATION);
+	}
+	game.Keys[GLFW_KEY_SPACE] = GL_FALSE;
+}
+
+// Reads the target back as RGB rows, top row first (as stored in PNGs)
+void capture(const RenderTarget &target, std::vector<unsigned char> &rgb)
+{
+	std::vector<unsigned char> rgba;
+	target.ReadPixels(rgba);
+	rgb.resize(target.Width * target.Height * 3);
+	for (GLuint y = 0; y < target.Height; ++y)
+	{
+		const unsigned char *row = &rgba[(target.Height - 1 - y) * target.Width * 4];
+		for (GLuint x = 0; x < target.Width; ++x)
+			for (GLuint c = 0; c < 3; ++c)
+				rgb[(y * target.Width + x) * 3 + c] = row[x * 4 + c];
+	}
+}
+
+// Renders one scene, times it and compares (or blesses) its frame
+SceneResult renderScene(const std::string &name, GLuint level, RenderTarget &target, Shader &spriteShader, const GoldenSettings &settings)
+{
+	Game game(WIDTH, HEIGHT);
+	game.Seed = SEED + level;
+	game.Init(GL_TRUE);
+	game.Renderer = new SpriteRenderer(spriteShader);
+	setupScene(game, level, game.Seed);
+
+	SceneResult result;
+	result.Name = name;
+	result.Passed = GL_TRUE;
+	result.DifferentPixels = result.MaxDelta = 0;
+	// Timing: the frame is redrawn unchanged, the first (uncounted) run warms up the driver
+	std::vector<double> times;
+	for (GLuint frame = 0; frame <= settings.Frames; ++frame)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		target.Bind();
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		RenderStats::Reset();
+		game.Render();
+		glFinish();
+		if (frame > 0)
+			times.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+	result.DrawCalls = RenderStats::DrawCalls;
+	double sum = 0.0;
+	for (double ms : times)
+		sum += ms;
+	std::sort(times.begin(), times.end());
+	result.MeanMs = sum / times.size();
+	result.P95Ms = times[std::min(times.size() - 1, static_cast<size_t>(times.size() * 0.95))];
+
+	// Comparison against the reference
+	std::vector<unsigned char> actual;
+	capture(target, actual);
+	std::string reference = "golden/" + name + ".png";
+	std::string status = "ok";
+	if (settings.Bless)
+	{
+		status = "blessed";
+		if (!PngImage::Write(reference, WIDTH, HEIGHT, 3, actual))
+		{
+			status = "ERROR";
+			result.Passed = GL_FALSE;
+		}
+	}
+	else
+	{
+		std::vector<unsigned char> expected;
+		GLuint width = 0, height = 0;
+		if (!PngImage::Read(reference, width, height, 3, expected) || width != WIDTH || height != HEIGHT)
+		{
+			status = "MISSING";
+			result.Passed = GL_FALSE;
+		}
+		else
+		{
+			std::vector<unsigned char> diff(actual.size(), 0);
+			for (GLuint p = 0; p < WIDTH * HEIGHT; ++p)
+			{
+				GLuint delta = 0;
+				for (GLuint c = 0; c < 3; ++c)
+					delta = std::max(delta, static_cast<GLuint>(std::abs(actual[p * 3 + c] - expected[p * 3 + c])));
+				result.MaxDelta = std::max(result.MaxDelta, delta);
+				if (delta > settings.Threshold)
+				{
+					++result.DifferentPixels;
+					diff[p * 3] = 255;
+				}
+				else
+					diff[p * 3 + 1] = diff[p * 3 + 2] = static_cast<unsigned char>(std::min(255u, delta * 16));
+			}
+			if (result.DifferentPixels > settings.Tolerance * WIDTH * HEIGHT)
+			{
+				status = "FAILED";
+				result.Passed = GL_FALSE;
+				PngImage::Write(settings.OutDirectory + "/" + name + ".actual.png", WIDTH, HEIGHT, 3, actual);
+				PngImage::Write(settings.OutDirectory + "/" + name + ".diff.png", WIDTH, HEIGHT, 3, diff);
+			}
+		}
+	}
+	std::cout << std::left << std::setw(16) << name << std::setw(10) << status << std::right << std::setw(12) << result.DifferentPixels
+		<< std::setw(10) << result.MaxDelta << std::fixed << std::setprecision(2) << std::setw(11) << result.MeanMs
+		<< std::setw(11) << result.P95Ms << std::setw(8) << result.DrawCalls << std::endl;
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	std::string directory = std::string(logl_root) + "/src/MyLittleGame1";
+	std::string filter = "", jsonFile = "";
+	GoldenSettings settings;
+	settings.Frames = 20;
+	settings.Threshold = 8;
+	settings.Bless = GL_FALSE;
+	settings.Tolerance = 0.001;
+	settings.OutDirectory = ".";
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--bless") == 0)
+			settings.Bless = GL_TRUE;
+		else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+			directory = argv[++i];
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			settings.Frames = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+			settings.Threshold = static_cast<GLuint>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+			settings.Tolerance = std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			settings.OutDirectory = argv[++i];
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonFile = argv[++i];
+		else
+			filter = argv[i];
+	}
+	// Output paths stay relative to the caller's working directory
+	char cwd[4096];
+	if (getcwd(cwd, sizeof(cwd)))
+	{
+		if (settings.OutDirectory[0] != '/')
+			settings.OutDirectory = std::string(cwd) + "/" + settings.OutDirectory;
+		if (!jsonFile.empty() && jsonFile[0] != '/')
+			jsonFile = std::string(cwd) + "/" + jsonFile;
+	}
+	// Levels, shaders and textures are loaded relative to the game directory
+	if (chdir(directory.c_str()) != 0)
+	{
+		std::cout << "ERROR::GOLDEN: Game directory " << directory << " not found" << std::endl;
+		return 2;
+	}
+
+	OffscreenContext context;
+	if (!context.Create(WIDTH, HEIGHT))
+		return 2;
+	RenderTarget target;
+	if (!target.Generate(WIDTH, HEIGHT))
+		return 2;
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	std::cout << "renderer: " << context.Renderer() << (settings.Bless ? ", blessing references" : "") << std::endl;
+
+	// The first game loads the shared resources, every scene then gets a fresh game so scenes do not depend on each other
+	Game loader(WIDTH, HEIGHT);
+	loader.LoadResources("shaders/");
+	Shader &spriteShader = ResourceManager::GetShader("sprite");
+	// GL objects alive before any scene; every scene must give back what it created
+	const GLint liveObjects[3] = { GLTexture::Live(), GLBuffer::Live(), GLVertexArray::Live() };
+	const char *levels[] = { "one", "two", "three", "four" };
+	std::vector<SceneResult> results;
+	GLboolean failed = GL_FALSE;
+	std::cout << std::left << std::setw(16) << "scene" << std::setw(10) << "result" << std::right << std::setw(12) << "diff px"
+		<< std::setw(10) << "max diff" << std::setw(11) << "mean(ms)" << std::setw(11) << "p95(ms)" << std::setw(8) << "draws" << std::endl;
+	for (GLuint i = 0; i < 4; ++i)
+	{
+		std::string name = std::string("level_") + levels[i];
+		if (name.find(filter) == std::string::npos)
+			continue;
+		SceneResult result = renderScene(name, i, target, spriteShader, settings);
+		GLint leaked[3] = { GLTexture::Live() - liveObjects[0], GLBuffer::Live() - liveObjects[1], GLVertexArray::Live() - liveObjects[2] };
+		if (leaked[0] || leaked[1] || leaked[2])
+		{
+			std::cout << "ERROR::GOLDEN: " << name << " leaked " << leaked[0] << " textures, " << leaked[1] << " buffers, " << leaked[2] << " vertex arrays" << std::endl;
+			result.Passed = GL_FALSE;
+		}
+		failed = failed || !result.Passed;
+		results.push_back(result);
+	}
+	if (failed)
+		std::cout << "Mismatching frames were written to " << settings.OutDirectory << "; if the change is intended, rerun with --bless" << std::endl;
+
+	if (!jsonFile.empty())
+	{
+		std::ofstream out(jsonFile.c_str());
+		out << std::fixed << std::setprecision(4) << "{\n  \"renderer\": \"" << context.Renderer() << "\",\n  \"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+			out << "    {\"name\": \"" << results[i].Name << "\", \"passed\": " << (results[i].Passed ? "true" : "false")
+				<< ", \"different_pixels\": " << results[i].DifferentPixels << ", \"max_delta\": " << results[i].MaxDelta
+				<< ", \"mean_ms\": " << results[i].MeanMs << ", \"p95_ms\": " << results[i].P95Ms
+				<< ", \"draw_calls\": " << results[i].DrawCalls << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+		out << "  ]\n}\n";
+	}
+	target.Destroy();
+	ResourceManager::Clear();
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Writes procedurally generated levels as .lvl files. Either a single
+// level from the given parameters, or with --dataset every level of the
+// standard benchmark dataset (LevelGenerator::Dataset) into a directory,
+// named after the dataset entries:
+//
+//   littleGame_level_gen [--pattern noise|maze|walls] [--size CxR] [--density F]
+//                        [--solid F] [--seed N] [--threads N] <file.lvl>
+//   littleGame_level_gen --dataset <directory> [--max-tiles N] [--threads N]
+//
+// Sizes range from 16x16 to 4096x4096. The same parameters always give
+// the same level, on any number of threads.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "game_level.h"
+#include "job_system.h"
+#include "level_generator.h"
+
+
+// Generates spec and writes it to file; returns false on failure
+GLboolean writeLevel(const LevelSpec &spec, const std::string &file)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point start = Clock::now();
+	GameLevel level;
+	if (!LevelGenerator::Generate(spec, level, 800, 300))
+		return GL_FALSE;
+	GLdouble generated = std::chrono::duration<GLdouble, std::milli>(Clock::now() - start).count();
+	if (!level.Save(file.c_str()))
+		return GL_FALSE;
+	GLuint bricks = 0, solid = 0;
+	for (GLuint tile : level.Tiles)
+	{
+		bricks += tile != 0;
+		solid += tile == 1;
+	}
+	std::cout << file << ": " << LevelGenerator::PatternName(spec.Pattern) << " " << spec.Columns << "x" << spec.Rows
+		<< ", " << bricks << " bricks (" << solid << " solid), generated in " << generated << " ms" << std::endl;
+	return GL_TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+	LevelSpec spec;
+	const char *output = nullptr, *dataset = nullptr;
+	GLuint threads = 0;
+	GLuint64 maxTiles = static_cast<GLuint64>(LevelGenerator::MAX_SIZE) * LevelGenerator::MAX_SIZE;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--pattern") == 0 && i + 1 < argc)
+		{
+			if (!LevelGenerator::ParsePattern(argv[++i], spec.Pattern))
+			{
+				std::cout << "ERROR::LEVEL_GEN: Unknown pattern " << argv[i] << std::endl;
+				return 2;
+			}
+		}
+		else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+		{
+			if (std::sscanf(argv[++i], "%ux%u", &spec.Columns, &spec.Rows) != 2)
+			{
+				std::cout << "ERROR::LEVEL_GEN: Size " << argv[i] << " is not of the form CxR" << std::endl;
+				return 2;
+			}
+		}
+		else if (std::strcmp(argv[i], "--density") == 0 && i + 1 < argc)
+			spec.Density = static_cast<GLfloat>(std::atof(argv[++i]));
+		else if (std::strcmp(argv[i], "--solid") == 0 && i + 1 < argc)
+			spec.SolidRatio = static_cast<GLfloat>(std::atof(argv[++i]));
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			spec.Seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = static_cast<GLuint>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--dataset") == 0 && i + 1 < argc)
+			dataset = argv[++i];
+		else if (std::strcmp(argv[i], "--max-tiles") == 0 && i + 1 < argc)
+			maxTiles = std::strtoull(argv[++i], nullptr, 10);
+		else
+			output = argv[i];
+	}
+	if (!output && !dataset)
+	{
+		std::cout << "usage: littleGame_level_gen [--pattern noise|maze|walls] [--size CxR] [--density F] [--solid F] [--seed N] <file.lvl>" << std::endl
+			<< "       littleGame_level_gen --dataset <directory> [--max-tiles N]" << std::endl;
+		return 2;
+	}
+
+	JobSystem::Init(threads);
+	GLboolean ok = GL_TRUE;
+	if (dataset)
+	{
+		for (const DatasetLevel &level : LevelGenerator::Dataset())
+			if (level.Spec.Tiles() <= maxTiles)
+				ok = writeLevel(level.Spec, std::string(dataset) + "/" + level.Name + ".lvl") && ok;
+	}
+	else
+		ok = writeLevel(spec, output);
+	JobSystem::Shutdown();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Replays a session recorded with `littleGame --record <file>` as fast as
+// the CPU allows: a headless Game (no window, no rendering) is fed the
+// recorded input tick by tick. Reports the state checksum of every tick
+// (optionally written to a file), verifies the checksums stored in the
+// recording and times the run, so both desyncs and performance
+// regressions show up. Run it from the game directory so the levels are
+// found. Exits with 1 if the replay diverged from the recording.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "game.h"
+#include "input_recording.h"
+#include "job_system.h"
+
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << "usage: littleGame_replay <recording> [--threads N] [--checksums <file>]" << std::endl;
+		return 2;
+	}
+	GLuint threads = 0;
+	const char *checksumFile = nullptr;
+	for (int i = 2; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--threads") == 0)
+			threads = static_cast<GLuint>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--checksums") == 0)
+			checksumFile = argv[++i];
+	}
+	InputRecording recording;
+	if (!recording.Load(argv[1]))
+		return 2;
+	std::ofstream checksums;
+	if (checksumFile)
+		checksums.open(checksumFile);
+
+	JobSystem::Init(threads);
+	Game game(recording.Width, recording.Height);
+	game.Seed = recording.Seed;
+	game.Init(GL_TRUE);
+
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::duration simulation = Clock::duration::zero();
+	Clock::time_point start = Clock::now();
+	GLuint tick = 0, verified = 0, desyncTick = 0;
+	GLuint64 checksum = game.Checksum();
+	while (true)
+	{
+		Clock::time_point tickStart = Clock::now();
+		if (!recording.Apply(game))
+			break;
+		game.ProcessInput(TICK_DURATION);
+		game.Update(TICK_DURATION);
+		simulation += Clock::now() - tickStart;
+		++tick;
+		checksum = game.Checksum();
+		if (checksums.is_open())
+			checksums << tick << ' ' << std::hex << std::setw(16) << std::setfill('0') << checksum << std::dec << '\n';
+		GLuint64 expected = recording.ChecksumAt(tick);
+		if (expected != 0)
+		{
+			if (expected == checksum)
+				++verified;
+			else if (desyncTick == 0)
+				desyncTick = tick;
+		}
+	}
+	double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	double simulationMs = std::chrono::duration<double, std::milli>(simulation).count();
+	JobSystem::Shutdown();
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "ticks:          " << tick << " (" << tick * TICK_DURATION << " s of play)" << std::endl;
+	std::cout << "total:          " << totalMs << " ms" << std::endl;
+	std::cout << "simulation:     " << simulationMs << " ms (" << (simulationMs > 0.0 ? tick / simulationMs * 1000.0 : 0.0) << " ticks/s)" << std::endl;
+	std::cout << "final checksum: " << std::hex << std::setw(16) << std::setfill('0') << checksum << std::dec << std::endl;
+	std::cout << "checkpoints:    " << verified << " of " << recording.Checksums.size() << " match" << std::endl;
+	if (desyncTick != 0)
+	{
+		std::cout << "DESYNC at tick " << desyncTick << " (first mismatching checkpoint)" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,272 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Headless soak test: runs the full simulation (ProcessInput, Update and
+// with it DoCollisions) for a number of ticks without a window, with the
+// Autopilot playing the paddle so rounds are rarely lost. It cycles through the four
+// shipped levels and the levels of the generated benchmark dataset
+// (LevelGenerator::Dataset) of at most --max-tiles tiles, then reports
+// p50, p95, p99 and max tick time, ticks per second and the peak
+// resident set size, overall and per level, and how many rounds the
+// autopilot lost. Run it from the game
+// directory so the levels are found:
+//
+//   littleGame_soak [--ticks N] [--balls N] [--seed N] [--threads N] [--json <file>]
+//                   [--alloc-check <warmup ticks>] [--alloc-sample N] [--metrics <file>]
+//                   [--max-tiles N] [--endless]
+//
+// --endless adds the endless mode as a last level, its rows scrolling
+// fast enough that many of them stream in and get recycled.
+//
+// In builds configured with LITTLEGAME_ALLOC_HOOKS it also counts heap
+// allocations per tick. --alloc-check reports every allocation made by
+// ProcessInput and Update past the first warmup ticks of each level with
+// a stack trace and fails the run if there were any; --alloc-sample
+// prints the most frequent call sites of one in N allocations. --metrics
+// exports the game's metrics to a JSON-lines file once per second.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "alloc_tracker.h"
+#include "autopilot.h"
+#include "game.h"
+#include "job_system.h"
+#include "level_generator.h"
+#include "metrics.h"
+
+
+// Tick times of one level, in nanoseconds
+struct LevelTimes {
+	std::string           Name;
+	std::vector<GLuint64> Ticks;
+	GLuint                Collisions;
+};
+
+// Peak resident set size of the process in bytes
+GLuint64 peakResidentBytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+	return static_cast<GLuint64>(usage.ru_maxrss);
+#else
+	return static_cast<GLuint64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+GLuint64 percentile(const std::vector<GLuint64> &sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+	size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void report(std::ostream &out, const std::string &name, std::vector<GLuint64> ticks, GLboolean json)
+{
+	std::sort(ticks.begin(), ticks.end());
+	GLuint64 total = 0;
+	for (GLuint64 tick : ticks)
+		total += tick;
+	double ticksPerSecond = total > 0 ? ticks.size() * 1.0e9 / total : 0.0;
+	if (json)
+		out << "{\"name\": \"" << name << "\", \"ticks\": " << ticks.size() << ", \"p50_us\": " << percentile(ticks, 0.50) / 1000.0
+			<< ", \"p95_us\": " << percentile(ticks, 0.95) / 1000.0 << ", \"p99_us\": " << percentile(ticks, 0.99) / 1000.0
+			<< ", \"max_us\": " << (ticks.empty() ? 0 : ticks.back()) / 1000.0 << ", \"ticks_per_second\": " << ticksPerSecond << "}";
+	else
+		out << std::left << std::setw(20) << name << std::right << std::setw(8) << ticks.size()
+			<< std::setw(12) << percentile(ticks, 0.50) / 1000.0 << std::setw(12) << percentile(ticks, 0.95) / 1000.0
+			<< std::setw(12) << percentile(ticks, 0.99) / 1000.0 << std::setw(12) << (ticks.empty() ? 0 : ticks.back()) / 1000.0
+			<< std::setw(14) << ticksPerSecond << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	GLuint totalTicks = 36000, extraBalls = 0, threads = 0, allocWarmup = 0, allocSample = 0;
+	GLboolean allocCheck = GL_FALSE, endless = GL_FALSE;
+	GLuint64 seed = 1, maxTiles = 16384;
+	const char *jsonFile = nullptr, *metricsFile = nullptr;
+	for (int i = 1; i < argc; ++i)
+		if (std::strcmp(argv[i], "--endless") == 0)
+			endless = GL_TRUE;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--ticks") == 0)
+			totalTicks = static_cast<GLuint>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--balls") == 0)
+			extraBalls = static_cast<GLuint>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--seed") == 0)
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (std::strcmp(argv[i], "--threads") == 0)
+			threads = static_cast<GLuint>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--json") == 0)
+			jsonFile = argv[++i];
+		else if (std::strcmp(argv[i], "--alloc-check") == 0)
+		{
+			allocCheck = GL_TRUE;
+			allocWarmup = static_cast<GLuint>(std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--alloc-sample") == 0)
+			allocSample = static_cast<GLuint>(std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--metrics") == 0)
+			metricsFile = argv[++i];
+		else if (std::strcmp(argv[i], "--max-tiles") == 0)
+			maxTiles = std::strtoull(argv[++i], nullptr, 10);
+	}
+	if ((allocCheck || allocSample > 0) && !AllocTracker::Enabled())
+		std::cout << "ERROR::SOAK: Allocation tracking needs a build with LITTLEGAME_ALLOC_HOOKS" << std::endl;
+	AllocTracker::SetSampleRate(allocSample);
+
+	JobSystem::Init(threads);
+	Game game(800, 600);
+	game.Seed = seed;
+	game.Init(GL_TRUE);
+	for (const GameLevel &level : game.Levels)
+	{
+		if (level.Tiles.empty())
+		{
+			std::cout << "ERROR::SOAK: Shipped levels not found, run from the game directory" << std::endl;
+			return 2;
+		}
+	}
+	std::vector<std::string> names = { "one", "two", "three", "four" };
+	// Every brick becomes an entity, so the largest dataset levels are left out by default
+	for (const DatasetLevel &dataset : LevelGenerator::Dataset())
+	{
+		if (dataset.Spec.Tiles() > maxTiles)
+			continue;
+		GameLevel level;
+		LevelGenerator::Generate(dataset.Spec, level, game.Width, game.Height / 2);
+		game.Levels.push_back(level);
+		names.push_back(dataset.Name);
+	}
+	// Stands in for the endless mode, which spawns no bricks from it
+	if (endless)
+	{
+		game.Levels.push_back(GameLevel());
+		names.push_back("endless");
+	}
+	LevelSpec endlessRows = ENDLESS_LEVEL;
+	endlessRows.Seed = seed;
+
+	if (metricsFile && !Metrics::StartExport(metricsFile, 1.0f))
+		return 2;
+
+	typedef std::chrono::high_resolution_clock Clock;
+	std::vector<LevelTimes> levels(game.Levels.size());
+	std::vector<GLuint64> all;
+	all.reserve(totalTicks);
+	// Heap traffic of the ticks themselves; level switches happen outside of them
+	GLuint64 tickAllocations = 0, tickBytes = 0, allocatingTicks = 0, maxTickAllocations = 0;
+	// Rounds lost, seen as the level being respawned within a tick
+	GLuint64 roundsLost = 0;
+	Autopilot autopilot;
+	GLuint ticksPerLevel = std::max(1u, totalTicks / static_cast<GLuint>(game.Levels.size()));
+	Clock::time_point start = Clock::now();
+	for (GLuint tick = 0; tick < totalTicks; ++tick)
+	{
+		GLuint level = std::min(tick / ticksPerLevel, static_cast<GLuint>(game.Levels.size()) - 1);
+		if (tick == level * ticksPerLevel)
+		{
+			game.Level = level;
+			if (endless && level + 1 == game.Levels.size())
+				game.PlayEndless(endlessRows, ENDLESS_SCROLL_SPEED * 10.0f);
+			else
+				game.ResetLevel();
+			game.ResetPlayer();
+			levels[level].Name = names[level];
+		}
+		// Start every serve with the requested number of extra balls
+		if (extraBalls > 0 && game.Entities.Count(COMPONENT_BALL) == 1)
+			game.SpawnBalls(extraBalls);
+		autopilot.Apply(game);
+		GLuint levelRevision = game.LevelRevision;
+		// Arrays grow to fit each newly loaded level, so every level gets its own warmup
+		AllocTracker::ExpectNoAllocations(allocCheck && tick - level * ticksPerLevel >= allocWarmup);
+		AllocTracker::BeginFrame();
+		Clock::time_point tickStart = Clock::now();
+		game.ProcessInput(TICK_DURATION);
+		game.Update(TICK_DURATION);
+		GLuint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - tickStart).count();
+		AllocationStats frame = AllocTracker::EndFrame();
+		roundsLost += game.LevelRevision != levelRevision ? 1 : 0;
+		tickAllocations += frame.Allocations;
+		tickBytes += frame.Bytes;
+		allocatingTicks += frame.Allocations > 0 ? 1 : 0;
+		maxTickAllocations = std::max(maxTickAllocations, frame.Allocations);
+		levels[level].Ticks.push_back(ns);
+		all.push_back(ns);
+		// Cleared levels start over so every level keeps being exercised
+		if (!game.Endless && game.Levels[level].IsCompleted(game.Entities))
+			game.ResetLevel();
+	}
+	double wallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	AllocTracker::ExpectNoAllocations(GL_FALSE);
+	Metrics::StopExport();
+	JobSystem::Shutdown();
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << std::left << std::setw(20) << "level" << std::right << std::setw(8) << "ticks" << std::setw(12) << "p50(us)"
+		<< std::setw(12) << "p95(us)" << std::setw(12) << "p99(us)" << std::setw(12) << "max(us)" << std::setw(14) << "ticks/s" << std::endl;
+	for (const LevelTimes &level : levels)
+		report(std::cout, level.Name, level.Ticks, GL_FALSE);
+	report(std::cout, "all", all, GL_FALSE);
+	std::cout << "wall time:     " << wallMs << " ms" << std::endl;
+	std::cout << "peak RSS:      " << peakResidentBytes() / (1024.0 * 1024.0) << " MiB" << std::endl;
+	std::cout << "rounds lost:   " << roundsLost << std::endl;
+	if (AllocTracker::Enabled())
+	{
+		std::cout << "allocations:   " << tickAllocations << " (" << tickBytes << " bytes) in " << allocatingTicks
+			<< " ticks, at most " << maxTickAllocations << " per tick" << std::endl;
+		AllocTracker::ReportCallSites();
+	}
+
+	if (jsonFile)
+	{
+		std::ofstream out(jsonFile);
+		out << std::fixed << std::setprecision(3) << "{\n  \"seed\": " << seed << ",\n  \"extra_balls\": " << extraBalls
+			<< ",\n  \"peak_rss_bytes\": " << peakResidentBytes() << ",\n  \"rounds_lost\": " << roundsLost << ",\n  \"tick_allocations\": " << tickAllocations
+			<< ",\n  \"tick_allocated_bytes\": " << tickBytes << ",\n  \"levels\": [\n";
+		for (const LevelTimes &level : levels)
+		{
+			out << "    ";
+			report(out, level.Name, level.Ticks, GL_TRUE);
+			out << ",\n";
+		}
+		out << "    ";
+		report(out, "all", all, GL_TRUE);
+		out << "\n  ]\n}\n";
+	}
+	if (allocCheck && AllocTracker::Violations() > 0)
+	{
+		std::cout << "ERROR::SOAK: " << AllocTracker::Violations() << " allocations after " << allocWarmup << " warmup ticks per level" << std::endl;
+		return 1;
+	}
+	return 0;
+}
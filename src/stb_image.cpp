@@ -1,2 +1,4 @@
 #define STB_IMAGE_IMPLEMENTATION
+// Textures are decoded on several threads at once (ResourceManager::LoadTextures)
+#define STBI_THREAD_LOCAL thread_local
 #include "stb_image.h"
\ No newline at end of file